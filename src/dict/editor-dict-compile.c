@@ -0,0 +1,330 @@
+/* editor-dict-compile.c
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include <locale.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "editor-dict-private.h"
+
+/*
+ * Compiles a word list into a dictionary for EditorDictSpellProvider.
+ *
+ * The input has one word per line. Hunspell .dic files are accepted too
+ * if their .aff file is next to them. The leading word count is dropped
+ * along with the affix flags, and stems which are not words on their
+ * own (FORBIDDENWORD, NEEDAFFIX and ONLYINCOMPOUND) are left out so that
+ * they are still rejected by Enchant. Affixed forms are not expanded,
+ * lookups which miss the dictionary are still checked by Enchant.
+ */
+
+typedef enum
+{
+  FLAG_CHAR,
+  FLAG_LONG,
+  FLAG_NUM,
+  FLAG_UTF8,
+} FlagType;
+
+typedef struct
+{
+  FlagType   flag_type;
+  char      *encoding;
+  GArray    *rejected;
+  GPtrArray *aliases;
+} Affixes;
+
+static void
+affixes_clear (Affixes *affixes)
+{
+  g_clear_pointer (&affixes->encoding, g_free);
+  g_clear_pointer (&affixes->rejected, g_array_unref);
+  g_clear_pointer (&affixes->aliases, g_ptr_array_unref);
+}
+
+static gboolean
+is_count_line (const char *line)
+{
+  if (*line == 0)
+    return FALSE;
+
+  for (; *line; line++)
+    {
+      if (!g_ascii_isdigit (*line))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+parse_flags (FlagType    flag_type,
+             const char *str,
+             GArray     *flags)
+{
+  guint32 flag;
+
+  switch (flag_type)
+    {
+    case FLAG_LONG:
+      for (; str[0] && str[1]; str += 2)
+        {
+          flag = ((guint8)str[0] << 8) | (guint8)str[1];
+          g_array_append_val (flags, flag);
+        }
+      break;
+
+    case FLAG_NUM:
+      while (*str)
+        {
+          char *end;
+
+          flag = g_ascii_strtoull (str, &end, 10);
+          if (end == str)
+            break;
+          g_array_append_val (flags, flag);
+          str = *end == ',' ? end + 1 : end;
+        }
+      break;
+
+    case FLAG_UTF8:
+      if (!g_utf8_validate (str, -1, NULL))
+        break;
+      for (; *str; str = g_utf8_next_char (str))
+        {
+          flag = g_utf8_get_char (str);
+          g_array_append_val (flags, flag);
+        }
+      break;
+
+    case FLAG_CHAR:
+    default:
+      for (; *str; str++)
+        {
+          flag = (guint8)*str;
+          g_array_append_val (flags, flag);
+        }
+      break;
+    }
+}
+
+static gboolean
+load_affixes (const char  *path,
+              Affixes     *affixes,
+              GError     **error)
+{
+  g_autofree char *contents = NULL;
+  g_auto(GStrv) lines = NULL;
+  g_autoptr(GPtrArray) rejected = NULL;
+
+  affixes->flag_type = FLAG_CHAR;
+  affixes->rejected = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+  if (!g_file_get_contents (path, &contents, NULL, error))
+    return FALSE;
+
+  rejected = g_ptr_array_new_with_free_func (g_free);
+  lines = g_strsplit (contents, "\n", -1);
+
+  for (guint i = 0; lines[i]; i++)
+    {
+      g_auto(GStrv) fields = NULL;
+
+      g_strstrip (lines[i]);
+      fields = g_strsplit_set (lines[i], " \t", -1);
+
+      if (fields[0] == NULL || fields[1] == NULL)
+        continue;
+
+      if (g_str_equal (fields[0], "SET"))
+        {
+          g_free (affixes->encoding);
+          affixes->encoding = g_strdup (fields[1]);
+        }
+      else if (g_str_equal (fields[0], "FLAG") && g_str_equal (fields[1], "long"))
+        affixes->flag_type = FLAG_LONG;
+      else if (g_str_equal (fields[0], "FLAG") && g_str_equal (fields[1], "num"))
+        affixes->flag_type = FLAG_NUM;
+      else if (g_str_equal (fields[0], "FLAG") && g_str_equal (fields[1], "UTF-8"))
+        affixes->flag_type = FLAG_UTF8;
+      else if (g_str_equal (fields[0], "FORBIDDENWORD") ||
+               g_str_equal (fields[0], "NEEDAFFIX") ||
+               g_str_equal (fields[0], "PSEUDOROOT") ||
+               g_str_equal (fields[0], "ONLYINCOMPOUND"))
+        g_ptr_array_add (rejected, g_strdup (fields[1]));
+      else if (g_str_equal (fields[0], "AF") && !is_count_line (fields[1]))
+        {
+          /* Aliased flag sets, referenced by their 1-based index */
+          if (affixes->aliases == NULL)
+            affixes->aliases = g_ptr_array_new_with_free_func (g_free);
+          g_ptr_array_add (affixes->aliases, g_strdup (fields[1]));
+        }
+    }
+
+  /* The flag type may be declared after the flags */
+  for (guint i = 0; i < rejected->len; i++)
+    parse_flags (affixes->flag_type, g_ptr_array_index (rejected, i), affixes->rejected);
+
+  return TRUE;
+}
+
+static gboolean
+is_rejected (const Affixes *affixes,
+             const char    *flags_str,
+             GArray        *flags)
+{
+  if (affixes->rejected == NULL || affixes->rejected->len == 0)
+    return FALSE;
+
+  if (affixes->aliases != NULL)
+    {
+      guint64 index = g_ascii_strtoull (flags_str, NULL, 10);
+
+      if (index == 0 || index > affixes->aliases->len)
+        return FALSE;
+
+      flags_str = g_ptr_array_index (affixes->aliases, index - 1);
+    }
+
+  g_array_set_size (flags, 0);
+  parse_flags (affixes->flag_type, flags_str, flags);
+
+  for (guint i = 0; i < flags->len; i++)
+    {
+      for (guint j = 0; j < affixes->rejected->len; j++)
+        {
+          if (g_array_index (flags, guint32, i) == g_array_index (affixes->rejected, guint32, j))
+            return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_autoptr(GPtrArray) words = NULL;
+  g_autoptr(GArray) flags = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  g_autofree char *contents = NULL;
+  g_autofree char *aff_path = NULL;
+  g_auto(GStrv) lines = NULL;
+  Affixes affixes = {0};
+  gboolean has_affixes = FALSE;
+  int ret = EXIT_FAILURE;
+
+  setlocale (LC_ALL, "");
+
+  if (argc != 3)
+    {
+      g_printerr ("usage: %s INPUT OUTPUT\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  if (!g_file_get_contents (argv[1], &contents, NULL, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  if (g_str_has_suffix (argv[1], ".dic"))
+    {
+      aff_path = g_strdup (argv[1]);
+      memcpy (aff_path + strlen (aff_path) - 3, "aff", 3);
+
+      if (!(has_affixes = load_affixes (aff_path, &affixes, &error)))
+        {
+          g_printerr ("%s\n", error->message);
+          goto cleanup;
+        }
+    }
+
+  if (affixes.encoding != NULL && g_ascii_strcasecmp (affixes.encoding, "UTF-8") != 0)
+    {
+      char *converted;
+
+      if (!(converted = g_convert (contents, -1, "UTF-8", affixes.encoding, NULL, NULL, &error)))
+        {
+          g_printerr ("%s: %s\n", argv[1], error->message);
+          goto cleanup;
+        }
+
+      g_free (contents);
+      contents = converted;
+    }
+
+  words = g_ptr_array_new ();
+  flags = g_array_new (FALSE, FALSE, sizeof (guint32));
+  lines = g_strsplit (contents, "\n", -1);
+
+  for (guint i = 0; lines[i]; i++)
+    {
+      char *line = lines[i];
+      char *slash;
+
+      line[strcspn (line, " \t\r")] = 0;
+
+      if (i == 0 && is_count_line (line))
+        continue;
+
+      if ((slash = strchr (line, '/')))
+        {
+          *slash = 0;
+
+          /* Flags without the .aff file cannot be interpreted */
+          if (!has_affixes)
+            {
+              g_printerr ("%s: %s\n", argv[1], "Affix flags found without an .aff file");
+              goto cleanup;
+            }
+
+          if (is_rejected (&affixes, slash + 1, flags))
+            continue;
+        }
+
+      if (*line == 0 || !g_utf8_validate (line, -1, NULL))
+        continue;
+
+      g_ptr_array_add (words, line);
+    }
+
+  bytes = _editor_dict_build (words);
+
+  if (!g_file_set_contents (argv[2],
+                            g_bytes_get_data (bytes, NULL),
+                            g_bytes_get_size (bytes),
+                            &error))
+    {
+      g_printerr ("%s\n", error->message);
+      goto cleanup;
+    }
+
+  ret = EXIT_SUCCESS;
+
+cleanup:
+  affixes_clear (&affixes);
+
+  return ret;
+}
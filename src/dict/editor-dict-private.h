@@ -0,0 +1,48 @@
+/* editor-dict-private.h
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define EDITOR_DICT_MAX_WORD_LEN 255
+
+typedef struct
+{
+  const guint8  *data;
+  gsize          len;
+  const guint8  *offsets;
+  const guint8  *blocks;
+  gsize          blocks_len;
+  guint          n_blocks;
+  guint          n_words;
+} EditorDict;
+
+GBytes   *_editor_dict_build    (GPtrArray        *words);
+gboolean  _editor_dict_init     (EditorDict       *dict,
+                                 const guint8     *data,
+                                 gsize             len);
+gboolean  _editor_dict_contains (const EditorDict *dict,
+                                 const char       *word,
+                                 gsize             word_len);
+
+G_END_DECLS
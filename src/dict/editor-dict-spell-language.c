@@ -0,0 +1,261 @@
+/* editor-dict-spell-language.c
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "editor-dict-private.h"
+#include "editor-dict-spell-language.h"
+
+struct _EditorDictSpellLanguage
+{
+  EditorSpellLanguage  parent_instance;
+
+  /* Words found in @dict are correct. Anything else is up to @fallback
+   * which knows about affix rules and the personal dictionary, and also
+   * provides corrections. @dict is immutable, so lookups need no lock.
+   */
+  EditorSpellLanguage *fallback;
+  GMappedFile         *mapped_file;
+  EditorDict           dict;
+};
+
+G_DEFINE_TYPE (EditorDictSpellLanguage, editor_dict_spell_language, EDITOR_TYPE_SPELL_LANGUAGE)
+
+enum {
+  PROP_0,
+  PROP_FALLBACK,
+  PROP_MAPPED_FILE,
+  N_PROPS
+};
+
+static GParamSpec *properties [N_PROPS];
+
+/**
+ * editor_dict_spell_language_new:
+ * @code: the language code
+ * @fallback: the #EditorSpellLanguage for words missing from @mapped_file
+ * @mapped_file: a precompiled dictionary
+ *
+ * Create a new #EditorDictSpellLanguage.
+ *
+ * Returns: (transfer full): a newly created #EditorDictSpellLanguage
+ */
+EditorSpellLanguage *
+editor_dict_spell_language_new (const char          *code,
+                                EditorSpellLanguage *fallback,
+                                GMappedFile         *mapped_file)
+{
+  g_return_val_if_fail (EDITOR_IS_SPELL_LANGUAGE (fallback), NULL);
+  g_return_val_if_fail (mapped_file != NULL, NULL);
+
+  return g_object_new (EDITOR_TYPE_DICT_SPELL_LANGUAGE,
+                       "code", code,
+                       "fallback", fallback,
+                       "mapped-file", mapped_file,
+                       NULL);
+}
+
+static gboolean
+editor_dict_spell_language_contains_word (EditorSpellLanguage *language,
+                                          const char          *word,
+                                          gssize               word_len)
+{
+  EditorDictSpellLanguage *self = (EditorDictSpellLanguage *)language;
+
+  g_assert (EDITOR_IS_DICT_SPELL_LANGUAGE (self));
+  g_assert (word != NULL);
+  g_assert (word_len > 0);
+
+  if (_editor_dict_contains (&self->dict, word, word_len))
+    return TRUE;
+
+  /* Capitalized at the start of a sentence */
+  if (word[0] >= 'A' && word[0] <= 'Z' && word_len <= EDITOR_DICT_MAX_WORD_LEN)
+    {
+      char lower[EDITOR_DICT_MAX_WORD_LEN];
+
+      memcpy (lower, word, word_len);
+      lower[0] = g_ascii_tolower (word[0]);
+
+      if (_editor_dict_contains (&self->dict, lower, word_len))
+        return TRUE;
+    }
+
+  return EDITOR_SPELL_LANGUAGE_GET_CLASS (self->fallback)->contains_word (self->fallback, word, word_len);
+}
+
+static char **
+editor_dict_spell_language_list_corrections (EditorSpellLanguage *language,
+                                             const char          *word,
+                                             gssize               word_len)
+{
+  EditorDictSpellLanguage *self = (EditorDictSpellLanguage *)language;
+
+  g_assert (EDITOR_IS_DICT_SPELL_LANGUAGE (self));
+
+  return editor_spell_language_list_corrections (self->fallback, word, word_len);
+}
+
+static void
+editor_dict_spell_language_add_word (EditorSpellLanguage *language,
+                                     const char          *word)
+{
+  EditorDictSpellLanguage *self = (EditorDictSpellLanguage *)language;
+
+  g_assert (EDITOR_IS_DICT_SPELL_LANGUAGE (self));
+
+  editor_spell_language_add_word (self->fallback, word);
+}
+
+static void
+editor_dict_spell_language_ignore_word (EditorSpellLanguage *language,
+                                        const char          *word)
+{
+  EditorDictSpellLanguage *self = (EditorDictSpellLanguage *)language;
+
+  g_assert (EDITOR_IS_DICT_SPELL_LANGUAGE (self));
+
+  editor_spell_language_ignore_word (self->fallback, word);
+}
+
+static const char *
+editor_dict_spell_language_get_extra_word_chars (EditorSpellLanguage *language)
+{
+  EditorDictSpellLanguage *self = (EditorDictSpellLanguage *)language;
+
+  g_assert (EDITOR_IS_DICT_SPELL_LANGUAGE (self));
+
+  return editor_spell_language_get_extra_word_chars (self->fallback);
+}
+
+static void
+editor_dict_spell_language_constructed (GObject *object)
+{
+  EditorDictSpellLanguage *self = (EditorDictSpellLanguage *)object;
+
+  g_assert (EDITOR_IS_DICT_SPELL_LANGUAGE (self));
+
+  G_OBJECT_CLASS (editor_dict_spell_language_parent_class)->constructed (object);
+
+  /* An invalid file leaves @dict empty so that everything goes to @fallback */
+  if (!_editor_dict_init (&self->dict,
+                          (const guint8 *)g_mapped_file_get_contents (self->mapped_file),
+                          g_mapped_file_get_length (self->mapped_file)))
+    g_warning ("Ignoring invalid dictionary for “%s”",
+               editor_spell_language_get_code (EDITOR_SPELL_LANGUAGE (self)));
+}
+
+static void
+editor_dict_spell_language_finalize (GObject *object)
+{
+  EditorDictSpellLanguage *self = (EditorDictSpellLanguage *)object;
+
+  g_clear_object (&self->fallback);
+  g_clear_pointer (&self->mapped_file, g_mapped_file_unref);
+
+  G_OBJECT_CLASS (editor_dict_spell_language_parent_class)->finalize (object);
+}
+
+static void
+editor_dict_spell_language_get_property (GObject    *object,
+                                         guint       prop_id,
+                                         GValue     *value,
+                                         GParamSpec *pspec)
+{
+  EditorDictSpellLanguage *self = EDITOR_DICT_SPELL_LANGUAGE (object);
+
+  switch (prop_id)
+    {
+    case PROP_FALLBACK:
+      g_value_set_object (value, self->fallback);
+      break;
+
+    case PROP_MAPPED_FILE:
+      g_value_set_boxed (value, self->mapped_file);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+editor_dict_spell_language_set_property (GObject      *object,
+                                         guint         prop_id,
+                                         const GValue *value,
+                                         GParamSpec   *pspec)
+{
+  EditorDictSpellLanguage *self = EDITOR_DICT_SPELL_LANGUAGE (object);
+
+  switch (prop_id)
+    {
+    case PROP_FALLBACK:
+      self->fallback = g_value_dup_object (value);
+      break;
+
+    case PROP_MAPPED_FILE:
+      self->mapped_file = g_value_dup_boxed (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+editor_dict_spell_language_class_init (EditorDictSpellLanguageClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  EditorSpellLanguageClass *spell_language_class = EDITOR_SPELL_LANGUAGE_CLASS (klass);
+
+  object_class->constructed = editor_dict_spell_language_constructed;
+  object_class->finalize = editor_dict_spell_language_finalize;
+  object_class->get_property = editor_dict_spell_language_get_property;
+  object_class->set_property = editor_dict_spell_language_set_property;
+
+  spell_language_class->contains_word = editor_dict_spell_language_contains_word;
+  spell_language_class->list_corrections = editor_dict_spell_language_list_corrections;
+  spell_language_class->add_word = editor_dict_spell_language_add_word;
+  spell_language_class->ignore_word = editor_dict_spell_language_ignore_word;
+  spell_language_class->get_extra_word_chars = editor_dict_spell_language_get_extra_word_chars;
+
+  properties [PROP_FALLBACK] =
+    g_param_spec_object ("fallback",
+                         "Fallback",
+                         "The language for words missing from the dictionary",
+                         EDITOR_TYPE_SPELL_LANGUAGE,
+                         (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  properties [PROP_MAPPED_FILE] =
+    g_param_spec_boxed ("mapped-file",
+                        "Mapped File",
+                        "The precompiled dictionary",
+                        G_TYPE_MAPPED_FILE,
+                        (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_properties (object_class, N_PROPS, properties);
+}
+
+static void
+editor_dict_spell_language_init (EditorDictSpellLanguage *self)
+{
+}
@@ -0,0 +1,250 @@
+/* editor-dict-spell-provider.c
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include "editor-dict-spell-language.h"
+#include "editor-dict-spell-provider.h"
+
+/*
+ * Looking words up through Enchant goes through its backend and a lock
+ * for every word. This provider answers lookups from dictionaries that
+ * were precompiled at build time, or installed by the user, and leaves
+ * everything else, such as corrections, to the fallback provider.
+ *
+ * Dictionaries are named after the language code, such as "en_US.dict",
+ * and looked up in the user data directory first.
+ */
+
+struct _EditorDictSpellProvider
+{
+  EditorSpellProvider  parent_instance;
+  EditorSpellProvider *fallback;
+
+  /* Languages are loaded from worker threads */
+  GMutex               mutex;
+  GHashTable          *languages;
+};
+
+G_DEFINE_TYPE (EditorDictSpellProvider, editor_dict_spell_provider, EDITOR_TYPE_SPELL_PROVIDER)
+
+enum {
+  PROP_0,
+  PROP_FALLBACK,
+  N_PROPS
+};
+
+static GParamSpec *properties [N_PROPS];
+
+/**
+ * editor_dict_spell_provider_new:
+ * @fallback: the #EditorSpellProvider for everything but lookups
+ *
+ * Create a new #EditorDictSpellProvider.
+ *
+ * Returns: (transfer full): a newly created #EditorDictSpellProvider
+ */
+EditorSpellProvider *
+editor_dict_spell_provider_new (EditorSpellProvider *fallback)
+{
+  g_return_val_if_fail (EDITOR_IS_SPELL_PROVIDER (fallback), NULL);
+
+  return g_object_new (EDITOR_TYPE_DICT_SPELL_PROVIDER,
+                       "display-name", editor_spell_provider_get_display_name (fallback),
+                       "fallback", fallback,
+                       NULL);
+}
+
+static GMappedFile *
+load_dictionary (const char *code)
+{
+  g_autofree char *name = g_strdup_printf ("%s.dict", code);
+  const char *dirs[] = {
+    g_get_user_data_dir (),
+    PACKAGE_DATADIR,
+  };
+
+  for (guint i = 0; i < G_N_ELEMENTS (dirs); i++)
+    {
+      g_autofree char *path = NULL;
+      GMappedFile *mapped_file;
+
+      if (i == 0)
+        path = g_build_filename (dirs[i], "gnome-text-editor", "dictionaries", name, NULL);
+      else
+        path = g_build_filename (dirs[i], "dictionaries", name, NULL);
+
+      if ((mapped_file = g_mapped_file_new (path, FALSE, NULL)))
+        return mapped_file;
+    }
+
+  return NULL;
+}
+
+static gboolean
+editor_dict_spell_provider_supports_language (EditorSpellProvider *provider,
+                                              const char          *language)
+{
+  EditorDictSpellProvider *self = (EditorDictSpellProvider *)provider;
+
+  g_assert (EDITOR_IS_DICT_SPELL_PROVIDER (self));
+  g_assert (language != NULL);
+
+  return editor_spell_provider_supports_language (self->fallback, language);
+}
+
+static GPtrArray *
+editor_dict_spell_provider_list_languages (EditorSpellProvider *provider)
+{
+  EditorDictSpellProvider *self = (EditorDictSpellProvider *)provider;
+
+  g_assert (EDITOR_IS_DICT_SPELL_PROVIDER (self));
+
+  return editor_spell_provider_list_languages (self->fallback);
+}
+
+static const char *
+editor_dict_spell_provider_get_default_code (EditorSpellProvider *provider)
+{
+  EditorDictSpellProvider *self = (EditorDictSpellProvider *)provider;
+
+  g_assert (EDITOR_IS_DICT_SPELL_PROVIDER (self));
+
+  return editor_spell_provider_get_default_code (self->fallback);
+}
+
+static EditorSpellLanguage *
+editor_dict_spell_provider_get_language (EditorSpellProvider *provider,
+                                         const char          *language)
+{
+  EditorDictSpellProvider *self = (EditorDictSpellProvider *)provider;
+  EditorSpellLanguage *ret;
+
+  g_assert (EDITOR_IS_DICT_SPELL_PROVIDER (self));
+  g_assert (language != NULL);
+
+  g_mutex_lock (&self->mutex);
+
+  if (!(ret = g_hash_table_lookup (self->languages, language)))
+    {
+      g_autoptr(EditorSpellLanguage) fallback = NULL;
+      g_autoptr(GMappedFile) mapped_file = NULL;
+
+      /* Without a precompiled dictionary, use the fallback as is */
+      if ((fallback = editor_spell_provider_get_language (self->fallback, language)))
+        {
+          if ((mapped_file = load_dictionary (language)))
+            ret = editor_dict_spell_language_new (language, fallback, mapped_file);
+          else
+            ret = g_steal_pointer (&fallback);
+
+          g_hash_table_insert (self->languages, g_strdup (language), ret);
+        }
+    }
+
+  if (ret != NULL)
+    g_object_ref (ret);
+
+  g_mutex_unlock (&self->mutex);
+
+  return ret;
+}
+
+static void
+editor_dict_spell_provider_finalize (GObject *object)
+{
+  EditorDictSpellProvider *self = (EditorDictSpellProvider *)object;
+
+  g_clear_object (&self->fallback);
+  g_clear_pointer (&self->languages, g_hash_table_unref);
+  g_mutex_clear (&self->mutex);
+
+  G_OBJECT_CLASS (editor_dict_spell_provider_parent_class)->finalize (object);
+}
+
+static void
+editor_dict_spell_provider_get_property (GObject    *object,
+                                         guint       prop_id,
+                                         GValue     *value,
+                                         GParamSpec *pspec)
+{
+  EditorDictSpellProvider *self = EDITOR_DICT_SPELL_PROVIDER (object);
+
+  switch (prop_id)
+    {
+    case PROP_FALLBACK:
+      g_value_set_object (value, self->fallback);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+editor_dict_spell_provider_set_property (GObject      *object,
+                                         guint         prop_id,
+                                         const GValue *value,
+                                         GParamSpec   *pspec)
+{
+  EditorDictSpellProvider *self = EDITOR_DICT_SPELL_PROVIDER (object);
+
+  switch (prop_id)
+    {
+    case PROP_FALLBACK:
+      self->fallback = g_value_dup_object (value);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+editor_dict_spell_provider_class_init (EditorDictSpellProviderClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  EditorSpellProviderClass *spell_provider_class = EDITOR_SPELL_PROVIDER_CLASS (klass);
+
+  object_class->finalize = editor_dict_spell_provider_finalize;
+  object_class->get_property = editor_dict_spell_provider_get_property;
+  object_class->set_property = editor_dict_spell_provider_set_property;
+
+  spell_provider_class->supports_language = editor_dict_spell_provider_supports_language;
+  spell_provider_class->list_languages = editor_dict_spell_provider_list_languages;
+  spell_provider_class->get_language = editor_dict_spell_provider_get_language;
+  spell_provider_class->get_default_code = editor_dict_spell_provider_get_default_code;
+
+  properties [PROP_FALLBACK] =
+    g_param_spec_object ("fallback",
+                         "Fallback",
+                         "The provider for corrections and unknown words",
+                         EDITOR_TYPE_SPELL_PROVIDER,
+                         (G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_properties (object_class, N_PROPS, properties);
+}
+
+static void
+editor_dict_spell_provider_init (EditorDictSpellProvider *self)
+{
+  g_mutex_init (&self->mutex);
+  self->languages = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+}
@@ -0,0 +1,309 @@
+/* editor-dict.c
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "editor-dict-private.h"
+
+/*
+ * Precompiled dictionaries are sorted word lists meant to be mapped
+ * into memory and searched in place, without locks or allocations.
+ *
+ * Words are stored in blocks of BLOCK_WORDS entries. The first word of
+ * each block is stored as is so that blocks can be binary searched. The
+ * others only store what differs from the previous word:
+ *
+ *   guint8  shared;      bytes in common with the previous word
+ *   guint8  suffix_len;  bytes that follow
+ *   char    suffix[];
+ *
+ * The file starts with a header and the offsets of each block, relative
+ * to the first block, followed by the end offset. Integers are stored
+ * as little-endian.
+ *
+ *   char    magic[8];
+ *   guint32 n_words;
+ *   guint32 n_blocks;
+ *   guint32 offsets[n_blocks + 1];
+ */
+
+#define MAGIC       "EDDICT01"
+#define MAGIC_LEN   8
+#define HEADER_LEN  (MAGIC_LEN + 8)
+#define BLOCK_WORDS 32
+
+static inline guint32
+read_uint32 (const guint8 *data)
+{
+  guint32 value;
+
+  memcpy (&value, data, sizeof value);
+
+  return GUINT32_FROM_LE (value);
+}
+
+static inline void
+append_uint32 (GByteArray *bytes,
+               guint32     value)
+{
+  value = GUINT32_TO_LE (value);
+  g_byte_array_append (bytes, (const guint8 *)&value, sizeof value);
+}
+
+static int
+compare_words (gconstpointer a,
+               gconstpointer b)
+{
+  return strcmp (*(const char * const *)a, *(const char * const *)b);
+}
+
+/**
+ * _editor_dict_build:
+ * @words: (element-type utf8): the words of the dictionary
+ *
+ * Creates the contents of a precompiled dictionary. @words is sorted in
+ * place. Duplicates and words longer than %EDITOR_DICT_MAX_WORD_LEN bytes
+ * are skipped.
+ *
+ * Returns: (transfer full): the dictionary contents
+ */
+GBytes *
+_editor_dict_build (GPtrArray *words)
+{
+  g_autoptr(GByteArray) blocks = NULL;
+  g_autoptr(GArray) offsets = NULL;
+  GByteArray *ret;
+  const char *prev = NULL;
+  gsize prev_len = 0;
+  guint n_words = 0;
+
+  g_return_val_if_fail (words != NULL, NULL);
+
+  g_ptr_array_sort (words, compare_words);
+
+  blocks = g_byte_array_new ();
+  offsets = g_array_new (FALSE, FALSE, sizeof (guint32));
+
+  for (guint i = 0; i < words->len; i++)
+    {
+      const char *word = g_ptr_array_index (words, i);
+      gsize len = strlen (word);
+      guint8 header[2];
+      gsize shared = 0;
+
+      if (len == 0 ||
+          len > EDITOR_DICT_MAX_WORD_LEN ||
+          (prev != NULL && strcmp (prev, word) == 0))
+        continue;
+
+      if (n_words % BLOCK_WORDS == 0)
+        {
+          guint32 offset = blocks->len;
+          g_array_append_val (offsets, offset);
+        }
+      else
+        {
+          while (shared < len && shared < prev_len && prev[shared] == word[shared])
+            shared++;
+        }
+
+      header[0] = shared;
+      header[1] = len - shared;
+      g_byte_array_append (blocks, header, sizeof header);
+      g_byte_array_append (blocks, (const guint8 *)word + shared, len - shared);
+
+      prev = word;
+      prev_len = len;
+      n_words++;
+    }
+
+  ret = g_byte_array_sized_new (HEADER_LEN + (offsets->len + 1) * 4 + blocks->len);
+  g_byte_array_append (ret, (const guint8 *)MAGIC, MAGIC_LEN);
+  append_uint32 (ret, n_words);
+  append_uint32 (ret, offsets->len);
+  for (guint i = 0; i < offsets->len; i++)
+    append_uint32 (ret, g_array_index (offsets, guint32, i));
+  append_uint32 (ret, blocks->len);
+  g_byte_array_append (ret, blocks->data, blocks->len);
+
+  return g_byte_array_free_to_bytes (ret);
+}
+
+/**
+ * _editor_dict_init:
+ * @dict: an #EditorDict to initialize
+ * @data: the contents of a precompiled dictionary
+ * @len: the length of @data
+ *
+ * Initializes @dict to search @data, which must outlive @dict.
+ *
+ * Returns: %TRUE if @data is a valid dictionary
+ */
+gboolean
+_editor_dict_init (EditorDict   *dict,
+                   const guint8 *data,
+                   gsize         len)
+{
+  guint32 prev_offset = 0;
+  guint n_blocks;
+
+  g_return_val_if_fail (dict != NULL, FALSE);
+
+  memset (dict, 0, sizeof *dict);
+
+  if (data == NULL || len < HEADER_LEN || memcmp (data, MAGIC, MAGIC_LEN) != 0)
+    return FALSE;
+
+  n_blocks = read_uint32 (data + MAGIC_LEN + 4);
+
+  if ((len - HEADER_LEN) / 4 < (gsize)n_blocks + 1)
+    return FALSE;
+
+  dict->data = data;
+  dict->len = len;
+  dict->n_words = read_uint32 (data + MAGIC_LEN);
+  dict->n_blocks = n_blocks;
+  dict->offsets = data + HEADER_LEN;
+  dict->blocks = dict->offsets + ((gsize)n_blocks + 1) * 4;
+  dict->blocks_len = data + len - dict->blocks;
+
+  /* Blocks must be in order and non-empty so that searching only has
+   * to check the bounds of entries within a block.
+   */
+  for (guint i = 0; i <= n_blocks; i++)
+    {
+      guint32 offset = read_uint32 (dict->offsets + i * 4);
+
+      if (offset > dict->blocks_len ||
+          (i > 0 && offset <= prev_offset) ||
+          (i == 0 && offset != 0))
+        {
+          memset (dict, 0, sizeof *dict);
+          return FALSE;
+        }
+
+      prev_offset = offset;
+    }
+
+  return TRUE;
+}
+
+static inline int
+compare_key (const guint8 *key,
+             gsize         key_len,
+             const char   *word,
+             gsize         word_len)
+{
+  int cmp = memcmp (key, word, MIN (key_len, word_len));
+
+  if (cmp == 0)
+    cmp = (key_len > word_len) - (key_len < word_len);
+
+  return cmp;
+}
+
+static inline void
+get_block (const EditorDict  *dict,
+           guint              index,
+           const guint8     **begin,
+           const guint8     **end)
+{
+  *begin = dict->blocks + read_uint32 (dict->offsets + index * 4);
+  *end = dict->blocks + read_uint32 (dict->offsets + (index + 1) * 4);
+}
+
+/**
+ * _editor_dict_contains:
+ * @dict: an #EditorDict
+ * @word: the word to look for, which need not be terminated
+ * @word_len: the length of @word in bytes
+ *
+ * Looks for @word in @dict. This neither locks nor allocates, so it
+ * may be called from any thread.
+ *
+ * Returns: %TRUE if @word is in @dict
+ */
+gboolean
+_editor_dict_contains (const EditorDict *dict,
+                       const char       *word,
+                       gsize             word_len)
+{
+  guint8 key[EDITOR_DICT_MAX_WORD_LEN];
+  const guint8 *begin;
+  const guint8 *end;
+  gsize key_len = 0;
+  guint lo = 0;
+  guint hi;
+
+  g_return_val_if_fail (dict != NULL, FALSE);
+
+  if (word_len == 0 || word_len > EDITOR_DICT_MAX_WORD_LEN)
+    return FALSE;
+
+  /* Find the last block starting with a word before @word */
+  hi = dict->n_blocks;
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+      int cmp;
+
+      get_block (dict, mid, &begin, &end);
+
+      if (begin + 2 > end || begin[0] != 0 || begin + 2 + begin[1] > end)
+        return FALSE;
+
+      if ((cmp = compare_key (begin + 2, begin[1], word, word_len)) == 0)
+        return TRUE;
+
+      if (cmp < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  if (lo == 0)
+    return FALSE;
+
+  get_block (dict, lo - 1, &begin, &end);
+
+  while (begin + 2 <= end)
+    {
+      guint shared = begin[0];
+      guint suffix_len = begin[1];
+      int cmp;
+
+      if (shared > key_len ||
+          shared + suffix_len > sizeof key ||
+          begin + 2 + suffix_len > end)
+        return FALSE;
+
+      memcpy (key + shared, begin + 2, suffix_len);
+      key_len = shared + suffix_len;
+
+      if ((cmp = compare_key (key, key_len, word, word_len)) >= 0)
+        return cmp == 0;
+
+      begin += 2 + suffix_len;
+    }
+
+  return FALSE;
+}
@@ -28,9 +28,7 @@
 #include <string.h>
 
 #include "editor-animation.h"
-#include "editor-frame-source.h"
-
-#define FALLBACK_FRAME_RATE 60
+#include "editor-trace-private.h"
 
 typedef gdouble (*AlphaFunc) (gdouble       offset);
 typedef void    (*TweenFunc) (const GValue *begin,
@@ -55,14 +53,22 @@ struct _EditorAnimation
   gint64             end_time;            /* Deadline for the animation */
   guint              duration_msec;       /* Duration in milliseconds */
   guint              mode;                /* Tween mode */
-  gulong             tween_handler;       /* GSource or signal handler */
-  gulong             after_paint_handler; /* signal handler */
+  gint64             pause_time;          /* Time in which target was unmapped */
+  gint64             last_frame_time;     /* Frame time of the last update */
+  gulong             tween_handler;       /* GdkFrameClock::update() callback */
+  gulong             map_handler;         /* GtkWidget::map() callback */
+  gulong             unmap_handler;       /* GtkWidget::unmap() callback */
   gulong             unrealize_handler;   /* GtkWidget::unrealize() callback */
   gdouble            last_offset;         /* Track our last offset */
   GArray            *tweens;              /* Array of tweens to perform */
-  GdkFrameClock     *frame_clock;         /* An optional frame-clock for sync. */
+  GdkFrameClock     *frame_clock;         /* The frame-clock to sync to */
   GDestroyNotify     notify;              /* Notify callback */
   gpointer           notify_data;         /* Data for notify */
+  guint              n_frames;            /* Frames we were updated for */
+  guint              n_dropped_frames;    /* Frames missed between updates */
+  guint              n_unneeded_frames;   /* Updates that changed nothing */
+  guint              running : 1;
+  guint              paused : 1;
   guint              stop_called : 1;
 };
 
@@ -110,6 +116,9 @@ static GParamSpec *properties[N_PROPS];
 static guint       signals[N_SIGNALS];
 static TweenFunc   tween_funcs[LAST_FUNDAMENTAL];
 static guint       slow_down_factor = 1;
+static guint       total_frames;
+static guint       total_dropped_frames;
+static guint       total_unneeded_frames;
 
 
 /*
@@ -410,7 +419,6 @@ editor_animation_target_unrealize_cb (EditorAnimation *animation,
    */
   g_clear_signal_handler (&animation->unrealize_handler, widget);
   animation->tween_handler = 0;
-  animation->after_paint_handler = 0;
 
   editor_animation_stop (animation);
 }
@@ -500,45 +508,41 @@ editor_animation_tick (EditorAnimation *animation,
 }
 
 
-/**
- * editor_animation_timeout_cb:
- * @user_data: (in): A #EditorAnimation.
- *
- * Timeout from the main loop to move to the next step of the animation.
- *
- * Returns: %TRUE until the animation has completed; otherwise %FALSE.
- * Side effects: None.
- */
-static gboolean
-editor_animation_timeout_cb (gpointer user_data)
-{
-  EditorAnimation *animation = user_data;
-  gboolean ret;
-  gdouble offset;
-
-  offset = editor_animation_get_offset (animation, 0);
-
-  if (!(ret = editor_animation_tick (animation, offset)))
-    editor_animation_stop (animation);
-
-  return ret;
-}
-
-
 static gboolean
 editor_animation_widget_tick_cb (GdkFrameClock   *frame_clock,
                                  EditorAnimation *animation)
 {
   gboolean ret = G_SOURCE_REMOVE;
+  gint64 frame_time;
+  gint64 interval = 0;
 
   g_assert (GDK_IS_FRAME_CLOCK (frame_clock));
   g_assert (EDITOR_IS_ANIMATION (animation));
 
+  frame_time = gdk_frame_clock_get_frame_time (frame_clock);
+  gdk_frame_clock_get_refresh_info (frame_clock, frame_time, &interval, NULL);
+
+  animation->n_frames++;
+
+  /* Count the frames the compositor skipped since our last update */
+  if (animation->last_frame_time != 0 && interval > 0)
+    {
+      gint64 missed = (frame_time - animation->last_frame_time - interval / 2) / interval;
+
+      if (missed > 0)
+        animation->n_dropped_frames += missed;
+    }
+
+  animation->last_frame_time = frame_time;
+
   if (animation->tween_handler)
     {
       gdouble offset;
 
-      offset = editor_animation_get_offset (animation, 0);
+      offset = editor_animation_get_offset (animation, frame_time);
+
+      if (offset == animation->last_offset)
+        animation->n_unneeded_frames++;
 
       if (!(ret = editor_animation_tick (animation, offset)))
         editor_animation_stop (animation);
@@ -549,23 +553,86 @@ editor_animation_widget_tick_cb (GdkFrameClock   *frame_clock,
 
 
 static void
-editor_animation_widget_after_paint_cb (GdkFrameClock   *frame_clock,
-                                        EditorAnimation *animation)
+editor_animation_connect_frame_clock (EditorAnimation *animation)
 {
-  gint64 base_time;
-  gint64 interval;
-  gint64 next_frame_time;
-  gdouble offset;
+  g_assert (EDITOR_IS_ANIMATION (animation));
+  g_assert (GDK_IS_FRAME_CLOCK (animation->frame_clock));
+  g_assert (animation->tween_handler == 0);
+
+  animation->last_frame_time = 0;
+  animation->tween_handler =
+    g_signal_connect_object (animation->frame_clock,
+                             "update",
+                             G_CALLBACK (editor_animation_widget_tick_cb),
+                             animation,
+                             0);
+  gdk_frame_clock_begin_updating (animation->frame_clock);
+}
 
-  g_assert (GDK_IS_FRAME_CLOCK (frame_clock));
+
+static void
+editor_animation_disconnect_frame_clock (EditorAnimation *animation)
+{
   g_assert (EDITOR_IS_ANIMATION (animation));
 
-  base_time = gdk_frame_clock_get_frame_time (frame_clock);
-  gdk_frame_clock_get_refresh_info (frame_clock, base_time, &interval, &next_frame_time);
+  if (animation->tween_handler != 0)
+    {
+      g_assert (GDK_IS_FRAME_CLOCK (animation->frame_clock));
+
+      gdk_frame_clock_end_updating (animation->frame_clock);
+      g_clear_signal_handler (&animation->tween_handler, animation->frame_clock);
+    }
+}
 
-  offset = editor_animation_get_offset (animation, next_frame_time);
 
-  editor_animation_tick (animation, offset);
+static void
+editor_animation_target_unmap_cb (EditorAnimation *animation,
+                                  GtkWidget       *widget)
+{
+  g_assert (EDITOR_IS_ANIMATION (animation));
+  g_assert (GTK_IS_WIDGET (widget));
+
+  /* Nothing is drawn while unmapped, so stop asking for frames */
+  if (animation->running && !animation->paused)
+    {
+      animation->paused = TRUE;
+      animation->pause_time = g_get_monotonic_time ();
+      editor_animation_disconnect_frame_clock (animation);
+    }
+}
+
+
+static void
+editor_animation_target_map_cb (EditorAnimation *animation,
+                                GtkWidget       *widget)
+{
+  gint64 paused_time;
+
+  g_assert (EDITOR_IS_ANIMATION (animation));
+  g_assert (GTK_IS_WIDGET (widget));
+
+  if (animation->running && animation->paused && animation->frame_clock != NULL)
+    {
+      /* Resume from where we left off rather than jumping ahead */
+      paused_time = g_get_monotonic_time () - animation->pause_time;
+      animation->begin_time += paused_time;
+      animation->end_time += paused_time;
+      animation->paused = FALSE;
+      editor_animation_connect_frame_clock (animation);
+    }
+}
+
+
+static gboolean
+editor_animation_finish_cb (gpointer user_data)
+{
+  EditorAnimation *animation = user_data;
+
+  g_assert (EDITOR_IS_ANIMATION (animation));
+
+  editor_animation_stop (animation);
+
+  return G_SOURCE_REMOVE;
 }
 
 
@@ -582,42 +649,49 @@ void
 editor_animation_start (EditorAnimation *animation)
 {
   g_return_if_fail (EDITOR_IS_ANIMATION (animation));
-  g_return_if_fail (!animation->tween_handler);
+  g_return_if_fail (!animation->running);
 
   g_object_ref_sink (animation);
   editor_animation_load_begin_values (animation);
 
-  /*
-   * We want the real current time instead of the GdkFrameClocks current time
-   * because if the clock was asleep, it could be innaccurate.
-   */
+  animation->running = TRUE;
 
-  if (animation->frame_clock)
+  if (GTK_IS_WIDGET (animation->target))
     {
-      animation->begin_time = gdk_frame_clock_get_frame_time (animation->frame_clock);
-      animation->end_time = animation->begin_time + (animation->duration_msec * 1000L);
-      animation->tween_handler =
-        g_signal_connect_object (animation->frame_clock,
-                                 "update",
-                                 G_CALLBACK (editor_animation_widget_tick_cb),
-                                 animation,
-                                 0);
-      animation->after_paint_handler =
-        g_signal_connect_object (animation->frame_clock,
-                                 "after-paint",
-                                 G_CALLBACK (editor_animation_widget_after_paint_cb),
-                                 animation,
-                                 0);
-      gdk_frame_clock_begin_updating (animation->frame_clock);
+      animation->map_handler =
+        g_signal_connect_swapped (animation->target,
+                                  "map",
+                                  G_CALLBACK (editor_animation_target_map_cb),
+                                  animation);
+      animation->unmap_handler =
+        g_signal_connect_swapped (animation->target,
+                                  "unmap",
+                                  G_CALLBACK (editor_animation_target_unmap_cb),
+                                  animation);
     }
-  else
+
+  /*
+   * Without a frame clock, or with a target that is not on screen, there
+   * is nothing to be seen in between. Jump to the final values instead of
+   * waking up for frames nobody will see. The caller may still be holding
+   * onto the animation, so complete it from the main loop.
+   */
+  if (animation->frame_clock == NULL ||
+      (GTK_IS_WIDGET (animation->target) && !gtk_widget_get_mapped (animation->target)))
     {
       animation->begin_time = g_get_monotonic_time ();
-      animation->end_time = animation->begin_time + (animation->duration_msec * 1000L);
-      animation->tween_handler = editor_frame_source_add (FALLBACK_FRAME_RATE,
-                                                          editor_animation_timeout_cb,
-                                                          animation);
+      animation->end_time = animation->begin_time;
+      editor_animation_tick (animation, 1.0);
+      g_idle_add_full (G_PRIORITY_HIGH,
+                       editor_animation_finish_cb,
+                       g_object_ref (animation),
+                       g_object_unref);
+      return;
     }
+
+  animation->begin_time = gdk_frame_clock_get_frame_time (animation->frame_clock);
+  animation->end_time = animation->begin_time + (animation->duration_msec * 1000L);
+  editor_animation_connect_frame_clock (animation);
 }
 
 
@@ -662,25 +736,42 @@ editor_animation_stop (EditorAnimation *animation)
 
   animation->stop_called = TRUE;
 
-  if (animation->tween_handler)
+  if (animation->running)
     {
-      if (animation->frame_clock)
-        {
-          g_assert (GDK_IS_FRAME_CLOCK (animation->frame_clock));
+      editor_animation_disconnect_frame_clock (animation);
 
-          gdk_frame_clock_end_updating (animation->frame_clock);
-          g_clear_signal_handler (&animation->tween_handler, animation->frame_clock);
-          g_clear_signal_handler (&animation->after_paint_handler, animation->frame_clock);
-          animation->tween_handler = 0;
-        }
-      else
+      if (GTK_IS_WIDGET (animation->target))
         {
-          g_source_remove (animation->tween_handler);
-          animation->tween_handler = 0;
+          g_clear_signal_handler (&animation->unrealize_handler, animation->target);
+          g_clear_signal_handler (&animation->map_handler, animation->target);
+          g_clear_signal_handler (&animation->unmap_handler, animation->target);
         }
 
-      if (GTK_IS_WIDGET (animation->target))
-        g_clear_signal_handler (&animation->unrealize_handler, animation->target);
+      animation->running = FALSE;
+
+      total_frames += animation->n_frames;
+      total_dropped_frames += animation->n_dropped_frames;
+      total_unneeded_frames += animation->n_unneeded_frames;
+
+      if (debug)
+        g_message ("Animation of %s finished after %u frames (%u dropped, %u unneeded)",
+                   G_OBJECT_TYPE_NAME (animation->target),
+                   animation->n_frames,
+                   animation->n_dropped_frames,
+                   animation->n_unneeded_frames);
+
+      if (_editor_trace_is_enabled ())
+        {
+          g_autofree char *detail = g_strdup_printf ("frames=%u dropped=%u unneeded=%u",
+                                                     animation->n_frames,
+                                                     animation->n_dropped_frames,
+                                                     animation->n_unneeded_frames);
+          _editor_trace_mark ("animation",
+                              G_OBJECT_TYPE_NAME (animation->target),
+                              animation->begin_time,
+                              g_get_monotonic_time (),
+                              detail);
+        }
 
       editor_animation_unload_begin_values (animation);
       editor_animation_notify (animation);
@@ -712,7 +803,7 @@ editor_animation_add_property (EditorAnimation *animation,
   g_return_if_fail (value != NULL);
   g_return_if_fail (value->g_type);
   g_return_if_fail (animation->target);
-  g_return_if_fail (!animation->tween_handler);
+  g_return_if_fail (!animation->running);
 
   tween.pspec = g_param_spec_ref (pspec);
   g_value_init (&tween.begin, pspec->value_type);
@@ -1198,3 +1289,32 @@ editor_animation_calculate_duration (GdkMonitor *monitor,
 #undef MIN_FRAMES_PER_ANIM
 #undef MAX_FRAMES_PER_ANIM
 }
+
+
+/**
+ * editor_animation_get_frame_counters:
+ * @n_frames: (out) (optional): location for the number of frames
+ * @n_dropped_frames: (out) (optional): location for the number of dropped frames
+ * @n_unneeded_frames: (out) (optional): location for the number of unneeded frames
+ *
+ * Gets the frame counters of all animations that have finished so far.
+ * Animations only request frames while their target is mapped, so these
+ * should not move while the application is idle.
+ *
+ * Dropped frames are frames the compositor skipped between two updates of
+ * an animation. Unneeded frames are updates which did not change anything.
+ */
+void
+editor_animation_get_frame_counters (guint *n_frames,
+                                     guint *n_dropped_frames,
+                                     guint *n_unneeded_frames)
+{
+  if (n_frames != NULL)
+    *n_frames = total_frames;
+
+  if (n_dropped_frames != NULL)
+    *n_dropped_frames = total_dropped_frames;
+
+  if (n_unneeded_frames != NULL)
+    *n_unneeded_frames = total_unneeded_frames;
+}
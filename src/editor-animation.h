@@ -68,5 +68,8 @@ EditorAnimation *editor_object_animate_full          (gpointer             objec
 guint            editor_animation_calculate_duration (GdkMonitor          *monitor,
                                                       gdouble              from_value,
                                                       gdouble              to_value);
+void             editor_animation_get_frame_counters (guint               *n_frames,
+                                                      guint               *n_dropped_frames,
+                                                      guint               *n_unneeded_frames);
 
 G_END_DECLS
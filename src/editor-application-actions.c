@@ -25,10 +25,12 @@
 
 #include <glib/gi18n.h>
 
+#include "editor-animation.h"
 #include "editor-application-private.h"
 #include "editor-page.h"
 #include "editor-save-changes-dialog-private.h"
 #include "editor-session-private.h"
+#include "editor-spell-metrics-private.h"
 #include "editor-window.h"
 
 static const gchar *authors[] = {
@@ -218,6 +220,59 @@ editor_application_actions_remove_recent_cb (GSimpleAction *action,
   _editor_session_forget (EDITOR_SESSION_DEFAULT, file, draft_id);
 }
 
+/* Refreshes the action state, so the counters can also be read over
+ * D-Bus with org.gtk.Actions.Describe after activating it with
+ * `gapplication action org.gnome.TextEditor spell-metrics`.
+ */
+static void
+editor_application_actions_spell_metrics_cb (GSimpleAction *action,
+                                             GVariant      *param,
+                                             gpointer       user_data)
+{
+  g_autoptr(GVariant) state = NULL;
+  g_autofree char *str = NULL;
+
+  g_assert (G_IS_SIMPLE_ACTION (action));
+  g_assert (EDITOR_IS_APPLICATION (user_data));
+
+  state = g_variant_ref_sink (_editor_spell_metrics_to_variant ());
+  str = g_variant_print (state, FALSE);
+
+  g_message ("Spellcheck metrics: %s", str);
+  g_simple_action_set_state (action, state);
+}
+
+/* Like "spell-metrics", but for the frame counters of finished animations.
+ * These should not move while the application is idle.
+ */
+static void
+editor_application_actions_animation_metrics_cb (GSimpleAction *action,
+                                                 GVariant      *param,
+                                                 gpointer       user_data)
+{
+  g_autoptr(GVariant) state = NULL;
+  g_autofree char *str = NULL;
+  GVariantDict dict;
+  guint n_frames;
+  guint n_dropped_frames;
+  guint n_unneeded_frames;
+
+  g_assert (G_IS_SIMPLE_ACTION (action));
+  g_assert (EDITOR_IS_APPLICATION (user_data));
+
+  editor_animation_get_frame_counters (&n_frames, &n_dropped_frames, &n_unneeded_frames);
+
+  g_variant_dict_init (&dict, NULL);
+  g_variant_dict_insert (&dict, "frames", "u", n_frames);
+  g_variant_dict_insert (&dict, "dropped-frames", "u", n_dropped_frames);
+  g_variant_dict_insert (&dict, "unneeded-frames", "u", n_unneeded_frames);
+  state = g_variant_ref_sink (g_variant_dict_end (&dict));
+  str = g_variant_print (state, FALSE);
+
+  g_message ("Animation metrics: %s", str);
+  g_simple_action_set_state (action, state);
+}
+
 void
 _editor_application_actions_init (EditorApplication *self)
 {
@@ -227,6 +282,8 @@ _editor_application_actions_init (EditorApplication *self)
     { "help", editor_application_actions_help_cb },
     { "quit", editor_application_actions_quit },
     { "remove-recent", editor_application_actions_remove_recent_cb, "(ss)" },
+    { "spell-metrics", editor_application_actions_spell_metrics_cb, NULL, "@a{sv} {}" },
+    { "animation-metrics", editor_application_actions_animation_metrics_cb, NULL, "@a{sv} {}" },
   };
   g_autoptr(GPropertyAction) style_scheme = NULL;
 
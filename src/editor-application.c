@@ -26,6 +26,8 @@
 
 #include "editor-application-private.h"
 #include "editor-session-private.h"
+#include "editor-spell-provider.h"
+#include "editor-trace-private.h"
 #include "editor-utils-private.h"
 #include "editor-window.h"
 
@@ -56,7 +58,8 @@ editor_application_restore_cb (GObject      *object,
       if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
         g_warning ("Failed to restore session: %s", error->message);
 
-      if (files == NULL || files->len == 0)
+      if ((files == NULL || files->len == 0) &&
+          editor_application_get_current_window (EDITOR_APPLICATION_DEFAULT) == NULL)
         editor_session_create_window (session);
     }
 
@@ -96,6 +99,11 @@ editor_application_activate (GApplication *application)
 
   g_application_hold (application);
 
+  /* Display the first window from the startup snapshot right away and
+   * let the rest of the session stream in behind it.
+   */
+  _editor_session_restore_snapshot (self->session);
+
   editor_session_restore_async (self->session,
                                 NULL,
                                 editor_application_restore_cb,
@@ -123,6 +131,7 @@ editor_application_open (GApplication  *application,
   if (!_editor_session_did_restore (self->session))
     {
       g_application_hold (application);
+      _editor_session_restore_snapshot (self->session);
       editor_session_restore_async (self->session,
                                     NULL,
                                     editor_application_restore_cb,
@@ -208,6 +217,7 @@ editor_application_startup (GApplication *application)
   AdwStyleManager *style_manager;
   static const gchar *quit_accels[] = { "<Primary>Q", NULL };
   static const gchar *help_accels[] = { "F1", NULL };
+  gint64 begin_time = g_get_monotonic_time ();
 
   g_assert (EDITOR_IS_APPLICATION (self));
 
@@ -245,6 +255,11 @@ editor_application_startup (GApplication *application)
                                               GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
 
   gtk_window_set_default_icon_name (PACKAGE_ICON_NAME);
+
+  /* Warm up spelling so the first document does not wait on it */
+  editor_spell_provider_preload (editor_spell_provider_get_default ());
+
+  _editor_trace_mark ("startup", "Application startup", begin_time, g_get_monotonic_time (), NULL);
 }
 
 static gint
@@ -252,6 +267,7 @@ editor_application_handle_local_options (GApplication *app,
                                          GVariantDict *options)
 {
   EditorApplication *self = (EditorApplication *)app;
+  const char *trace_filename;
   gboolean ignore_session;
 
   g_assert (EDITOR_IS_APPLICATION (self));
@@ -260,6 +276,9 @@ editor_application_handle_local_options (GApplication *app,
   if (g_variant_dict_lookup (options, "ignore-session", "b", &ignore_session))
     _editor_session_set_restore_pages (self->session, FALSE);
 
+  if (g_variant_dict_lookup (options, "trace", "^&ay", &trace_filename))
+    _editor_trace_set_filename (trace_filename);
+
   return G_APPLICATION_CLASS (editor_application_parent_class)->handle_local_options (app, options);
 }
 
@@ -285,6 +304,8 @@ editor_application_shutdown (GApplication *application)
   g_clear_object (&self->session);
 
   G_APPLICATION_CLASS (editor_application_parent_class)->shutdown (application);
+
+  _editor_trace_write ();
 }
 
 static void
@@ -374,6 +395,7 @@ editor_application_class_init (EditorApplicationClass *klass)
 
 static const GOptionEntry entries[] = {
   { "ignore-session", 0, 0, G_OPTION_ARG_NONE, NULL, N_("Do not restore session at startup") },
+  { "trace", 0, 0, G_OPTION_ARG_FILENAME, NULL, N_("Write a performance trace to FILE on exit"), N_("FILE") },
   { 0 }
 };
 
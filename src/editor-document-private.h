@@ -24,6 +24,14 @@
 
 G_BEGIN_DECLS
 
+/* Passed to EditorDocument::cursor-changed handlers */
+typedef struct
+{
+  guint offset;
+  guint line;
+  guint line_offset;
+} EditorDocumentCursor;
+
 EditorDocument           *_editor_document_new                     (GFile                    *file,
                                                                     const gchar              *draft_id);
 const gchar              *_editor_document_get_draft_id            (EditorDocument           *self);
@@ -33,6 +41,9 @@ GFile                    *_editor_document_get_draft_file          (EditorDocume
 gchar                    *_editor_document_dup_uri                 (EditorDocument           *self);
 void                      _editor_document_mark_busy               (EditorDocument           *self);
 void                      _editor_document_unmark_busy             (EditorDocument           *self);
+void                      _editor_document_begin_bulk_edit         (EditorDocument           *self);
+void                      _editor_document_end_bulk_edit           (EditorDocument           *self);
+gboolean                  _editor_document_get_bulk_editing        (EditorDocument           *self);
 void                      _editor_document_set_externally_modified (EditorDocument           *self,
                                                                     gboolean                  externally_modified);
 gboolean                  _editor_document_get_was_restored        (EditorDocument           *self);
@@ -46,12 +57,14 @@ void                      _editor_document_set_newline_type        (EditorDocume
                                                                     GtkSourceNewlineType      newline_type);
 void                      _editor_document_load_async              (EditorDocument           *self,
                                                                     EditorWindow             *window,
+                                                                    gint                      io_priority,
                                                                     GCancellable             *cancellable,
                                                                     GAsyncReadyCallback       callback,
                                                                     gpointer                  user_data);
 gboolean                  _editor_document_load_finish             (EditorDocument           *self,
                                                                     GAsyncResult             *result,
                                                                     GError                  **error);
+gboolean                  _editor_document_get_loading             (EditorDocument           *self);
 void                      _editor_document_save_async              (EditorDocument           *self,
                                                                     GFile                    *file,
                                                                     GCancellable             *cancellable,
@@ -76,13 +89,16 @@ gboolean                  _editor_document_guess_language_finish   (EditorDocume
                                                                     GError                  **error);
 void                      _editor_document_attach_actions          (EditorDocument           *self,
                                                                     GtkWidget                *widget);
+EditorSpellChecker       *_editor_document_get_spell_checker_at    (EditorDocument           *self,
+                                                                    const GtkTextIter        *location);
 gboolean                  _editor_document_check_spelling          (EditorDocument           *self,
-                                                                    const char               *word);
-char                    **_editor_document_list_corrections        (EditorDocument           *self,
+                                                                    const GtkTextIter        *location,
                                                                     const char               *word);
 void                      _editor_document_add_spelling            (EditorDocument           *self,
+                                                                    const GtkTextIter        *location,
                                                                     const char               *word);
 void                      _editor_document_ignore_spelling         (EditorDocument           *self,
+                                                                    const GtkTextIter        *location,
                                                                     const char               *word);
 GtkTextTag               *_editor_document_get_spelling_tag        (EditorDocument           *self);
 
@@ -25,17 +25,25 @@
 #include <glib/gi18n.h>
 #include <string.h>
 
+#include "cjhtextregionprivate.h"
+
 #include "editor-application.h"
 #include "editor-buffer-monitor-private.h"
 #include "editor-document-private.h"
 #include "editor-spell-checker.h"
 #include "editor-text-buffer-spell-adapter.h"
 #include "editor-session-private.h"
+#include "editor-trace-private.h"
+#include "editor-utils-private.h"
 #include "editor-window.h"
 
 #define METATDATA_CURSOR    "metadata::gnome-text-editor-cursor"
 #define TITLE_LAST_WORD_POS 20
 #define TITLE_MAX_LEN       100
+#define CURSOR_CHANGED_USEC (G_USEC_PER_SEC / 60)
+
+#define BULK_CLEAN          NULL
+#define BULK_EDITED         GSIZE_TO_POINTER (1)
 
 struct _EditorDocument
 {
@@ -53,6 +61,19 @@ struct _EditorDocument
   guint                         busy_count;
   gdouble                       busy_progress;
 
+  /* Ranges modified during a bulk edit, kept in sync with the buffer
+   * so that only those are checked again once the bulk edit completes.
+   */
+  CjhTextRegion                *bulk_region;
+  guint                         bulk_edit_count;
+
+  /* Cursor moves are coalesced into one EditorDocument::cursor-changed
+   * emission per frame, sharing this snapshot with every handler.
+   */
+  GSource                      *cursor_changed_source;
+  gint64                        last_cursor_changed;
+  EditorDocumentCursor          cursor;
+
   guint                         loading : 1;
   guint                         readonly : 1;
   guint                         needs_autosave : 1;
@@ -62,9 +83,10 @@ struct _EditorDocument
 
 typedef struct
 {
-  gchar *position;
-  guint  line;
-  guint  line_offset;
+  gchar  *position;
+  gint64  begin_time;
+  guint   line;
+  guint   line_offset;
 } Save;
 
 typedef struct
@@ -75,6 +97,8 @@ typedef struct
   GMountOperation *mount_operation;
   gint64           draft_modified_at;
   gint64           modified_at;
+  gint64           begin_time;
+  gint             io_priority;
   guint            n_active;
   guint            highlight_syntax : 1;
   guint            has_draft : 1;
@@ -94,7 +118,13 @@ enum {
   N_PROPS
 };
 
+enum {
+  CURSOR_CHANGED,
+  N_SIGNALS
+};
+
 static GParamSpec *properties [N_PROPS];
+static guint signals [N_SIGNALS];
 static GSettings *shared_settings;
 
 static void
@@ -126,16 +156,37 @@ editor_document_mount_operation_factory (GtkSourceFile *file,
   return mount_operation ? g_object_ref (mount_operation) : NULL;
 }
 
+static void
+editor_document_trace (EditorDocument *self,
+                       const char     *name,
+                       gint64          begin_time)
+{
+  g_autofree char *uri = NULL;
+
+  g_assert (EDITOR_IS_DOCUMENT (self));
+
+  if (!_editor_trace_is_enabled ())
+    return;
+
+  uri = _editor_document_dup_uri (self);
+  _editor_trace_mark ("document", name, begin_time, g_get_monotonic_time (),
+                      uri ? uri : self->draft_id);
+}
+
 static void
 editor_document_load_notify_completed_cb (EditorDocument *self,
                                           GParamSpec     *pspec,
                                           GTask          *task)
 {
   EditorSession *session;
+  Load *load;
 
   g_assert (EDITOR_IS_DOCUMENT (self));
   g_assert (G_IS_TASK (task));
 
+  load = g_task_get_task_data (task);
+  editor_document_trace (self, "Load", load->begin_time);
+
   session = editor_application_get_session (EDITOR_APPLICATION_DEFAULT);
   _editor_session_document_seen (session, self);
 }
@@ -146,10 +197,14 @@ editor_document_save_notify_completed_cb (EditorDocument *self,
                                           GTask          *task)
 {
   EditorSession *session;
+  Save *save;
 
   g_assert (EDITOR_IS_DOCUMENT (self));
   g_assert (G_IS_TASK (task));
 
+  save = g_task_get_task_data (task);
+  editor_document_trace (self, "Save", save->begin_time);
+
   session = editor_application_get_session (EDITOR_APPLICATION_DEFAULT);
 
   _editor_session_document_seen (session, self);
@@ -210,6 +265,37 @@ editor_document_guess_content_type (EditorDocument *self)
     gtk_source_buffer_set_language (GTK_SOURCE_BUFFER (self), language);
 }
 
+static gboolean
+join_bulk_cb (gsize                   offset,
+              const CjhTextRegionRun *left,
+              const CjhTextRegionRun *right)
+{
+  return left->data == right->data;
+}
+
+static void
+editor_document_add_bulk_range (EditorDocument *self,
+                                guint           begin,
+                                guint           end)
+{
+  guint length;
+
+  g_assert (EDITOR_IS_DOCUMENT (self));
+  g_assert (self->bulk_edit_count > 0);
+  g_assert (self->bulk_region != NULL);
+  g_assert (begin <= end);
+
+  /* Include the characters around the edit so that words which were
+   * joined or split by a deletion are checked again too.
+   */
+  length = _cjh_text_region_get_length (self->bulk_region);
+  begin = begin > 0 ? begin - 1 : 0;
+  end = MIN (end + 1, length);
+
+  if (begin < end)
+    _cjh_text_region_replace (self->bulk_region, begin, end - begin, BULK_EDITED);
+}
+
 static void
 editor_document_insert_text (GtkTextBuffer *buffer,
                              GtkTextIter   *pos,
@@ -234,6 +320,15 @@ editor_document_insert_text (GtkTextBuffer *buffer,
 
   GTK_TEXT_BUFFER_CLASS (editor_document_parent_class)->insert_text (buffer, pos, new_text, new_text_length);
 
+  /* Everything else is deferred until the bulk edit completes */
+  if (self->bulk_edit_count > 0)
+    {
+      if (length > 0)
+        _cjh_text_region_insert (self->bulk_region, offset, length, BULK_EDITED);
+      editor_document_add_bulk_range (self, offset, offset + length);
+      return;
+    }
+
   if (length > 0)
     editor_text_buffer_spell_adapter_after_insert_text (self->spell_adapter, offset, length);
 
@@ -266,6 +361,14 @@ editor_document_delete_range (GtkTextBuffer *buffer,
 
   GTK_TEXT_BUFFER_CLASS (editor_document_parent_class)->delete_range (buffer, start, end);
 
+  if (self->bulk_edit_count > 0)
+    {
+      if (length > 0)
+        _cjh_text_region_remove (self->bulk_region, offset, length);
+      editor_document_add_bulk_range (self, offset, offset);
+      return;
+    }
+
   if (length > 0)
     editor_text_buffer_spell_adapter_after_delete_range (self->spell_adapter, offset, length);
 
@@ -341,18 +444,50 @@ editor_document_monitor_notify_changed_cb (EditorDocument      *self,
   _editor_document_set_externally_modified (self, changed);
 }
 
-static void
-on_cursor_moved_cb (EditorDocument *self)
+static gboolean
+editor_document_cursor_changed_cb (gpointer data)
 {
+  EditorDocument *self = data;
   GtkTextMark *mark;
   GtkTextIter iter;
 
+  g_assert (EDITOR_IS_DOCUMENT (self));
+
+  self->last_cursor_changed = g_get_monotonic_time ();
+
   mark = gtk_text_buffer_get_insert (GTK_TEXT_BUFFER (self));
   gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (self), &iter, mark);
 
-  editor_text_buffer_spell_adapter_cursor_moved (self->spell_adapter,
-                                                 gtk_text_iter_get_offset (&iter));
+  self->cursor.offset = gtk_text_iter_get_offset (&iter);
+  self->cursor.line = gtk_text_iter_get_line (&iter);
+  self->cursor.line_offset = gtk_text_iter_get_line_offset (&iter);
+
+  editor_text_buffer_spell_adapter_cursor_moved (self->spell_adapter, self->cursor.offset);
+
+  g_signal_emit (self, signals [CURSOR_CHANGED], 0, &self->cursor);
 
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+on_cursor_moved_cb (EditorDocument *self)
+{
+  if (self->bulk_edit_count > 0)
+    return;
+
+  if (self->cursor_changed_source == NULL)
+    self->cursor_changed_source =
+      _editor_ready_time_source_new ("[editor] document cursor changed",
+                                     G_PRIORITY_HIGH_IDLE,
+                                     editor_document_cursor_changed_cb,
+                                     self);
+
+  /* Already armed for the next frame */
+  if (g_source_get_ready_time (self->cursor_changed_source) != -1)
+    return;
+
+  g_source_set_ready_time (self->cursor_changed_source,
+                           self->last_cursor_changed + CURSOR_CHANGED_USEC);
 }
 
 static gboolean
@@ -389,6 +524,9 @@ editor_document_constructed (GObject *object)
                                 self->spell_adapter, "enabled",
                                 G_SETTINGS_BIND_GET,
                                 apply_spellcheck_mapping, NULL, self, NULL);
+  g_settings_bind (shared_settings, "spellcheck-languages",
+                   self->spell_adapter, "extra-languages",
+                   G_SETTINGS_BIND_GET);
 }
 
 static void
@@ -396,11 +534,18 @@ editor_document_finalize (GObject *object)
 {
   EditorDocument *self = (EditorDocument *)object;
 
+  if (self->cursor_changed_source != NULL)
+    {
+      g_source_destroy (self->cursor_changed_source);
+      g_clear_pointer (&self->cursor_changed_source, g_source_unref);
+    }
+
   g_clear_object (&self->monitor);
   g_clear_object (&self->file);
   g_clear_object (&self->spell_checker);
   g_clear_object (&self->spell_adapter);
   g_clear_pointer (&self->draft_id, g_free);
+  g_clear_pointer (&self->bulk_region, _cjh_text_region_free);
 
   G_OBJECT_CLASS (editor_document_parent_class)->finalize (object);
 }
@@ -525,6 +670,26 @@ editor_document_class_init (EditorDocumentClass *klass)
                          (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_properties (object_class, N_PROPS, properties);
+
+  /**
+   * EditorDocument::cursor-changed:
+   * @self: an #EditorDocument
+   * @cursor: (type gpointer): an #EditorDocumentCursor
+   *
+   * Emitted at most once per frame after the insertion cursor has moved.
+   *
+   * Unlike #GtkSourceBuffer::cursor-moved, the position of the cursor is
+   * resolved once and shared with every handler. It is not emitted during
+   * bulk edits.
+   */
+  signals [CURSOR_CHANGED] =
+    g_signal_new ("cursor-changed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL,
+                  G_TYPE_NONE,
+                  1,
+                  G_TYPE_POINTER);
 }
 
 static void
@@ -914,6 +1079,7 @@ _editor_document_save_async (EditorDocument      *self,
   gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (self), &iter, insert);
 
   save = g_slice_new0 (Save);
+  save->begin_time = g_get_monotonic_time ();
   save->line = gtk_text_iter_get_line (&iter);
   save->line_offset = gtk_text_iter_get_line_offset (&iter);
   save->position = g_strdup_printf ("%u:%u", save->line, save->line_offset);
@@ -1031,6 +1197,113 @@ _editor_document_unmark_busy (EditorDocument *self)
     }
 }
 
+/**
+ * _editor_document_begin_bulk_edit:
+ * @self: an #EditorDocument
+ *
+ * Starts a series of edits, such as replacing every search result, for
+ * which spellchecking, title and modeline updates should only happen
+ * once after the last edit rather than for every insertion and deletion.
+ *
+ * Call _editor_document_end_bulk_edit() when done. Both calls should be
+ * made within the same user action so that the edits are undone together
+ * and so that deferred work is flushed by the time the user action ends.
+ */
+void
+_editor_document_begin_bulk_edit (EditorDocument *self)
+{
+  g_return_if_fail (EDITOR_IS_DOCUMENT (self));
+
+  if (self->bulk_edit_count++ == 0)
+    {
+      guint length = gtk_text_buffer_get_char_count (GTK_TEXT_BUFFER (self));
+
+      self->bulk_region = _cjh_text_region_new (join_bulk_cb, NULL);
+
+      if (length > 0)
+        _cjh_text_region_insert (self->bulk_region, 0, length, BULK_CLEAN);
+    }
+}
+
+static gboolean
+invalidate_bulk_range_cb (gsize                   offset,
+                          const CjhTextRegionRun *run,
+                          gpointer                user_data)
+{
+  EditorDocument *self = user_data;
+
+  if (run->data == BULK_EDITED)
+    editor_text_buffer_spell_adapter_invalidate_range (self->spell_adapter, offset, run->length);
+
+  return FALSE;
+}
+
+static gboolean
+get_first_bulk_range_cb (gsize                   offset,
+                         const CjhTextRegionRun *run,
+                         gpointer                user_data)
+{
+  guint *first = user_data;
+
+  if (run->data == BULK_EDITED)
+    {
+      *first = offset;
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+void
+_editor_document_end_bulk_edit (EditorDocument *self)
+{
+  GtkTextIter begin;
+  guint begin_offset;
+
+  g_return_if_fail (EDITOR_IS_DOCUMENT (self));
+  g_return_if_fail (self->bulk_edit_count > 0);
+
+  if (--self->bulk_edit_count > 0)
+    return;
+
+  /* Only what was edited is checked again, rather than everything
+   * between the first and last edit of a replace-all.
+   */
+  begin_offset = G_MAXUINT;
+  _cjh_text_region_foreach (self->bulk_region, get_first_bulk_range_cb, &begin_offset);
+  if (begin_offset != G_MAXUINT)
+    _cjh_text_region_foreach (self->bulk_region, invalidate_bulk_range_cb, self);
+  g_clear_pointer (&self->bulk_region, _cjh_text_region_free);
+
+  /* Nothing was edited */
+  if (begin_offset == G_MAXUINT)
+    return;
+
+  if (begin_offset < TITLE_MAX_LEN && editor_document_get_file (self) == NULL)
+    g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_TITLE]);
+
+  gtk_text_buffer_get_iter_at_offset (GTK_TEXT_BUFFER (self), &begin, begin_offset);
+  if (self->busy_count == 0 && gtk_text_iter_get_line (&begin) == 0)
+    editor_document_guess_content_type (self);
+
+  on_cursor_moved_cb (self);
+}
+
+/**
+ * _editor_document_get_bulk_editing:
+ * @self: an #EditorDocument
+ *
+ * Returns: %TRUE if a bulk edit is in progress. See
+ *   _editor_document_begin_bulk_edit().
+ */
+gboolean
+_editor_document_get_bulk_editing (EditorDocument *self)
+{
+  g_return_val_if_fail (EDITOR_IS_DOCUMENT (self), FALSE);
+
+  return self->bulk_edit_count > 0;
+}
+
 gboolean
 editor_document_get_busy (EditorDocument *self)
 {
@@ -1146,12 +1419,14 @@ editor_document_load_cb (GObject      *object,
   g_autoptr(GError) error = NULL;
   g_autoptr(GTask) task = user_data;
   EditorDocument *self;
+  Load *load;
 
   g_assert (GTK_SOURCE_IS_FILE_LOADER (loader));
   g_assert (G_IS_ASYNC_RESULT (result));
   g_assert (G_IS_TASK (task));
 
   self = g_task_get_source_object (task);
+  load = g_task_get_task_data (task);
   self->needs_autosave = FALSE;
 
   if (!gtk_source_file_loader_load_finish (loader, result, &error))
@@ -1184,7 +1459,7 @@ editor_document_load_cb (GObject      *object,
                                G_FILE_ATTRIBUTE_FILESYSTEM_READONLY","
                                METATDATA_CURSOR,
                                G_FILE_QUERY_INFO_NONE,
-                               G_PRIORITY_DEFAULT,
+                               load->io_priority,
                                g_task_get_cancellable (task),
                                editor_document_query_info_cb,
                                g_object_ref (task));
@@ -1244,7 +1519,7 @@ editor_document_do_load (EditorDocument *self,
     }
 
   gtk_source_file_loader_load_async (loader,
-                                     G_PRIORITY_DEFAULT,
+                                     load->io_priority,
                                      g_task_get_cancellable (task),
                                      editor_document_progress,
                                      self,
@@ -1385,7 +1660,7 @@ editor_document_load_file_mount_cb (GObject      *object,
                            G_FILE_ATTRIBUTE_STANDARD_SIZE","
                            G_FILE_ATTRIBUTE_TIME_MODIFIED,
                            G_FILE_QUERY_INFO_NONE,
-                           G_PRIORITY_DEFAULT,
+                           load->io_priority,
                            g_task_get_cancellable (task),
                            editor_document_load_file_info_cb,
                            g_object_ref (task));
@@ -1405,6 +1680,7 @@ editor_document_load_completed_cb (EditorDocument *self,
 void
 _editor_document_load_async (EditorDocument      *self,
                              EditorWindow        *window,
+                             gint                 io_priority,
                              GCancellable        *cancellable,
                              GAsyncReadyCallback  callback,
                              gpointer             user_data)
@@ -1423,6 +1699,8 @@ _editor_document_load_async (EditorDocument      *self,
   file = editor_document_get_file (self);
 
   load = g_slice_new0 (Load);
+  load->begin_time = g_get_monotonic_time ();
+  load->io_priority = io_priority;
   load->file = file ? g_file_dup (file) : NULL;
   load->draft_file = editor_document_get_draft_file (self);
 
@@ -1468,7 +1746,7 @@ _editor_document_load_async (EditorDocument      *self,
                            G_FILE_ATTRIBUTE_STANDARD_SIZE","
                            G_FILE_ATTRIBUTE_TIME_MODIFIED,
                            G_FILE_QUERY_INFO_NONE,
-                           G_PRIORITY_DEFAULT,
+                           load->io_priority,
                            cancellable,
                            editor_document_load_draft_info_cb,
                            g_object_ref (task));
@@ -1499,6 +1777,14 @@ _editor_document_load_finish (EditorDocument  *self,
   return g_task_propagate_boolean (G_TASK (result), error);
 }
 
+gboolean
+_editor_document_get_loading (EditorDocument *self)
+{
+  g_return_val_if_fail (EDITOR_IS_DOCUMENT (self), FALSE);
+
+  return self->loading;
+}
+
 static void
 editor_document_guess_language_query_cb (GObject      *object,
                                          GAsyncResult *result,
@@ -1847,53 +2133,72 @@ _editor_document_attach_actions (EditorDocument *self,
   gtk_widget_insert_action_group (widget, "spelling", G_ACTION_GROUP (group));
 }
 
-gboolean
-_editor_document_check_spelling (EditorDocument *self,
-                                 const char     *word)
+/**
+ * _editor_document_get_spell_checker_at:
+ * @self: an #EditorDocument
+ * @location: (nullable): a #GtkTextIter or %NULL
+ *
+ * Gets the spell checker for the paragraph containing @location, which
+ * may use one of the additional spelling languages.
+ *
+ * Returns: (transfer none) (nullable): an #EditorSpellChecker
+ */
+EditorSpellChecker *
+_editor_document_get_spell_checker_at (EditorDocument    *self,
+                                       const GtkTextIter *location)
 {
-  g_return_val_if_fail (EDITOR_IS_DOCUMENT (self), FALSE);
+  g_return_val_if_fail (EDITOR_IS_DOCUMENT (self), NULL);
 
-  if (self->spell_checker != NULL)
-    return editor_spell_checker_check_word (self->spell_checker, word, -1);
+  if (location == NULL || self->spell_checker == NULL)
+    return self->spell_checker;
 
-  return TRUE;
+  return editor_text_buffer_spell_adapter_get_checker_at (self->spell_adapter,
+                                                          gtk_text_iter_get_offset (location));
 }
 
-char **
-_editor_document_list_corrections (EditorDocument *self,
-                                   const char     *word)
+gboolean
+_editor_document_check_spelling (EditorDocument    *self,
+                                 const GtkTextIter *location,
+                                 const char        *word)
 {
-  g_return_val_if_fail (EDITOR_IS_DOCUMENT (self), NULL);
-  g_return_val_if_fail (word != NULL, NULL);
+  EditorSpellChecker *spell_checker;
 
-  if (self->spell_checker == NULL)
-    return NULL;
+  g_return_val_if_fail (EDITOR_IS_DOCUMENT (self), FALSE);
 
-  return editor_spell_checker_list_corrections (self->spell_checker, word);
+  if ((spell_checker = _editor_document_get_spell_checker_at (self, location)))
+    return editor_spell_checker_check_word (spell_checker, word, -1);
+
+  return TRUE;
 }
 
 void
-_editor_document_add_spelling (EditorDocument *self,
-                               const char     *word)
+_editor_document_add_spelling (EditorDocument    *self,
+                               const GtkTextIter *location,
+                               const char        *word)
 {
+  EditorSpellChecker *spell_checker;
+
   g_return_if_fail (EDITOR_IS_DOCUMENT (self));
 
-  if (self->spell_checker != NULL)
+  if ((spell_checker = _editor_document_get_spell_checker_at (self, location)))
     {
-      editor_spell_checker_add_word (self->spell_checker, word);
+      editor_spell_checker_add_word (spell_checker, word);
       editor_text_buffer_spell_adapter_invalidate_all (self->spell_adapter);
     }
 }
 
 void
-_editor_document_ignore_spelling (EditorDocument *self,
-                                  const char     *word)
+_editor_document_ignore_spelling (EditorDocument    *self,
+                                  const GtkTextIter *location,
+                                  const char        *word)
 {
+  EditorSpellChecker *spell_checker;
+
   g_return_if_fail (EDITOR_IS_DOCUMENT (self));
 
-  if (self->spell_checker != NULL)
+  if ((spell_checker = _editor_document_get_spell_checker_at (self, location)))
     {
-      editor_spell_checker_ignore_word (self->spell_checker, word);
+      editor_spell_checker_ignore_word (spell_checker, word);
       editor_text_buffer_spell_adapter_invalidate_all (self->spell_adapter);
     }
 }
@@ -0,0 +1,468 @@
+/* editor-export.c
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "editor-export"
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include <glib/gi18n.h>
+#include <gtksourceview/gtksource.h>
+
+#include "editor-export-private.h"
+#include "editor-print-operation-private.h"
+
+typedef struct
+{
+  GMainLoop *main_loop;
+  GError    *error;
+} EditorExportLoad;
+
+static void
+editor_export_load_cb (GObject      *object,
+                       GAsyncResult *result,
+                       gpointer      user_data)
+{
+  GtkSourceFileLoader *loader = (GtkSourceFileLoader *)object;
+  EditorExportLoad *load = user_data;
+
+  g_assert (GTK_SOURCE_IS_FILE_LOADER (loader));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (load != NULL);
+
+  gtk_source_file_loader_load_finish (loader, result, &load->error);
+  g_main_loop_quit (load->main_loop);
+}
+
+static gboolean
+editor_export_paginate_cb (GtkPrintOperation        *operation,
+                           GtkPrintContext          *context,
+                           GtkSourcePrintCompositor *compositor)
+{
+  g_assert (GTK_IS_PRINT_OPERATION (operation));
+  g_assert (GTK_IS_PRINT_CONTEXT (context));
+  g_assert (GTK_SOURCE_IS_PRINT_COMPOSITOR (compositor));
+
+  /* Nothing else needs the main loop, so paginate in one go */
+  while (!gtk_source_print_compositor_paginate (compositor, context))
+    continue;
+
+  gtk_print_operation_set_n_pages (operation,
+                                   gtk_source_print_compositor_get_n_pages (compositor));
+
+  return TRUE;
+}
+
+static void
+editor_export_draw_page_cb (GtkPrintOperation        *operation,
+                            GtkPrintContext          *context,
+                            int                       page_nr,
+                            GtkSourcePrintCompositor *compositor)
+{
+  g_assert (GTK_IS_PRINT_OPERATION (operation));
+  g_assert (GTK_IS_PRINT_CONTEXT (context));
+  g_assert (GTK_SOURCE_IS_PRINT_COMPOSITOR (compositor));
+
+  gtk_source_print_compositor_draw_page (compositor, context, page_nr);
+}
+
+static GtkSourceStyleScheme *
+editor_export_get_style_scheme (GSettings *settings)
+{
+  GtkSourceStyleSchemeManager *manager;
+  GtkSourceStyleScheme *style_scheme;
+  g_autofree char *style_scheme_id = NULL;
+
+  g_assert (G_IS_SETTINGS (settings));
+
+  manager = gtk_source_style_scheme_manager_get_default ();
+  style_scheme_id = g_settings_get_string (settings, "style-scheme");
+
+  if (!(style_scheme = gtk_source_style_scheme_manager_get_scheme (manager, style_scheme_id)))
+    style_scheme = gtk_source_style_scheme_manager_get_scheme (manager, "Adwaita");
+
+  return style_scheme;
+}
+
+static GFile *
+editor_export_find_root (GPtrArray *files)
+{
+  g_autoptr(GFile) root = NULL;
+
+  g_assert (files != NULL);
+  g_assert (files->len > 0);
+
+  /* Find the closest directory containing every file */
+  root = g_file_get_parent (g_ptr_array_index (files, 0));
+
+  for (guint i = 1; i < files->len && root != NULL; i++)
+    {
+      GFile *file = g_ptr_array_index (files, i);
+
+      while (root != NULL && !g_file_has_prefix (file, root))
+        {
+          GFile *parent = g_file_get_parent (root);
+          g_object_unref (root);
+          root = parent;
+        }
+    }
+
+  return g_steal_pointer (&root);
+}
+
+static gboolean
+editor_export_file (GSettings   *settings,
+                    GFile       *file,
+                    GFile       *root,
+                    const char  *directory,
+                    GError     **error)
+{
+  g_autoptr(GtkSourceBuffer) buffer = NULL;
+  g_autoptr(GtkSourceFile) source_file = NULL;
+  g_autoptr(GtkSourceFileLoader) loader = NULL;
+  g_autoptr(GtkSourcePrintCompositor) compositor = NULL;
+  g_autoptr(GtkPrintOperation) operation = NULL;
+  g_autoptr(GFileInfo) info = NULL;
+  g_autofree char *basename = NULL;
+  g_autofree char *relative_path = NULL;
+  g_autofree char *pdf_name = NULL;
+  g_autofree char *pdf_path = NULL;
+  g_autofree char *pdf_dir = NULL;
+  GtkSourceLanguage *language;
+  const char *content_type = NULL;
+  EditorExportLoad load = {0};
+
+  g_assert (G_IS_SETTINGS (settings));
+  g_assert (G_IS_FILE (file));
+  g_assert (G_IS_FILE (root));
+  g_assert (directory != NULL);
+
+  /* Mirror the layout of the files so that files with the same name
+   * in different directories do not overwrite each other.
+   */
+  if (!(relative_path = g_file_get_relative_path (root, file)))
+    {
+      g_set_error_literal (error,
+                           G_IO_ERROR,
+                           G_IO_ERROR_INVALID_ARGUMENT,
+                           _("File is not within the exported directory"));
+      return FALSE;
+    }
+
+  pdf_name = g_strdup_printf ("%s.pdf", relative_path);
+  pdf_path = g_build_filename (directory, pdf_name, NULL);
+  pdf_dir = g_path_get_dirname (pdf_path);
+
+  if (g_mkdir_with_parents (pdf_dir, 0750) != 0)
+    {
+      int errsv = errno;
+      g_set_error (error,
+                   G_IO_ERROR,
+                   g_io_error_from_errno (errsv),
+                   "%s: %s", pdf_dir, g_strerror (errsv));
+      return FALSE;
+    }
+
+  buffer = gtk_source_buffer_new (NULL);
+  source_file = gtk_source_file_new ();
+  gtk_source_file_set_location (source_file, file);
+  loader = gtk_source_file_loader_new (buffer, source_file);
+
+  load.main_loop = g_main_loop_new (NULL, FALSE);
+  gtk_source_file_loader_load_async (loader,
+                                     G_PRIORITY_DEFAULT,
+                                     NULL, NULL, NULL, NULL,
+                                     editor_export_load_cb,
+                                     &load);
+  g_main_loop_run (load.main_loop);
+  g_main_loop_unref (load.main_loop);
+
+  if (load.error != NULL)
+    {
+      g_propagate_error (error, load.error);
+      return FALSE;
+    }
+
+  basename = g_file_get_basename (file);
+
+  if ((info = g_file_query_info (file,
+                                 G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE,
+                                 G_FILE_QUERY_INFO_NONE,
+                                 NULL, NULL)))
+    content_type = g_file_info_get_content_type (info);
+
+  language = gtk_source_language_manager_guess_language (gtk_source_language_manager_get_default (),
+                                                         basename,
+                                                         content_type);
+  gtk_source_buffer_set_language (buffer, language);
+  gtk_source_buffer_set_style_scheme (buffer, editor_export_get_style_scheme (settings));
+
+  compositor = _editor_print_operation_create_compositor (buffer,
+                                                          g_settings_get_uint (settings, "tab-width"));
+
+  operation = gtk_print_operation_new ();
+  gtk_print_operation_set_job_name (operation, basename);
+  gtk_print_operation_set_export_filename (operation, pdf_path);
+  g_signal_connect (operation,
+                    "paginate",
+                    G_CALLBACK (editor_export_paginate_cb),
+                    compositor);
+  g_signal_connect (operation,
+                    "draw-page",
+                    G_CALLBACK (editor_export_draw_page_cb),
+                    compositor);
+
+  return gtk_print_operation_run (operation,
+                                  GTK_PRINT_OPERATION_ACTION_EXPORT,
+                                  NULL,
+                                  error) != GTK_PRINT_OPERATION_RESULT_ERROR;
+}
+
+static int
+editor_export_run_jobs (const char         *argv0,
+                        const char         *directory,
+                        GFile              *root,
+                        const char * const *files,
+                        guint               n_files,
+                        guint               n_jobs)
+{
+  g_autoptr(GPtrArray) subprocesses = NULL;
+  g_autofree char *program = NULL;
+  g_autofree char *export_arg = NULL;
+  g_autofree char *root_uri = NULL;
+  g_autofree char *root_arg = NULL;
+  int ret = EXIT_SUCCESS;
+
+  g_assert (argv0 != NULL);
+  g_assert (directory != NULL);
+  g_assert (G_IS_FILE (root));
+  g_assert (files != NULL);
+  g_assert (n_jobs > 1);
+
+  /* GTK may only be used from the main thread, so spread the files
+   * across worker processes which each export their share serially.
+   */
+  if (!(program = g_file_read_link ("/proc/self/exe", NULL)))
+    program = g_strdup (argv0);
+
+  export_arg = g_strdup_printf ("--export-pdf=%s", directory);
+
+  /* Workers only see their share of the files, so pass along the
+   * directory their output paths are relative to.
+   */
+  root_uri = g_file_get_uri (root);
+  root_arg = g_strdup_printf ("--export-root=%s", root_uri);
+  subprocesses = g_ptr_array_new_with_free_func (g_object_unref);
+
+  for (guint job = 0; job < n_jobs; job++)
+    {
+      g_autoptr(GPtrArray) argv = g_ptr_array_new ();
+      g_autoptr(GError) error = NULL;
+      GSubprocess *subprocess;
+
+      g_ptr_array_add (argv, program);
+      g_ptr_array_add (argv, export_arg);
+      g_ptr_array_add (argv, root_arg);
+      g_ptr_array_add (argv, (char *)"--jobs=1");
+      g_ptr_array_add (argv, (char *)"--");
+      for (guint i = job; i < n_files; i += n_jobs)
+        g_ptr_array_add (argv, (char *)files[i]);
+      g_ptr_array_add (argv, NULL);
+
+      if (!(subprocess = g_subprocess_newv ((const char * const *)argv->pdata,
+                                            G_SUBPROCESS_FLAGS_NONE,
+                                            &error)))
+        {
+          g_printerr ("%s\n", error->message);
+          ret = EXIT_FAILURE;
+          continue;
+        }
+
+      g_ptr_array_add (subprocesses, subprocess);
+    }
+
+  for (guint i = 0; i < subprocesses->len; i++)
+    {
+      GSubprocess *subprocess = g_ptr_array_index (subprocesses, i);
+
+      if (!g_subprocess_wait_check (subprocess, NULL, NULL))
+        ret = EXIT_FAILURE;
+    }
+
+  return ret;
+}
+
+/**
+ * _editor_export_requested:
+ * @argc: the number of arguments
+ * @argv: the command line arguments
+ *
+ * Checks if the command line asks for a headless export, in which case
+ * _editor_export_main() should be used instead of the application.
+ *
+ * Returns: %TRUE if `--export-pdf` was provided
+ */
+gboolean
+_editor_export_requested (int    argc,
+                          char **argv)
+{
+  for (int i = 1; i < argc; i++)
+    {
+      if (g_str_equal (argv[i], "--"))
+        break;
+
+      if (g_str_equal (argv[i], "--export-pdf") ||
+          g_str_has_prefix (argv[i], "--export-pdf="))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+/**
+ * _editor_export_main:
+ * @argc: the number of arguments
+ * @argv: the command line arguments
+ *
+ * Exports the files on the command line to PDF without registering the
+ * application or creating any windows. Files are exported in parallel by
+ * worker processes unless `--jobs=1` is provided.
+ *
+ * The output mirrors the location of each file relative to the closest
+ * directory containing all of them, so that files sharing a name do not
+ * overwrite each other. Files listed more than once are exported once.
+ *
+ * Returns: the exit status for the process
+ */
+int
+_editor_export_main (int    argc,
+                     char **argv)
+{
+  g_autoptr(GOptionContext) context = NULL;
+  g_autoptr(GSettings) settings = NULL;
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GHashTable) seen = NULL;
+  g_autoptr(GPtrArray) unique = NULL;
+  g_autoptr(GPtrArray) gfiles = NULL;
+  g_autoptr(GFile) root = NULL;
+  g_autofree char *directory = NULL;
+  g_autofree char *export_root = NULL;
+  g_auto(GStrv) files = NULL;
+  int n_jobs = 0;
+  guint n_files;
+  int ret = EXIT_SUCCESS;
+  const GOptionEntry entries[] = {
+    { "export-pdf", 0, 0, G_OPTION_ARG_FILENAME, &directory,
+      N_("Export files as PDF into DIRECTORY without opening a window"), N_("DIRECTORY") },
+    { "export-root", 0, G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_FILENAME, &export_root,
+      NULL, NULL },
+    { "jobs", 'j', 0, G_OPTION_ARG_INT, &n_jobs,
+      N_("Number of files to export in parallel"), N_("N") },
+    { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &files,
+      NULL, N_("FILES…") },
+    { NULL }
+  };
+
+  context = g_option_context_new (NULL);
+  g_option_context_add_main_entries (context, entries, GETTEXT_PACKAGE);
+
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+
+  if (files == NULL || files[0] == NULL)
+    {
+      g_printerr ("%s\n", _("No files to export"));
+      return EXIT_FAILURE;
+    }
+
+  if (g_mkdir_with_parents (directory, 0750) != 0)
+    {
+      int errsv = errno;
+      g_printerr ("%s: %s\n", directory, g_strerror (errsv));
+      return EXIT_FAILURE;
+    }
+
+  gfiles = g_ptr_array_new_with_free_func (g_object_unref);
+  unique = g_ptr_array_new ();
+  seen = g_hash_table_new ((GHashFunc) g_file_hash, (GEqualFunc) g_file_equal);
+
+  for (guint i = 0; files[i]; i++)
+    {
+      GFile *file = g_file_new_for_commandline_arg (files[i]);
+
+      g_ptr_array_add (gfiles, file);
+
+      if (g_hash_table_add (seen, file))
+        g_ptr_array_add (unique, GUINT_TO_POINTER (i));
+      else
+        g_printerr ("%s: %s\n", files[i], _("Listed more than once, exporting it once"));
+    }
+
+  if (export_root != NULL)
+    root = g_file_new_for_commandline_arg (export_root);
+  else if (!(root = editor_export_find_root (gfiles)))
+    {
+      g_printerr ("%s\n", _("Files to export must share a common directory"));
+      return EXIT_FAILURE;
+    }
+
+  n_files = unique->len;
+
+  if (n_jobs <= 0)
+    n_jobs = g_get_num_processors ();
+
+  if ((guint)n_jobs > n_files)
+    n_jobs = n_files;
+
+  if (n_jobs > 1)
+    {
+      g_autofree const char **job_files = g_new0 (const char *, n_files + 1);
+
+      for (guint i = 0; i < n_files; i++)
+        job_files[i] = files[GPOINTER_TO_UINT (g_ptr_array_index (unique, i))];
+
+      return editor_export_run_jobs (argv[0], directory, root, job_files, n_files, n_jobs);
+    }
+
+  settings = g_settings_new ("org.gnome.TextEditor");
+
+  for (guint i = 0; i < n_files; i++)
+    {
+      guint index = GPOINTER_TO_UINT (g_ptr_array_index (unique, i));
+      g_autoptr(GError) export_error = NULL;
+
+      if (!editor_export_file (settings,
+                               g_ptr_array_index (gfiles, index),
+                               root,
+                               directory,
+                               &export_error))
+        {
+          g_printerr ("%s: %s\n", files[index], export_error->message);
+          ret = EXIT_FAILURE;
+        }
+    }
+
+  return ret;
+}
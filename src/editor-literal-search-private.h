@@ -0,0 +1,44 @@
+/* editor-literal-search-private.h
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct
+{
+  /*< private >*/
+  const char *needle;
+  gsize       needle_len;
+  guint8      first;
+  guint8      last;
+  guint       case_insensitive : 1;
+} EditorLiteralSearch;
+
+gboolean    _editor_literal_search_init (EditorLiteralSearch       *search,
+                                         const char                *needle,
+                                         gboolean                   case_sensitive);
+const char *_editor_literal_search_find (const EditorLiteralSearch *search,
+                                         const char                *haystack,
+                                         gsize                      haystack_len);
+
+G_END_DECLS
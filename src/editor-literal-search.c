@@ -0,0 +1,205 @@
+/* editor-literal-search.c
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "editor-literal-search"
+
+#include "config.h"
+
+#include <string.h>
+
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
+#include "editor-literal-search-private.h"
+
+/*
+ * A substring search over UTF-8 text for plain (non-regex) queries.
+ *
+ * Candidates are found by comparing both the first and the last byte
+ * of the needle against 16 positions at a time and are then verified
+ * with a full comparison. Without SSE2 we fall back to memchr() on the
+ * first byte, which libc vectorizes for us.
+ *
+ * Case-insensitive searches are only supported for ASCII needles. The
+ * prefilter sets the 0x20 bit on both sides, which maps upper and lower
+ * case ASCII letters together. That can produce extra candidates for
+ * non-letters but never misses one, and the verification step uses a
+ * real ASCII case-insensitive comparison.
+ */
+
+static inline gboolean
+verify (const EditorLiteralSearch *search,
+        const char                *pos)
+{
+  if (search->case_insensitive)
+    return g_ascii_strncasecmp (pos, search->needle, search->needle_len) == 0;
+  else
+    return memcmp (pos, search->needle, search->needle_len) == 0;
+}
+
+/**
+ * _editor_literal_search_init:
+ * @search: an #EditorLiteralSearch to initialize
+ * @needle: the text to search for, which must outlive @search
+ * @case_sensitive: if the search is case-sensitive
+ *
+ * Prepares @search for use with _editor_literal_search_find().
+ *
+ * Returns: %FALSE if @needle cannot be searched with this fast path,
+ *   which is the case for empty needles and for case-insensitive
+ *   searches of non-ASCII needles.
+ */
+gboolean
+_editor_literal_search_init (EditorLiteralSearch *search,
+                             const char          *needle,
+                             gboolean             case_sensitive)
+{
+  g_return_val_if_fail (search != NULL, FALSE);
+
+  memset (search, 0, sizeof *search);
+
+  if (needle == NULL || needle[0] == 0)
+    return FALSE;
+
+  search->needle = needle;
+  search->needle_len = strlen (needle);
+  search->case_insensitive = !case_sensitive;
+
+  if (search->case_insensitive)
+    {
+      for (gsize i = 0; i < search->needle_len; i++)
+        {
+          if ((guint8)needle[i] >= 0x80)
+            return FALSE;
+        }
+
+      search->first = (guint8)needle[0] | 0x20;
+      search->last = (guint8)needle[search->needle_len - 1] | 0x20;
+    }
+  else
+    {
+      search->first = (guint8)needle[0];
+      search->last = (guint8)needle[search->needle_len - 1];
+    }
+
+  return TRUE;
+}
+
+static const char *
+find_scalar (const EditorLiteralSearch *search,
+             const char                *haystack,
+             const char                *end)
+{
+  const char *pos = haystack;
+
+  if (end - pos < (gssize)search->needle_len)
+    return NULL;
+
+  /* Last position a match may begin at */
+  end -= search->needle_len - 1;
+
+  if (!search->case_insensitive)
+    {
+      while ((pos = memchr (pos, search->first, end - pos)))
+        {
+          if (verify (search, pos))
+            return pos;
+          pos++;
+        }
+
+      return NULL;
+    }
+
+  for (; pos < end; pos++)
+    {
+      if (((guint8)*pos | 0x20) == search->first && verify (search, pos))
+        return pos;
+    }
+
+  return NULL;
+}
+
+#ifdef __SSE2__
+static const char *
+find_sse2 (const EditorLiteralSearch *search,
+           const char                *haystack,
+           const char                *end)
+{
+  const __m128i first = _mm_set1_epi8 ((char)search->first);
+  const __m128i last = _mm_set1_epi8 ((char)search->last);
+  const __m128i fold = _mm_set1_epi8 (search->case_insensitive ? 0x20 : 0);
+  const gsize n = search->needle_len;
+  const char *pos = haystack;
+
+  while (end - pos >= (gssize)(n - 1 + 16))
+    {
+      __m128i block_first = _mm_loadu_si128 ((const __m128i *)(gconstpointer)pos);
+      __m128i block_last = _mm_loadu_si128 ((const __m128i *)(gconstpointer)(pos + n - 1));
+      __m128i eq_first = _mm_cmpeq_epi8 (first, _mm_or_si128 (block_first, fold));
+      __m128i eq_last = _mm_cmpeq_epi8 (last, _mm_or_si128 (block_last, fold));
+      guint bits = _mm_movemask_epi8 (_mm_and_si128 (eq_first, eq_last));
+
+      while (bits != 0)
+        {
+          guint bit = g_bit_nth_lsf (bits, -1);
+
+          if (verify (search, pos + bit))
+            return pos + bit;
+
+          bits &= bits - 1;
+        }
+
+      pos += 16;
+    }
+
+  return find_scalar (search, pos, end);
+}
+#endif
+
+/**
+ * _editor_literal_search_find:
+ * @search: an #EditorLiteralSearch
+ * @haystack: the text to search
+ * @haystack_len: the length of @haystack in bytes
+ *
+ * Finds the first occurrence of the needle within @haystack.
+ *
+ * Returns: (nullable): a pointer to the start of the match within
+ *   @haystack, or %NULL.
+ */
+const char *
+_editor_literal_search_find (const EditorLiteralSearch *search,
+                             const char                *haystack,
+                             gsize                      haystack_len)
+{
+  g_return_val_if_fail (search != NULL, NULL);
+  g_return_val_if_fail (search->needle != NULL, NULL);
+  g_return_val_if_fail (haystack != NULL || haystack_len == 0, NULL);
+
+  if (haystack_len < search->needle_len)
+    return NULL;
+
+#ifdef __SSE2__
+  return find_sse2 (search, haystack, haystack + haystack_len);
+#else
+  return find_scalar (search, haystack, haystack + haystack_len);
+#endif
+}
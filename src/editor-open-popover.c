@@ -27,21 +27,23 @@
 #include "editor-session-private.h"
 #include "editor-sidebar-item-private.h"
 #include "editor-sidebar-row-private.h"
+#include "editor-sidebar-search-model-private.h"
 #include "editor-window-private.h"
 
 struct _EditorOpenPopover
 {
-  GtkPopover         parent_instance;
-
-  GListModel        *model;
-  GListModel        *filtered_model;
-
-  GtkListBox        *list_box;
-  GtkWidget         *box;
-  GtkSearchEntry    *search_entry;
-  GtkStack          *stack;
-  GtkWidget         *empty;
-  GtkScrolledWindow *recent;
+  GtkPopover                parent_instance;
+
+  GListModel               *model;
+  GListModel               *filtered_model;
+  EditorSidebarSearchModel *search_model;
+
+  GtkListBox               *list_box;
+  GtkWidget                *box;
+  GtkSearchEntry           *search_entry;
+  GtkStack                 *stack;
+  GtkWidget                *empty;
+  GtkScrolledWindow        *recent;
 };
 
 G_DEFINE_TYPE (EditorOpenPopover, editor_open_popover, GTK_TYPE_POPOVER)
@@ -117,27 +119,19 @@ on_list_box_row_activated_cb (EditorOpenPopover *self,
   popover_hide (GTK_WIDGET (self), NULL, NULL);
 }
 
-static gboolean
-editor_sidebar_filter_func_cb (gpointer itemptr,
-                               gpointer user_data)
-{
-  EditorSidebarItem *item = itemptr;
-  const char *search = user_data;
-
-  return _editor_sidebar_item_matches (item, search);
-}
-
 static void
 on_search_entry_changed_cb (EditorOpenPopover *self,
                             GtkSearchEntry    *search_entry)
 {
-  g_autoptr(GtkFilterListModel) filter = NULL;
   const gchar *text;
   GListModel *model;
 
   g_assert (EDITOR_IS_OPEN_POPOVER (self));
   g_assert (GTK_IS_SEARCH_ENTRY (search_entry));
 
+  if (self->model == NULL)
+    return;
+
   text = gtk_editable_get_text (GTK_EDITABLE (search_entry));
 
   if (text == NULL || text[0] == 0)
@@ -146,22 +140,24 @@ on_search_entry_changed_cb (EditorOpenPopover *self,
     }
   else
     {
-      g_autofree gchar *text_fold = g_utf8_casefold (text, -1);
-      g_autoptr(GtkCustomFilter) custom = NULL;
-
-      custom = gtk_custom_filter_new (editor_sidebar_filter_func_cb,
-                                      g_steal_pointer (&text_fold),
-                                      g_free);
-      filter = gtk_filter_list_model_new (g_object_ref (G_LIST_MODEL (self->model)),
-                                          g_object_ref (GTK_FILTER (custom)));
-      gtk_filter_list_model_set_incremental (filter, TRUE);
-      model = G_LIST_MODEL (filter);
+      /* The search model is kept across keystrokes so that it may
+       * refine the previous results as the query grows.
+       */
+      if (self->search_model == NULL)
+        self->search_model = _editor_sidebar_search_model_new (self->model);
+
+      _editor_sidebar_search_model_set_query (self->search_model, text);
+      model = G_LIST_MODEL (self->search_model);
     }
 
   g_assert (model != NULL);
   g_assert (G_IS_LIST_MODEL (model));
 
-  gtk_list_box_bind_model (self->list_box, model, create_row, NULL, NULL);
+  /* The search model emits items-changed itself, so we only need to
+   * rebind when switching between the recent and search models.
+   */
+  if (model != editor_open_popover_get_model (self))
+    gtk_list_box_bind_model (self->list_box, model, create_row, NULL, NULL);
 
   g_set_object (&self->filtered_model, model);
 }
@@ -259,6 +255,7 @@ editor_open_popover_dispose (GObject *object)
   g_clear_pointer (&self->box, gtk_widget_unparent);
   g_clear_object (&self->model);
   g_clear_object (&self->filtered_model);
+  g_clear_object (&self->search_model);
 
   G_OBJECT_CLASS (editor_open_popover_parent_class)->dispose (object);
 }
@@ -389,6 +386,7 @@ _editor_open_popover_set_model (EditorOpenPopover *self,
   if (g_set_object (&self->model, model))
     {
       g_clear_object (&self->filtered_model);
+      g_clear_object (&self->search_model);
 
       if (model != NULL)
         {
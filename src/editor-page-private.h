@@ -62,6 +62,13 @@ struct _EditorPage
   GtkBox                  *statusbar;
   GtkEventController      *vim;
 
+  /* Visual column checkpoints for the line holding the cursor, one
+   * every VISUAL_COLUMN_STRIDE characters.
+   */
+  GArray                  *visual_columns;
+  gint                     visual_columns_line;
+  guint                    visual_columns_tab_width;
+
   guint                    close_requested : 1;
   guint                    moving : 1;
 };
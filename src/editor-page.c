@@ -33,6 +33,8 @@
 #include "editor-source-view.h"
 #include "editor-utils-private.h"
 
+#define VISUAL_COLUMN_STRIDE 1024
+
 enum {
   PROP_0,
   PROP_BUSY,
@@ -121,9 +123,126 @@ editor_page_document_notify_busy_cb (EditorPage     *self,
   g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_TITLE]);
 }
 
+static guint
+count_line_breaks (const char *text,
+                   gint        len)
+{
+  guint n = 0;
+
+  while (len > 0)
+    {
+      gint delimiter;
+      gint next;
+
+      pango_find_paragraph_boundary (text, len, &delimiter, &next);
+
+      if (delimiter == next)
+        break;
+
+      text += next;
+      len -= next;
+      n++;
+    }
+
+  return n;
+}
+
+static gboolean
+joins_line_break (const GtkTextIter *begin,
+                  const GtkTextIter *end)
+{
+  GtkTextIter before = *begin;
+
+  /* Deleting between a "\r" and a "\n" joins them into one line break */
+  return gtk_text_iter_backward_char (&before) &&
+         gtk_text_iter_get_char (&before) == '\r' &&
+         gtk_text_iter_get_char (end) == '\n';
+}
+
 static void
-editor_page_document_cursor_moved_cb (EditorPage     *self,
+editor_page_truncate_visual_columns (EditorPage *self,
+                                     guint       line_offset)
+{
+  guint len = line_offset / VISUAL_COLUMN_STRIDE + 1;
+
+  g_assert (EDITOR_IS_PAGE (self));
+
+  /* Checkpoints up to @line_offset do not depend on what follows */
+  if (self->visual_columns->len > len)
+    g_array_set_size (self->visual_columns, len);
+}
+
+static void
+editor_page_document_insert_text_cb (EditorPage     *self,
+                                     GtkTextIter    *location,
+                                     const char     *text,
+                                     gint            len,
+                                     EditorDocument *document)
+{
+  gint line;
+
+  g_assert (EDITOR_IS_PAGE (self));
+  g_assert (EDITOR_IS_DOCUMENT (document));
+
+  if (self->visual_columns_line < 0)
+    return;
+
+  /* Edits after the cached line cannot change its columns */
+  line = gtk_text_iter_get_line (location);
+
+  if (line == self->visual_columns_line)
+    {
+      editor_page_truncate_visual_columns (self, gtk_text_iter_get_line_offset (location));
+    }
+  else if (line < self->visual_columns_line)
+    {
+      /* A "\r" and "\n" on either side of the insertion would be joined
+       * into a single line break, just start over in that case.
+       */
+      if (len > 0 && (text[0] == '\n' || text[len - 1] == '\r'))
+        self->visual_columns_line = -1;
+      else
+        self->visual_columns_line += count_line_breaks (text, len);
+    }
+}
+
+static void
+editor_page_document_delete_range_cb (EditorPage     *self,
+                                      GtkTextIter    *begin,
+                                      GtkTextIter    *end,
                                       EditorDocument *document)
+{
+  gint begin_line;
+  gint end_line;
+
+  g_assert (EDITOR_IS_PAGE (self));
+  g_assert (EDITOR_IS_DOCUMENT (document));
+
+  if (self->visual_columns_line < 0)
+    return;
+
+  if (gtk_text_iter_compare (begin, end) > 0)
+    {
+      GtkTextIter *tmp = begin;
+      begin = end;
+      end = tmp;
+    }
+
+  begin_line = gtk_text_iter_get_line (begin);
+  end_line = gtk_text_iter_get_line (end);
+
+  if (begin_line == self->visual_columns_line)
+    editor_page_truncate_visual_columns (self, gtk_text_iter_get_line_offset (begin));
+  else if (end_line < self->visual_columns_line && !joins_line_break (begin, end))
+    self->visual_columns_line -= end_line - begin_line;
+  else if (begin_line < self->visual_columns_line)
+    self->visual_columns_line = -1;
+}
+
+static void
+editor_page_document_cursor_changed_cb (EditorPage                 *self,
+                                        const EditorDocumentCursor *cursor,
+                                        EditorDocument             *document)
 {
   g_assert (EDITOR_IS_PAGE (self));
   g_assert (EDITOR_IS_DOCUMENT (document));
@@ -223,8 +342,18 @@ editor_page_set_document (EditorPage     *self,
                                self,
                                G_CONNECT_SWAPPED);
       g_signal_connect_object (document,
-                               "cursor-moved",
-                               G_CALLBACK (editor_page_document_cursor_moved_cb),
+                               "cursor-changed",
+                               G_CALLBACK (editor_page_document_cursor_changed_cb),
+                               self,
+                               G_CONNECT_SWAPPED);
+      g_signal_connect_object (document,
+                               "insert-text",
+                               G_CALLBACK (editor_page_document_insert_text_cb),
+                               self,
+                               G_CONNECT_SWAPPED);
+      g_signal_connect_object (document,
+                               "delete-range",
+                               G_CALLBACK (editor_page_document_delete_range_cb),
                                self,
                                G_CONNECT_SWAPPED);
       g_signal_connect_object (document,
@@ -506,6 +635,7 @@ editor_page_finalize (GObject *object)
   g_clear_object (&self->document);
   g_clear_object (&self->settings);
   g_clear_object (&self->settings_bindings);
+  g_clear_pointer (&self->visual_columns, g_array_unref);
 
   G_OBJECT_CLASS (editor_page_parent_class)->finalize (object);
 }
@@ -706,6 +836,9 @@ editor_page_init (EditorPage *self)
 
   gtk_widget_init_template (GTK_WIDGET (self));
 
+  self->visual_columns = g_array_new (FALSE, FALSE, sizeof (guint));
+  self->visual_columns_line = -1;
+
   _editor_revealer_auto_hide (self->search_revealer);
   _editor_revealer_auto_hide (self->goto_line_revealer);
 
@@ -1115,6 +1248,82 @@ _editor_page_print (EditorPage *self)
   handle_print_result (self, GTK_PRINT_OPERATION (operation), result);
 }
 
+static guint
+advance_visual_column (GtkTextIter *iter,
+                       guint        column,
+                       guint        n_chars,
+                       guint        tab_width)
+{
+  /* Must match gtk_source_view_get_visual_column() */
+  for (guint i = 0; i < n_chars; i++)
+    {
+      if (gtk_text_iter_get_char (iter) == '\t')
+        column += tab_width - (column % tab_width);
+      else
+        column++;
+
+      gtk_text_iter_forward_char (iter);
+    }
+
+  return column;
+}
+
+static guint
+editor_page_get_visual_column (EditorPage        *self,
+                               const GtkTextIter *location)
+{
+  GtkTextIter iter;
+  guint line_offset;
+  guint tab_width;
+  guint column;
+  guint index;
+  gint line;
+
+  g_assert (EDITOR_IS_PAGE (self));
+  g_assert (location != NULL);
+
+  line = gtk_text_iter_get_line (location);
+  line_offset = gtk_text_iter_get_line_offset (location);
+  tab_width = gtk_source_view_get_tab_width (self->view);
+
+  if (line != self->visual_columns_line ||
+      tab_width != self->visual_columns_tab_width)
+    {
+      column = 0;
+      g_array_set_size (self->visual_columns, 0);
+      g_array_append_val (self->visual_columns, column);
+      self->visual_columns_line = line;
+      self->visual_columns_tab_width = tab_width;
+    }
+
+  index = line_offset / VISUAL_COLUMN_STRIDE;
+
+  /* Extend the checkpoints up to the one preceding @location so that
+   * moving around a long line only walks the characters since the
+   * closest checkpoint.
+   */
+  while (self->visual_columns->len <= index)
+    {
+      guint n = self->visual_columns->len - 1;
+
+      iter = *location;
+      gtk_text_iter_set_line_offset (&iter, n * VISUAL_COLUMN_STRIDE);
+      column = advance_visual_column (&iter,
+                                      g_array_index (self->visual_columns, guint, n),
+                                      VISUAL_COLUMN_STRIDE,
+                                      tab_width);
+      g_array_append_val (self->visual_columns, column);
+    }
+
+  iter = *location;
+  gtk_text_iter_set_line_offset (&iter, index * VISUAL_COLUMN_STRIDE);
+
+  return advance_visual_column (&iter,
+                                g_array_index (self->visual_columns, guint, index),
+                                line_offset - index * VISUAL_COLUMN_STRIDE,
+                                tab_width);
+}
+
 void
 editor_page_get_visual_position (EditorPage *self,
                                  guint      *line,
@@ -1134,7 +1343,7 @@ editor_page_get_visual_position (EditorPage *self,
     *line = gtk_text_iter_get_line (&iter);
 
   if (line_column)
-    *line_column = gtk_source_view_get_visual_column (self->view, &iter);
+    *line_column = editor_page_get_visual_column (self, &iter);
 }
 
 gchar *
@@ -1348,6 +1557,7 @@ editor_page_delete_draft_cb (GObject      *object,
     {
       _editor_document_load_async (self->document,
                                    _editor_page_get_window (self),
+                                   G_PRIORITY_DEFAULT,
                                    g_task_get_cancellable (task),
                                    editor_page_discard_reload_cb,
                                    g_object_ref (task));
@@ -25,7 +25,9 @@
 #include <glib/gi18n.h>
 
 #include "editor-document-private.h"
-#include "editor-print-operation.h"
+#include "editor-print-operation-private.h"
+
+#define PAGINATE_BUDGET_USEC 8000
 
 struct _EditorPrintOperation
 {
@@ -33,6 +35,15 @@ struct _EditorPrintOperation
 
   GtkSourceView            *view;
   GtkSourcePrintCompositor *compositor;
+
+  /* The pagination is kept across runs while the buffer and the page
+   * size do not change.
+   */
+  gdouble                   page_width;
+  gdouble                   page_height;
+
+  guint                     paginated : 1;
+  guint                     printing : 1;
 };
 
 G_DEFINE_TYPE (EditorPrintOperation, editor_print_operation, GTK_TYPE_PRINT_OPERATION)
@@ -45,12 +56,49 @@ enum {
 
 static GParamSpec *properties [N_PROPS];
 
+static void
+editor_print_operation_reset (EditorPrintOperation *self)
+{
+  g_assert (EDITOR_IS_PRINT_OPERATION (self));
+
+  g_clear_object (&self->compositor);
+  self->paginated = FALSE;
+}
+
+static void
+editor_print_operation_buffer_changed_cb (EditorPrintOperation *self,
+                                          GtkTextBuffer        *buffer)
+{
+  g_assert (EDITOR_IS_PRINT_OPERATION (self));
+  g_assert (GTK_IS_TEXT_BUFFER (buffer));
+
+  /* The compositor cannot cope with the buffer changing underneath it */
+  if (self->printing)
+    gtk_print_operation_cancel (GTK_PRINT_OPERATION (self));
+  else
+    editor_print_operation_reset (self);
+}
+
+static void
+editor_print_operation_constructed (GObject *object)
+{
+  EditorPrintOperation *self = EDITOR_PRINT_OPERATION (object);
+
+  G_OBJECT_CLASS (editor_print_operation_parent_class)->constructed (object);
+
+  g_signal_connect_object (gtk_text_view_get_buffer (GTK_TEXT_VIEW (self->view)),
+                           "changed",
+                           G_CALLBACK (editor_print_operation_buffer_changed_cb),
+                           self,
+                           G_CONNECT_SWAPPED);
+}
+
 static void
 editor_print_operation_dispose (GObject *object)
 {
   EditorPrintOperation *self = EDITOR_PRINT_OPERATION (object);
 
-  g_clear_object (&self->compositor);
+  editor_print_operation_reset (self);
 
   G_OBJECT_CLASS (editor_print_operation_parent_class)->dispose (object);
 }
@@ -93,44 +141,83 @@ editor_print_operation_set_property (GObject      *object,
     }
 }
 
-static void
-editor_print_operation_begin_print (GtkPrintOperation *operation,
-                                    GtkPrintContext   *context)
+/**
+ * _editor_print_operation_create_compositor:
+ * @buffer: a #GtkSourceBuffer
+ * @tab_width: the tab width to print with
+ *
+ * Creates a compositor for @buffer using the user's font settings. This
+ * is shared by printing from a window and by exporting from the command
+ * line so that both produce the same output.
+ *
+ * Returns: (transfer full): a #GtkSourcePrintCompositor
+ */
+GtkSourcePrintCompositor *
+_editor_print_operation_create_compositor (GtkSourceBuffer *buffer,
+                                           guint            tab_width)
 {
-  EditorPrintOperation *self = EDITOR_PRINT_OPERATION (operation);
+  GtkSourcePrintCompositor *compositor;
   g_autoptr(GSettings) settings = NULL;
   g_autofree char *custom_font = NULL;
-  GtkSourceBuffer *buffer;
-  GtkTextTag *spelling_tag;
-  guint tab_width;
-  gboolean syntax_hl;
   gboolean use_system_font;
 
+  g_return_val_if_fail (GTK_SOURCE_IS_BUFFER (buffer), NULL);
+
   settings = g_settings_new ("org.gnome.TextEditor");
   use_system_font = g_settings_get_boolean (settings, "use-system-font");
   custom_font = g_settings_get_string (settings, "custom-font");
 
-  buffer = GTK_SOURCE_BUFFER (gtk_text_view_get_buffer (GTK_TEXT_VIEW (self->view)));
-
-  tab_width = gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (self->view));
-  syntax_hl = gtk_source_buffer_get_highlight_syntax (buffer);
-
-  self->compositor = g_object_new (GTK_SOURCE_TYPE_PRINT_COMPOSITOR,
-                                   "buffer", buffer,
-                                   "tab-width", tab_width,
-                                   "highlight-syntax", syntax_hl,
-                                   NULL);
+  compositor = g_object_new (GTK_SOURCE_TYPE_PRINT_COMPOSITOR,
+                             "buffer", buffer,
+                             "tab-width", tab_width,
+                             "highlight-syntax", gtk_source_buffer_get_highlight_syntax (buffer),
+                             NULL);
 
   if (!use_system_font)
     {
-      gtk_source_print_compositor_set_body_font_name (self->compositor, custom_font);
-      gtk_source_print_compositor_set_line_numbers_font_name (self->compositor, custom_font);
-      gtk_source_print_compositor_set_header_font_name (self->compositor, custom_font);
-      gtk_source_print_compositor_set_footer_font_name (self->compositor, custom_font);
+      gtk_source_print_compositor_set_body_font_name (compositor, custom_font);
+      gtk_source_print_compositor_set_line_numbers_font_name (compositor, custom_font);
+      gtk_source_print_compositor_set_header_font_name (compositor, custom_font);
+      gtk_source_print_compositor_set_footer_font_name (compositor, custom_font);
     }
 
-  spelling_tag = _editor_document_get_spelling_tag (EDITOR_DOCUMENT (buffer));
-  gtk_source_print_compositor_ignore_tag (self->compositor, spelling_tag);
+  if (EDITOR_IS_DOCUMENT (buffer))
+    gtk_source_print_compositor_ignore_tag (compositor,
+                                            _editor_document_get_spelling_tag (EDITOR_DOCUMENT (buffer)));
+
+  return compositor;
+}
+
+static void
+editor_print_operation_begin_print (GtkPrintOperation *operation,
+                                    GtkPrintContext   *context)
+{
+  EditorPrintOperation *self = EDITOR_PRINT_OPERATION (operation);
+  GtkSourceBuffer *buffer;
+  guint tab_width;
+  gdouble width;
+  gdouble height;
+
+  self->printing = TRUE;
+
+  width = gtk_print_context_get_width (context);
+  height = gtk_print_context_get_height (context);
+
+  /* Keep the pagination of a previous run if nothing changed since */
+  if (self->compositor != NULL &&
+      self->page_width == width &&
+      self->page_height == height)
+    return;
+
+  editor_print_operation_reset (self);
+
+  self->page_width = width;
+  self->page_height = height;
+
+  buffer = GTK_SOURCE_BUFFER (gtk_text_view_get_buffer (GTK_TEXT_VIEW (self->view)));
+  tab_width = gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (self->view));
+
+  self->compositor = _editor_print_operation_create_compositor (buffer, tab_width);
 }
 
 static gboolean
@@ -138,25 +225,38 @@ editor_print_operation_paginate (GtkPrintOperation *operation,
                                  GtkPrintContext   *context)
 {
   EditorPrintOperation *self = EDITOR_PRINT_OPERATION (operation);
-  gboolean finished;
-
-  finished = gtk_source_print_compositor_paginate (self->compositor, context);
+  gint64 deadline;
+  gint n_pages;
 
-  if (finished)
+  if (!self->paginated)
     {
-      gint n_pages;
-
-      n_pages = gtk_source_print_compositor_get_n_pages (self->compositor);
-      gtk_print_operation_set_n_pages (operation, n_pages);
+      /* GTK calls us from an idle until we are done, so paginate as many
+       * chunks as fit in our budget and let the main loop (and the progress
+       * dialog with its cancel button) run in between.
+       */
+      deadline = g_get_monotonic_time () + PAGINATE_BUDGET_USEC;
+
+      do
+        {
+          if (gtk_source_print_compositor_paginate (self->compositor, context))
+            self->paginated = TRUE;
+        }
+      while (!self->paginated && g_get_monotonic_time () < deadline);
+
+      if (!self->paginated)
+        return FALSE;
     }
 
-  return finished;
+  n_pages = gtk_source_print_compositor_get_n_pages (self->compositor);
+  gtk_print_operation_set_n_pages (operation, n_pages);
+
+  return TRUE;
 }
 
 static void
 editor_print_operation_draw_page (GtkPrintOperation *operation,
-                                      GtkPrintContext   *context,
-                                      gint               page_nr)
+                                  GtkPrintContext   *context,
+                                  gint               page_nr)
 {
   EditorPrintOperation *self = EDITOR_PRINT_OPERATION (operation);
 
@@ -169,7 +269,13 @@ editor_print_operation_end_print (GtkPrintOperation *operation,
 {
   EditorPrintOperation *self = EDITOR_PRINT_OPERATION (operation);
 
-  g_clear_object (&self->compositor);
+  self->printing = FALSE;
+
+  /* Pagination is kept for the next run unless cancelled because the
+   * buffer changed.
+   */
+  if (gtk_print_operation_get_status (operation) == GTK_PRINT_STATUS_FINISHED_ABORTED)
+    editor_print_operation_reset (self);
 }
 
 static void
@@ -178,6 +284,7 @@ editor_print_operation_class_init (EditorPrintOperationClass *klass)
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GtkPrintOperationClass *operation_class = GTK_PRINT_OPERATION_CLASS (klass);
 
+  object_class->constructed = editor_print_operation_constructed;
   object_class->dispose = editor_print_operation_dispose;
   object_class->get_property = editor_print_operation_get_property;
   object_class->set_property = editor_print_operation_set_property;
@@ -223,5 +330,6 @@ editor_print_operation_new (GtkSourceView *view)
   return g_object_new (EDITOR_TYPE_PRINT_OPERATION,
                        "view", view,
                        "allow-async", TRUE,
+                       "show-progress", TRUE,
                        NULL);
 }
@@ -22,9 +22,12 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "editor-enums.h"
 #include "editor-page-private.h"
 #include "editor-search-bar-private.h"
+#include "editor-search-engine-private.h"
 #include "editor-search-entry-private.h"
 #include "editor-utils-private.h"
 
@@ -34,6 +37,12 @@ struct _EditorSearchBar
 
   GtkSourceSearchContext  *context;
   GtkSourceSearchSettings *settings;
+  EditorSearchEngine      *engine;
+
+  /* Settings for the context, which has no query to scan for while
+   * the engine is active.
+   */
+  GtkSourceSearchSettings *context_settings;
 
   GtkGrid                 *grid;
   EditorSearchEntry       *search_entry;
@@ -77,6 +86,26 @@ enum {
 static GParamSpec *properties [N_PROPS];
 static guint signals [N_SIGNALS];
 
+static gboolean
+engine_is_active (EditorSearchBar *self)
+{
+  return self->engine != NULL && _editor_search_engine_get_active (self->engine);
+}
+
+static int
+get_occurrence_position (EditorSearchBar   *self,
+                         const GtkTextIter *begin,
+                         const GtkTextIter *end)
+{
+  g_assert (EDITOR_IS_SEARCH_BAR (self));
+  g_assert (self->context != NULL);
+
+  if (engine_is_active (self))
+    return _editor_search_engine_get_occurrence_position (self->engine, begin, end);
+
+  return gtk_source_search_context_get_occurrence_position (self->context, begin, end);
+}
+
 static void
 update_properties (EditorSearchBar *self)
 {
@@ -109,7 +138,7 @@ update_properties (EditorSearchBar *self)
       GtkTextIter begin, end;
 
       if (gtk_text_buffer_get_selection_bounds (buffer, &begin, &end))
-        occurrence_position = gtk_source_search_context_get_occurrence_position (self->context, &begin, &end);
+        occurrence_position = get_occurrence_position (self, &begin, &end);
     }
 
   editor_search_entry_set_occurrence_position (self->search_entry, occurrence_position);
@@ -126,6 +155,23 @@ editor_search_bar_scroll_to_insert (EditorSearchBar *self)
     _editor_page_scroll_to_insert (EDITOR_PAGE (page));
 }
 
+static void
+editor_search_bar_select_match (EditorSearchBar   *self,
+                                const GtkTextIter *begin,
+                                const GtkTextIter *end)
+{
+  GtkTextBuffer *buffer;
+
+  g_assert (EDITOR_IS_SEARCH_BAR (self));
+
+  buffer = gtk_text_iter_get_buffer (begin);
+  gtk_text_buffer_select_range (buffer, begin, end);
+  editor_search_bar_scroll_to_insert (self);
+
+  if (self->hide_after_move)
+    gtk_widget_activate_action (GTK_WIDGET (self), "search.hide", NULL);
+}
+
 static void
 editor_search_bar_move_next_forward_cb (GObject      *object,
                                         GAsyncResult *result,
@@ -134,7 +180,6 @@ editor_search_bar_move_next_forward_cb (GObject      *object,
   GtkSourceSearchContext *context = (GtkSourceSearchContext *)object;
   g_autoptr(EditorSearchBar) self = user_data;
   g_autoptr(GError) error = NULL;
-  GtkSourceBuffer *buffer;
   GtkTextIter begin;
   GtkTextIter end;
   gboolean has_wrapped = FALSE;
@@ -150,12 +195,7 @@ editor_search_bar_move_next_forward_cb (GObject      *object,
       return;
     }
 
-  buffer = gtk_source_search_context_get_buffer (context);
-  gtk_text_buffer_select_range (GTK_TEXT_BUFFER (buffer), &begin, &end);
-  editor_search_bar_scroll_to_insert (self);
-
-  if (self->hide_after_move)
-    gtk_widget_activate_action (GTK_WIDGET (self), "search.hide", NULL);
+  editor_search_bar_select_match (self, &begin, &end);
 }
 
 void
@@ -178,6 +218,16 @@ _editor_search_bar_move_next (EditorSearchBar *self,
   gtk_text_buffer_get_selection_bounds (GTK_TEXT_BUFFER (buffer), &begin, &end);
   gtk_text_iter_order (&begin, &end);
 
+  if (engine_is_active (self))
+    {
+      GtkTextIter match_begin, match_end;
+
+      if (_editor_search_engine_forward (self->engine, &end, &match_begin, &match_end))
+        editor_search_bar_select_match (self, &match_begin, &match_end);
+
+      return;
+    }
+
   gtk_source_search_context_forward_async (self->context,
                                            &end,
                                            NULL,
@@ -205,6 +255,16 @@ _editor_search_bar_move_previous (EditorSearchBar *self,
   gtk_text_buffer_get_selection_bounds (GTK_TEXT_BUFFER (buffer), &begin, &end);
   gtk_text_iter_order (&begin, &end);
 
+  if (engine_is_active (self))
+    {
+      GtkTextIter match_begin, match_end;
+
+      if (_editor_search_engine_backward (self->engine, &begin, &match_begin, &match_end))
+        editor_search_bar_select_match (self, &match_begin, &match_end);
+
+      return;
+    }
+
   gtk_source_search_context_backward_async (self->context,
                                             &begin,
                                             NULL,
@@ -306,6 +366,86 @@ on_notify_search_text_cb (EditorSearchBar   *self,
   self->scroll_to_first_match = TRUE;
 }
 
+static void
+scroll_to_first_match (EditorSearchBar        *self,
+                       GtkSourceSearchContext *context)
+{
+  GtkTextIter iter, match_begin, match_end;
+  GtkTextBuffer *buffer;
+  GtkWidget *page;
+  gboolean wrapped;
+  gboolean found;
+
+  g_assert (EDITOR_IS_SEARCH_BAR (self));
+  g_assert (GTK_SOURCE_IS_SEARCH_CONTEXT (context));
+
+  if (!(page = gtk_widget_get_ancestor (GTK_WIDGET (self), EDITOR_TYPE_PAGE)))
+    return;
+
+  buffer = GTK_TEXT_BUFFER (gtk_source_search_context_get_buffer (context));
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, self->offset_when_shown);
+
+  if (engine_is_active (self))
+    found = _editor_search_engine_find_nearest (self->engine, &iter, &match_begin, &match_end);
+  else
+    found = gtk_source_search_context_forward (context, &iter, &match_begin, &match_end, &wrapped);
+
+  if (found)
+    {
+      gtk_text_view_scroll_to_iter (GTK_TEXT_VIEW (EDITOR_PAGE (page)->view),
+                                    &match_begin, 0.25, TRUE, 1.0, 0.5);
+      self->jump_back_on_hide = TRUE;
+    }
+
+  /* Try again as the engine finds more occurrences */
+  if (found || !engine_is_active (self) || !_editor_search_engine_get_busy (self->engine))
+    self->scroll_to_first_match = FALSE;
+}
+
+static void
+editor_search_bar_update_engine (EditorSearchBar *self)
+{
+  const char *search_text = NULL;
+
+  g_assert (EDITOR_IS_SEARCH_BAR (self));
+  g_assert (self->engine != NULL);
+
+  _editor_search_engine_update (self->engine);
+
+  /* Only one of the engine and the context scans the buffer */
+  if (!engine_is_active (self))
+    search_text = gtk_source_search_settings_get_search_text (self->settings);
+
+  gtk_source_search_settings_set_search_text (self->context_settings, search_text);
+}
+
+static void
+on_notify_settings_cb (EditorSearchBar         *self,
+                       GParamSpec              *pspec,
+                       GtkSourceSearchSettings *settings)
+{
+  g_assert (EDITOR_IS_SEARCH_BAR (self));
+  g_assert (GTK_SOURCE_IS_SEARCH_SETTINGS (settings));
+
+  if (self->engine == NULL)
+    return;
+
+  /* Cancels any scan in progress for the previous query */
+  editor_search_bar_update_engine (self);
+
+  if (engine_is_active (self))
+    {
+      editor_search_entry_set_occurrence_count (self->search_entry,
+                                                _editor_search_engine_get_occurrence_count (self->engine));
+
+      /* Jump right away rather than waiting for the count */
+      if (self->scroll_to_first_match)
+        scroll_to_first_match (self, self->context);
+    }
+
+  update_properties (self);
+}
+
 static gboolean
 on_search_key_pressed_cb (GtkEventControllerKey *key,
                           guint                  keyval,
@@ -353,7 +493,9 @@ editor_search_bar_finalize (GObject *object)
 {
   EditorSearchBar *self = (EditorSearchBar *)object;
 
+  g_clear_object (&self->engine);
   g_clear_object (&self->context);
+  g_clear_object (&self->context_settings);
   g_clear_object (&self->settings);
 
   G_OBJECT_CLASS (editor_search_bar_parent_class)->finalize (object);
@@ -514,6 +656,26 @@ editor_search_bar_init (EditorSearchBar *self)
 
   gtk_source_search_settings_set_wrap_around (self->settings, TRUE);
 
+  self->context_settings = gtk_source_search_settings_new ();
+  g_object_bind_property (self->settings, "wrap-around",
+                          self->context_settings, "wrap-around",
+                          G_BINDING_SYNC_CREATE);
+  g_object_bind_property (self->settings, "at-word-boundaries",
+                          self->context_settings, "at-word-boundaries",
+                          G_BINDING_SYNC_CREATE);
+  g_object_bind_property (self->settings, "regex-enabled",
+                          self->context_settings, "regex-enabled",
+                          G_BINDING_SYNC_CREATE);
+  g_object_bind_property (self->settings, "case-sensitive",
+                          self->context_settings, "case-sensitive",
+                          G_BINDING_SYNC_CREATE);
+
+  g_signal_connect_object (self->settings,
+                           "notify",
+                           G_CALLBACK (on_notify_settings_cb),
+                           self,
+                           G_CONNECT_SWAPPED);
+
   g_object_bind_property_full (self->settings, "search-text",
                                self->search_entry, "text",
                                G_BINDING_SYNC_CREATE | G_BINDING_BIDIRECTIONAL,
@@ -556,54 +718,52 @@ _editor_search_bar_set_mode (EditorSearchBar     *self,
 }
 
 static void
-scroll_to_first_match (EditorSearchBar        *self,
-                       GtkSourceSearchContext *context)
+editor_search_bar_notify_occurrences_count_cb (EditorSearchBar        *self,
+                                               GParamSpec             *pspec,
+                                               GtkSourceSearchContext *context)
 {
-  GtkTextIter iter, match_begin, match_end;
-  GtkTextBuffer *buffer;
-  GtkWidget *page;
-  gboolean wrapped;
+  guint occurrence_count;
 
   g_assert (EDITOR_IS_SEARCH_BAR (self));
   g_assert (GTK_SOURCE_IS_SEARCH_CONTEXT (context));
 
-  if (!(page = gtk_widget_get_ancestor (GTK_WIDGET (self), EDITOR_TYPE_PAGE)))
+  /* The engine provides counts while it is scanning */
+  if (engine_is_active (self))
     return;
 
-  buffer = GTK_TEXT_BUFFER (gtk_source_search_context_get_buffer (context));
-  gtk_text_buffer_get_iter_at_offset (buffer, &iter, self->offset_when_shown);
-  if (gtk_source_search_context_forward (context, &iter, &match_begin, &match_end, &wrapped))
-    {
-      gtk_text_view_scroll_to_iter (GTK_TEXT_VIEW (EDITOR_PAGE (page)->view),
-                                    &match_begin, 0.25, TRUE, 1.0, 0.5);
-      self->jump_back_on_hide = TRUE;
-    }
+  occurrence_count = gtk_source_search_context_get_occurrences_count (context);
+  editor_search_entry_set_occurrence_count (self->search_entry, occurrence_count);
 
-  self->scroll_to_first_match = FALSE;
+  if (self->scroll_to_first_match && occurrence_count > 0)
+    scroll_to_first_match (self, context);
+
+  update_properties (self);
 }
 
 static void
-editor_search_bar_notify_occurrences_count_cb (EditorSearchBar        *self,
-                                               GParamSpec             *pspec,
-                                               GtkSourceSearchContext *context)
+editor_search_bar_notify_engine_count_cb (EditorSearchBar    *self,
+                                          GParamSpec         *pspec,
+                                          EditorSearchEngine *engine)
 {
-  guint occurrence_count;
-
   g_assert (EDITOR_IS_SEARCH_BAR (self));
-  g_assert (GTK_SOURCE_IS_SEARCH_CONTEXT (context));
+  g_assert (EDITOR_IS_SEARCH_ENGINE (engine));
 
-  occurrence_count = gtk_source_search_context_get_occurrences_count (context);
-  editor_search_entry_set_occurrence_count (self->search_entry, occurrence_count);
+  if (!_editor_search_engine_get_active (engine))
+    return;
 
-  if (self->scroll_to_first_match && occurrence_count > 0)
-    scroll_to_first_match (self, context);
+  editor_search_entry_set_occurrence_count (self->search_entry,
+                                            _editor_search_engine_get_occurrence_count (engine));
+
+  if (self->scroll_to_first_match)
+    scroll_to_first_match (self, self->context);
 
   update_properties (self);
 }
 
 static void
-editor_search_bar_cursor_moved_cb (EditorSearchBar *self,
-                                   EditorDocument  *document)
+editor_search_bar_cursor_changed_cb (EditorSearchBar            *self,
+                                     const EditorDocumentCursor *cursor,
+                                     EditorDocument             *document)
 {
   g_assert (EDITOR_IS_SEARCH_BAR (self));
   g_assert (EDITOR_IS_DOCUMENT (document));
@@ -611,6 +771,60 @@ editor_search_bar_cursor_moved_cb (EditorSearchBar *self,
   update_properties (self);
 }
 
+static void
+editor_search_bar_connect_search (EditorSearchBar *self,
+                                  EditorDocument  *document)
+{
+  g_assert (EDITOR_IS_SEARCH_BAR (self));
+  g_assert (EDITOR_IS_DOCUMENT (document));
+  g_assert (self->context == NULL);
+  g_assert (self->engine == NULL);
+
+  self->engine = _editor_search_engine_new (GTK_TEXT_BUFFER (document), self->settings);
+
+  /* Before creating the context so that it does not start a scan */
+  editor_search_bar_update_engine (self);
+
+  self->context = gtk_source_search_context_new (GTK_SOURCE_BUFFER (document), self->context_settings);
+
+  g_signal_connect_object (self->context,
+                           "notify::occurrences-count",
+                           G_CALLBACK (editor_search_bar_notify_occurrences_count_cb),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  g_signal_connect_object (self->engine,
+                           "notify::occurrence-count",
+                           G_CALLBACK (editor_search_bar_notify_engine_count_cb),
+                           self,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect_object (self->engine,
+                           "notify::busy",
+                           G_CALLBACK (editor_search_bar_notify_engine_count_cb),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  on_notify_settings_cb (self, NULL, self->settings);
+}
+
+static void
+editor_search_bar_disconnect_search (EditorSearchBar *self)
+{
+  g_assert (EDITOR_IS_SEARCH_BAR (self));
+  g_assert (self->context != NULL);
+  g_assert (self->engine != NULL);
+
+  g_signal_handlers_disconnect_by_func (self->context,
+                                        G_CALLBACK (editor_search_bar_notify_occurrences_count_cb),
+                                        self);
+  g_signal_handlers_disconnect_by_func (self->engine,
+                                        G_CALLBACK (editor_search_bar_notify_engine_count_cb),
+                                        self);
+
+  g_clear_object (&self->engine);
+  g_clear_object (&self->context);
+}
+
 void
 _editor_search_bar_attach (EditorSearchBar *self,
                            EditorDocument  *document)
@@ -636,17 +850,11 @@ _editor_search_bar_attach (EditorSearchBar *self,
       gtk_editable_set_text (GTK_EDITABLE (self->search_entry), text);
     }
 
-  self->context = gtk_source_search_context_new (GTK_SOURCE_BUFFER (document), self->settings);
-
-  g_signal_connect_object (self->context,
-                           "notify::occurrences-count",
-                           G_CALLBACK (editor_search_bar_notify_occurrences_count_cb),
-                           self,
-                           G_CONNECT_SWAPPED);
+  editor_search_bar_connect_search (self, document);
 
   g_signal_connect_object (document,
-                           "cursor-moved",
-                           G_CALLBACK (editor_search_bar_cursor_moved_cb),
+                           "cursor-changed",
+                           G_CALLBACK (editor_search_bar_cursor_changed_cb),
                            self,
                            G_CONNECT_SWAPPED);
 }
@@ -664,14 +872,11 @@ _editor_search_bar_detach (EditorSearchBar *self)
       if (self->jump_back_on_hide)
         _editor_page_scroll_to_insert (EDITOR_PAGE (page));
 
-      g_signal_handlers_disconnect_by_func (self->context,
-                                            G_CALLBACK (editor_search_bar_notify_occurrences_count_cb),
-                                            self);
       g_signal_handlers_disconnect_by_func (document,
-                                            G_CALLBACK (editor_search_bar_cursor_moved_cb),
+                                            G_CALLBACK (editor_search_bar_cursor_changed_cb),
                                             self);
 
-      g_clear_object (&self->context);
+      editor_search_bar_disconnect_search (self);
     }
 
   self->hide_after_move = FALSE;
@@ -683,8 +888,13 @@ _editor_search_bar_get_can_move (EditorSearchBar *self)
 {
   g_return_val_if_fail (EDITOR_IS_SEARCH_BAR (self), FALSE);
 
-  return self->context != NULL &&
-         gtk_source_search_context_get_occurrences_count (self->context) > 0;
+  if (self->context == NULL)
+    return FALSE;
+
+  if (engine_is_active (self))
+    return _editor_search_engine_get_occurrence_count (self->engine) > 0;
+
+  return gtk_source_search_context_get_occurrences_count (self->context) > 0;
 }
 
 gboolean
@@ -702,7 +912,7 @@ _editor_search_bar_get_can_replace (EditorSearchBar *self)
 
   return _editor_search_bar_get_can_move (self) &&
          gtk_text_buffer_get_selection_bounds (buffer, &begin, &end) &&
-         gtk_source_search_context_get_occurrence_position (self->context, &begin, &end) > 0;
+         get_occurrence_position (self, &begin, &end) > 0;
 }
 
 gboolean
@@ -731,7 +941,16 @@ _editor_search_bar_replace (EditorSearchBar *self)
 
   gtk_text_buffer_get_selection_bounds (GTK_TEXT_BUFFER (buffer), &begin, &end);
 
-  if (!gtk_source_search_context_replace (self->context, &begin, &end, replace, -1, &error))
+  if (engine_is_active (self))
+    {
+      /* The context has no query while the engine is active */
+      gtk_text_buffer_begin_user_action (GTK_TEXT_BUFFER (buffer));
+      gtk_text_buffer_delete (GTK_TEXT_BUFFER (buffer), &begin, &end);
+      gtk_text_buffer_insert (GTK_TEXT_BUFFER (buffer), &begin, replace, -1);
+      gtk_text_buffer_end_user_action (GTK_TEXT_BUFFER (buffer));
+      end = begin;
+    }
+  else if (!gtk_source_search_context_replace (self->context, &begin, &end, replace, -1, &error))
     {
       g_warning ("Failed to replace match: %s", error->message);
       return;
@@ -741,11 +960,73 @@ _editor_search_bar_replace (EditorSearchBar *self)
   _editor_search_bar_move_next (self, FALSE);
 }
 
+static void
+editor_search_bar_replace_occurrences (EditorSearchBar *self,
+                                       EditorDocument  *document,
+                                       const char      *replace)
+{
+  g_autoptr(GArray) occurrences = NULL;
+  g_autoptr(GString) str = NULL;
+  g_autofree char *text = NULL;
+  GtkTextBuffer *buffer = (GtkTextBuffer *)document;
+  const EditorSearchOccurrence *first;
+  const EditorSearchOccurrence *last;
+  GtkTextIter begin, end;
+  const char *pos;
+  guint offset;
+
+  g_assert (EDITOR_IS_SEARCH_BAR (self));
+  g_assert (EDITOR_IS_DOCUMENT (document));
+  g_assert (replace != NULL);
+
+  occurrences = _editor_search_engine_list_occurrences (self->engine);
+
+  if (occurrences->len == 0)
+    return;
+
+  first = &g_array_index (occurrences, EditorSearchOccurrence, 0);
+  last = &g_array_index (occurrences, EditorSearchOccurrence, occurrences->len - 1);
+
+  gtk_text_buffer_get_iter_at_offset (buffer, &begin, first->begin);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, last->end);
+
+  /* Build the replaced text once so that the buffer only sees a single
+   * deletion and insertion rather than one of each per occurrence.
+   */
+  text = gtk_text_buffer_get_slice (buffer, &begin, &end, TRUE);
+  str = g_string_sized_new (strlen (text));
+  pos = text;
+  offset = first->begin;
+
+  for (guint i = 0; i < occurrences->len; i++)
+    {
+      const EditorSearchOccurrence *occurrence = &g_array_index (occurrences, EditorSearchOccurrence, i);
+      const char *match = g_utf8_offset_to_pointer (pos, occurrence->begin - offset);
+
+      g_string_append_len (str, pos, match - pos);
+      g_string_append (str, replace);
+
+      pos = g_utf8_offset_to_pointer (match, occurrence->end - occurrence->begin);
+      offset = occurrence->end;
+    }
+
+  /* The search context and engine would update their matches after
+   * each edit, so drop them until the replacement has been made.
+   */
+  editor_search_bar_disconnect_search (self);
+
+  gtk_text_buffer_delete (buffer, &begin, &end);
+  gtk_text_buffer_insert (buffer, &begin, str->str, str->len);
+
+  editor_search_bar_connect_search (self, document);
+}
+
 void
 _editor_search_bar_replace_all (EditorSearchBar *self)
 {
   g_autoptr(GError) error = NULL;
   g_autofree char *unescaped = NULL;
+  EditorDocument *document;
   const char *replace;
 
   g_return_if_fail (EDITOR_IS_SEARCH_BAR (self));
@@ -755,7 +1036,19 @@ _editor_search_bar_replace_all (EditorSearchBar *self)
 
   replace = gtk_editable_get_text (GTK_EDITABLE (self->replace_entry));
   unescaped = gtk_source_utils_unescape_search_text (replace);
+  document = EDITOR_DOCUMENT (gtk_source_search_context_get_buffer (self->context));
+
+  /* Apply every replacement as a single undoable action and let the
+   * document defer its per-edit work until they have all been made.
+   */
+  gtk_text_buffer_begin_user_action (GTK_TEXT_BUFFER (document));
+  _editor_document_begin_bulk_edit (document);
 
-  if (!gtk_source_search_context_replace_all (self->context, unescaped, -1, &error))
+  if (engine_is_active (self))
+    editor_search_bar_replace_occurrences (self, document, unescaped);
+  else if (!gtk_source_search_context_replace_all (self->context, unescaped, -1, &error))
     g_warning ("Failed to replace all matches: %s", error->message);
+
+  _editor_document_end_bulk_edit (document);
+  gtk_text_buffer_end_user_action (GTK_TEXT_BUFFER (document));
 }
@@ -0,0 +1,60 @@
+/* editor-search-engine-private.h
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtksourceview/gtksource.h>
+
+G_BEGIN_DECLS
+
+#define EDITOR_TYPE_SEARCH_ENGINE (editor_search_engine_get_type())
+
+G_DECLARE_FINAL_TYPE (EditorSearchEngine, editor_search_engine, EDITOR, SEARCH_ENGINE, GObject)
+
+typedef struct
+{
+  guint begin;
+  guint end;
+} EditorSearchOccurrence;
+
+EditorSearchEngine *_editor_search_engine_new                     (GtkTextBuffer           *buffer,
+                                                                   GtkSourceSearchSettings *settings);
+void                _editor_search_engine_update                  (EditorSearchEngine      *self);
+gboolean            _editor_search_engine_get_active              (EditorSearchEngine      *self);
+gboolean            _editor_search_engine_get_busy                (EditorSearchEngine      *self);
+guint               _editor_search_engine_get_occurrence_count    (EditorSearchEngine      *self);
+int                 _editor_search_engine_get_occurrence_position (EditorSearchEngine      *self,
+                                                                   const GtkTextIter       *match_begin,
+                                                                   const GtkTextIter       *match_end);
+gboolean            _editor_search_engine_find_nearest            (EditorSearchEngine      *self,
+                                                                   const GtkTextIter       *from,
+                                                                   GtkTextIter             *match_begin,
+                                                                   GtkTextIter             *match_end);
+gboolean            _editor_search_engine_forward                 (EditorSearchEngine      *self,
+                                                                   const GtkTextIter       *from,
+                                                                   GtkTextIter             *match_begin,
+                                                                   GtkTextIter             *match_end);
+gboolean            _editor_search_engine_backward                (EditorSearchEngine      *self,
+                                                                   const GtkTextIter       *from,
+                                                                   GtkTextIter             *match_begin,
+                                                                   GtkTextIter             *match_end);
+GArray             *_editor_search_engine_list_occurrences        (EditorSearchEngine      *self);
+
+G_END_DECLS
@@ -0,0 +1,1236 @@
+/* editor-search-engine.c
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "editor-search-engine"
+
+#include "config.h"
+
+#include <string.h>
+
+#include "editor-literal-search-private.h"
+#include "editor-search-engine-private.h"
+
+/*
+ * EditorSearchEngine tracks the occurrences of a literal search so that
+ * EditorSearchBar does not have to wait for GtkSourceSearchContext to
+ * scan the entire buffer before it can jump to a match or show a count.
+ *
+ * The buffer is scanned in bounded chunks from the GtkSourceScheduler so
+ * that each main loop iteration only does a small amount of work. The
+ * scan is restarted whenever the query changes, cancelling any previous
+ * scan. When the new query extends the previous one, every new match
+ * must begin at a previous candidate, so those are verified instead of
+ * scanning the already covered part of the buffer again.
+ *
+ * While active, the engine replaces the scanning of GtkSourceSearchContext
+ * rather than duplicating it, so it also highlights the occurrences. Edits
+ * to the buffer only drop the candidates around the edited text, which is
+ * searched again, and shift those after it.
+ *
+ * Case-sensitive queries and ASCII case-insensitive queries are matched
+ * against the text of each chunk with EditorLiteralSearch instead of
+ * walking the buffer with GtkTextIter. Hidden text is not skipped on that
+ * path, which does not matter as we never hide text in the editor.
+ *
+ * Regex and word-boundary searches are left to GtkSourceSearchContext
+ * and the engine is inactive for them.
+ */
+
+#define SCAN_CHUNK_CHARS 16384
+#define REFINE_BATCH     64
+#define NEAREST_CHARS    SCAN_CHUNK_CHARS
+
+typedef struct
+{
+  guint begin;
+  guint end;
+  /* 1-based position of the occurrence, or 0 if the candidate overlaps
+   * a previous occurrence and is only kept for refinement.
+   */
+  guint position;
+} Match;
+
+struct _EditorSearchEngine
+{
+  GObject                  parent_instance;
+
+  GtkTextBuffer           *buffer;
+  GtkSourceSearchSettings *settings;
+  GtkTextTag              *tag;
+
+  /* Every candidate (including overlapping ones) starting before
+   * scan_offset, sorted by offset.
+   */
+  GArray                  *matches;
+
+  /* Candidates of the previous query which are being verified */
+  GArray                  *refining;
+  guint                    refine_pos;
+
+  char                    *query;
+  guint                    query_len;
+  GtkTextSearchFlags       flags;
+  EditorLiteralSearch      literal;
+
+  guint                    scan_offset;
+  guint                    last_end;
+  guint                    occurrence_count;
+
+  /* The range being deleted, between the delete-range emissions */
+  guint                    delete_offset;
+  guint                    delete_length;
+
+  gsize                    scan_source;
+
+  guint                    active : 1;
+  guint                    busy : 1;
+  guint                    use_literal : 1;
+};
+
+enum {
+  PROP_0,
+  PROP_BUSY,
+  PROP_OCCURRENCE_COUNT,
+  N_PROPS
+};
+
+G_DEFINE_TYPE (EditorSearchEngine, editor_search_engine, G_TYPE_OBJECT)
+
+static GParamSpec *properties [N_PROPS];
+
+static void
+editor_search_engine_highlight (EditorSearchEngine *self,
+                                const Match        *match)
+{
+  GtkTextIter begin;
+  GtkTextIter end;
+
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+
+  if (self->tag == NULL || match->position == 0)
+    return;
+
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &begin, match->begin);
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &end, match->end);
+  gtk_text_buffer_apply_tag (self->buffer, self->tag, &begin, &end);
+}
+
+static void
+editor_search_engine_unhighlight (EditorSearchEngine *self,
+                                  guint               begin_offset,
+                                  guint               end_offset)
+{
+  GtkTextIter begin;
+  GtkTextIter end;
+
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+
+  if (self->tag == NULL || self->buffer == NULL)
+    return;
+
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &begin, begin_offset);
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &end, end_offset);
+  gtk_text_buffer_remove_tag (self->buffer, self->tag, &begin, &end);
+}
+
+static void
+editor_search_engine_update_style (EditorSearchEngine *self)
+{
+  GtkSourceStyleScheme *scheme;
+  GtkSourceStyle *style = NULL;
+
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+
+  if (self->tag == NULL)
+    return;
+
+  if ((scheme = gtk_source_buffer_get_style_scheme (GTK_SOURCE_BUFFER (self->buffer))))
+    style = gtk_source_style_scheme_get_style (scheme, "search-match");
+
+  gtk_source_style_apply (style, self->tag);
+
+  /* Same fallback as GtkSourceSearchContext */
+  if (style == NULL)
+    g_object_set (self->tag, "background", "yellow", NULL);
+}
+
+static void
+editor_search_engine_add_match (EditorSearchEngine *self,
+                                guint               begin,
+                                guint               end)
+{
+  Match match = { begin, end, 0 };
+
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+  g_assert (self->matches->len == 0 ||
+            g_array_index (self->matches, Match, self->matches->len - 1).begin < begin);
+
+  /* Occurrences do not overlap, matching GtkSourceSearchContext */
+  if (begin >= self->last_end)
+    {
+      match.position = ++self->occurrence_count;
+      self->last_end = end;
+    }
+
+  g_array_append_val (self->matches, match);
+}
+
+static void
+editor_search_engine_truncate (EditorSearchEngine *self,
+                               guint               offset)
+{
+  guint len;
+
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+
+  len = self->matches->len;
+
+  while (len > 0 && g_array_index (self->matches, Match, len - 1).begin >= offset)
+    {
+      if (g_array_index (self->matches, Match, len - 1).position > 0)
+        self->occurrence_count--;
+      len--;
+    }
+
+  g_array_set_size (self->matches, len);
+
+  self->last_end = 0;
+
+  while (len > 0)
+    {
+      const Match *match = &g_array_index (self->matches, Match, --len);
+
+      if (match->position > 0)
+        {
+          self->last_end = match->end;
+          break;
+        }
+    }
+}
+
+static guint
+editor_search_engine_bisect (EditorSearchEngine *self,
+                             guint               offset)
+{
+  guint lo = 0;
+  guint hi;
+
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+
+  /* Find the first candidate beginning at or after @offset */
+  hi = self->matches->len;
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+
+      if (g_array_index (self->matches, Match, mid).begin < offset)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+static gboolean
+editor_search_engine_refine (EditorSearchEngine *self)
+{
+  GtkTextIter iter;
+  GtkTextIter limit;
+  GtkTextIter match_begin;
+  GtkTextIter match_end;
+  guint n = 0;
+
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+  g_assert (self->refining != NULL);
+
+  while (self->refine_pos < self->refining->len && n++ < REFINE_BATCH)
+    {
+      const Match *prev = &g_array_index (self->refining, Match, self->refine_pos);
+
+      self->refine_pos++;
+
+      /* Candidates at scan_offset and beyond are found by the scan */
+      if (prev->begin >= self->scan_offset)
+        break;
+
+      gtk_text_buffer_get_iter_at_offset (self->buffer, &iter, prev->begin);
+      gtk_text_buffer_get_iter_at_offset (self->buffer, &limit, prev->begin + self->query_len);
+
+      if (gtk_text_iter_forward_search (&iter, self->query, self->flags, &match_begin, &match_end, &limit) &&
+          gtk_text_iter_equal (&iter, &match_begin))
+        {
+          editor_search_engine_add_match (self,
+                                          gtk_text_iter_get_offset (&match_begin),
+                                          gtk_text_iter_get_offset (&match_end));
+          editor_search_engine_highlight (self, &g_array_index (self->matches, Match, self->matches->len - 1));
+        }
+    }
+
+  if (self->refine_pos < self->refining->len &&
+      g_array_index (self->refining, Match, self->refine_pos).begin < self->scan_offset)
+    return TRUE;
+
+  g_clear_pointer (&self->refining, g_array_unref);
+
+  return FALSE;
+}
+
+static void
+editor_search_engine_scan_literal (EditorSearchEngine *self,
+                                   const GtkTextIter  *begin,
+                                   const GtkTextIter  *end)
+{
+  g_autofree char *text = NULL;
+  const char *pos;
+  const char *text_end;
+  const char *last;
+  guint last_offset;
+  guint needle_chars;
+
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+  g_assert (self->use_literal);
+
+  text = gtk_text_iter_get_slice (begin, end);
+  text_end = text + strlen (text);
+  needle_chars = g_utf8_strlen (self->query, -1);
+
+  /* Convert byte positions to character offsets incrementally */
+  last = text;
+  last_offset = gtk_text_iter_get_offset (begin);
+
+  for (pos = text;
+       (pos = _editor_literal_search_find (&self->literal, pos, text_end - pos));
+       pos++)
+    {
+      last_offset += g_utf8_strlen (last, pos - last);
+      last = pos;
+
+      editor_search_engine_add_match (self, last_offset, last_offset + needle_chars);
+    }
+}
+
+static void
+editor_search_engine_scan_iter (EditorSearchEngine *self,
+                                const GtkTextIter  *begin,
+                                const GtkTextIter  *end)
+{
+  GtkTextIter iter = *begin;
+  GtkTextIter match_begin;
+  GtkTextIter match_end;
+
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+
+  while (gtk_text_iter_forward_search (&iter, self->query, self->flags, &match_begin, &match_end, end))
+    {
+      editor_search_engine_add_match (self,
+                                      gtk_text_iter_get_offset (&match_begin),
+                                      gtk_text_iter_get_offset (&match_end));
+
+      /* Continue from the next character so that overlapping
+       * candidates are available for refinement.
+       */
+      iter = match_begin;
+      if (!gtk_text_iter_forward_char (&iter))
+        break;
+    }
+}
+
+static gboolean
+editor_search_engine_scan_chunk (EditorSearchEngine *self)
+{
+  GtkTextIter iter;
+  GtkTextIter limit;
+  guint end_offset;
+  guint limit_offset;
+  guint chunk;
+  guint first;
+
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+
+  end_offset = gtk_text_buffer_get_char_count (self->buffer);
+  first = self->matches->len;
+
+  if (self->scan_offset >= end_offset)
+    return FALSE;
+
+  /* A match may not end past @limit, so make sure the chunk is always
+   * larger than a match so that we continue to make progress.
+   */
+  chunk = MAX (SCAN_CHUNK_CHARS, self->query_len * 2);
+  limit_offset = MIN (end_offset, self->scan_offset + chunk);
+
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &iter, self->scan_offset);
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &limit, limit_offset);
+
+  if (self->use_literal)
+    editor_search_engine_scan_literal (self, &iter, &limit);
+  else
+    editor_search_engine_scan_iter (self, &iter, &limit);
+
+  if (limit_offset == end_offset)
+    {
+      self->scan_offset = end_offset;
+    }
+  else
+    {
+      /* Matches starting this close to @limit may have been cut off,
+       * so drop them and find them again with the next chunk. That
+       * keeps every candidate before scan_offset known and sorted.
+       */
+      self->scan_offset = limit_offset - self->query_len + 1;
+      editor_search_engine_truncate (self, self->scan_offset);
+    }
+
+  for (guint i = first; i < self->matches->len; i++)
+    editor_search_engine_highlight (self, &g_array_index (self->matches, Match, i));
+
+  return self->scan_offset < end_offset;
+}
+
+static void
+editor_search_engine_set_busy (EditorSearchEngine *self,
+                               gboolean            busy)
+{
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+
+  busy = !!busy;
+
+  if (busy != self->busy)
+    {
+      self->busy = busy;
+      g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_BUSY]);
+    }
+}
+
+static gboolean
+editor_search_engine_scan_cb (gint64   deadline,
+                              gpointer user_data)
+{
+  EditorSearchEngine *self = user_data;
+  guint occurrence_count;
+  gboolean has_more = TRUE;
+
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+
+  occurrence_count = self->occurrence_count;
+
+  do
+    {
+      if (self->refining != NULL)
+        has_more = editor_search_engine_refine (self) ||
+                   self->scan_offset < (guint)gtk_text_buffer_get_char_count (self->buffer);
+      else
+        has_more = editor_search_engine_scan_chunk (self);
+    }
+  while (has_more && g_get_monotonic_time () < deadline);
+
+  if (occurrence_count != self->occurrence_count)
+    g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_OCCURRENCE_COUNT]);
+
+  if (!has_more)
+    {
+      self->scan_source = 0;
+      editor_search_engine_set_busy (self, FALSE);
+      return G_SOURCE_REMOVE;
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+editor_search_engine_reset (EditorSearchEngine *self,
+                            gboolean            refine)
+{
+  guint occurrence_count;
+
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+
+  occurrence_count = self->occurrence_count;
+
+  gtk_source_scheduler_clear (&self->scan_source);
+
+  if (self->buffer != NULL)
+    editor_search_engine_unhighlight (self, 0, gtk_text_buffer_get_char_count (self->buffer));
+
+  if (refine)
+    {
+      /* Candidates before scan_offset are verified against the new
+       * query and the scan continues where it left off.
+       */
+      g_clear_pointer (&self->refining, g_array_unref);
+      self->refining = g_steal_pointer (&self->matches);
+      self->refine_pos = 0;
+      self->matches = g_array_new (FALSE, FALSE, sizeof (Match));
+    }
+  else
+    {
+      g_clear_pointer (&self->refining, g_array_unref);
+      g_array_set_size (self->matches, 0);
+      self->scan_offset = 0;
+    }
+
+  self->last_end = 0;
+  self->occurrence_count = 0;
+
+  if (self->active && self->buffer != NULL)
+    {
+      self->scan_source = gtk_source_scheduler_add (editor_search_engine_scan_cb, self);
+      editor_search_engine_set_busy (self, TRUE);
+    }
+  else
+    {
+      editor_search_engine_set_busy (self, FALSE);
+    }
+
+  if (occurrence_count != self->occurrence_count)
+    g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_OCCURRENCE_COUNT]);
+}
+
+static void
+editor_search_engine_renumber (EditorSearchEngine *self,
+                               guint               first,
+                               guint              *dirty_begin,
+                               guint              *dirty_end)
+{
+  guint occurrence_count = 0;
+  guint last_end = 0;
+
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+
+  for (guint i = first; i > 0; i--)
+    {
+      const Match *match = &g_array_index (self->matches, Match, i - 1);
+
+      if (match->position > 0)
+        {
+          occurrence_count = match->position;
+          last_end = match->end;
+          break;
+        }
+    }
+
+  for (guint i = first; i < self->matches->len; i++)
+    {
+      Match *match = &g_array_index (self->matches, Match, i);
+      guint position = 0;
+
+      if (match->begin >= last_end)
+        {
+          position = ++occurrence_count;
+          last_end = match->end;
+        }
+
+      /* Candidates which started or stopped overlapping an occurrence
+       * need their highlight updated too.
+       */
+      if ((position == 0) != (match->position == 0))
+        {
+          *dirty_begin = MIN (*dirty_begin, match->begin);
+          *dirty_end = MAX (*dirty_end, match->end);
+        }
+
+      match->position = position;
+    }
+
+  self->occurrence_count = occurrence_count;
+  self->last_end = last_end;
+}
+
+static void
+editor_search_engine_edited (EditorSearchEngine *self,
+                             guint               offset,
+                             guint               removed,
+                             guint               added)
+{
+  g_autoptr(GArray) found = NULL;
+  GtkTextIter iter;
+  GtkTextIter limit;
+  GtkTextIter match_begin;
+  GtkTextIter match_end;
+  guint occurrence_count;
+  guint dirty_begin;
+  guint dirty_end;
+  guint char_count;
+  guint first;
+  guint last;
+  guint lo;
+
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+
+  if (!self->active)
+    return;
+
+  /* Only lasts until the candidates of the previous query are verified */
+  if (self->refining != NULL)
+    {
+      editor_search_engine_reset (self, FALSE);
+      return;
+    }
+
+  /* Matches beginning this close to the edit may include edited text */
+  lo = offset > self->query_len - 1 ? offset - (self->query_len - 1) : 0;
+
+  /* The scan will get to the edit on its own */
+  if (lo >= self->scan_offset)
+    return;
+
+  occurrence_count = self->occurrence_count;
+  char_count = gtk_text_buffer_get_char_count (self->buffer);
+  first = editor_search_engine_bisect (self, lo);
+
+  /* Resume the scan from the edit rather than searching a large
+   * insertion or the unscanned part of a deletion right away.
+   */
+  if (self->scan_offset < offset + removed || added > SCAN_CHUNK_CHARS)
+    {
+      editor_search_engine_truncate (self, lo);
+      editor_search_engine_unhighlight (self, lo, char_count);
+      self->scan_offset = lo;
+
+      if (self->scan_source == 0)
+        {
+          self->scan_source = gtk_source_scheduler_add (editor_search_engine_scan_cb, self);
+          editor_search_engine_set_busy (self, TRUE);
+        }
+
+      if (occurrence_count != self->occurrence_count)
+        g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_OCCURRENCE_COUNT]);
+
+      return;
+    }
+
+  /* Drop candidates which may include edited text and shift the rest */
+  for (last = first;
+       last < self->matches->len && g_array_index (self->matches, Match, last).begin < offset + removed;
+       last++)
+    continue;
+  g_array_remove_range (self->matches, first, last - first);
+
+  for (guint i = first; i < self->matches->len; i++)
+    {
+      Match *match = &g_array_index (self->matches, Match, i);
+
+      match->begin = match->begin - removed + added;
+      match->end = match->end - removed + added;
+    }
+
+  self->scan_offset = self->scan_offset - removed + added;
+
+  /* Search again for candidates beginning before the end of the edit */
+  found = g_array_new (FALSE, FALSE, sizeof (Match));
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &iter, lo);
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &limit, MIN (char_count, offset + added + self->query_len));
+
+  while (gtk_text_iter_forward_search (&iter, self->query, self->flags, &match_begin, &match_end, &limit) &&
+         (guint)gtk_text_iter_get_offset (&match_begin) < offset + added)
+    {
+      Match match = {
+        gtk_text_iter_get_offset (&match_begin),
+        gtk_text_iter_get_offset (&match_end),
+        0
+      };
+
+      g_array_append_val (found, match);
+
+      iter = match_begin;
+      if (!gtk_text_iter_forward_char (&iter))
+        break;
+    }
+
+  g_array_insert_vals (self->matches, first, found->data, found->len);
+
+  dirty_begin = lo;
+  dirty_end = MIN (char_count, offset + added + self->query_len);
+  editor_search_engine_renumber (self, first, &dirty_begin, &dirty_end);
+
+  /* Occurrences overlapping the dirty range are highlighted again */
+  editor_search_engine_unhighlight (self, dirty_begin, dirty_end);
+  for (guint i = editor_search_engine_bisect (self, dirty_begin > self->query_len ? dirty_begin - self->query_len : 0);
+       i < self->matches->len && g_array_index (self->matches, Match, i).begin < dirty_end;
+       i++)
+    {
+      const Match *match = &g_array_index (self->matches, Match, i);
+
+      if (match->end > dirty_begin)
+        editor_search_engine_highlight (self, match);
+    }
+
+  if (occurrence_count != self->occurrence_count)
+    g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_OCCURRENCE_COUNT]);
+}
+
+static void
+editor_search_engine_insert_text_cb (EditorSearchEngine *self,
+                                     const GtkTextIter  *location,
+                                     const char         *text,
+                                     int                 length,
+                                     GtkTextBuffer      *buffer)
+{
+  guint n_chars;
+
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+  g_assert (GTK_IS_TEXT_BUFFER (buffer));
+
+  /* @location has been moved past the inserted text */
+  n_chars = g_utf8_strlen (text, length);
+  editor_search_engine_edited (self, gtk_text_iter_get_offset (location) - n_chars, 0, n_chars);
+}
+
+static void
+editor_search_engine_delete_range_cb (EditorSearchEngine *self,
+                                      const GtkTextIter  *begin,
+                                      const GtkTextIter  *end,
+                                      GtkTextBuffer      *buffer)
+{
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+  g_assert (GTK_IS_TEXT_BUFFER (buffer));
+
+  self->delete_offset = gtk_text_iter_get_offset (begin);
+  self->delete_length = gtk_text_iter_get_offset (end) - self->delete_offset;
+}
+
+static void
+editor_search_engine_delete_range_after_cb (EditorSearchEngine *self,
+                                            const GtkTextIter  *begin,
+                                            const GtkTextIter  *end,
+                                            GtkTextBuffer      *buffer)
+{
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+  g_assert (GTK_IS_TEXT_BUFFER (buffer));
+
+  editor_search_engine_edited (self, self->delete_offset, self->delete_length, 0);
+}
+
+static void
+editor_search_engine_dispose (GObject *object)
+{
+  EditorSearchEngine *self = (EditorSearchEngine *)object;
+
+  gtk_source_scheduler_clear (&self->scan_source);
+
+  if (self->buffer != NULL)
+    {
+      g_signal_handlers_disconnect_by_data (self->buffer, self);
+
+      if (self->tag != NULL)
+        gtk_text_tag_table_remove (gtk_text_buffer_get_tag_table (self->buffer), self->tag);
+
+      g_clear_weak_pointer (&self->buffer);
+    }
+
+  g_clear_object (&self->tag);
+
+  g_clear_object (&self->settings);
+
+  G_OBJECT_CLASS (editor_search_engine_parent_class)->dispose (object);
+}
+
+static void
+editor_search_engine_finalize (GObject *object)
+{
+  EditorSearchEngine *self = (EditorSearchEngine *)object;
+
+  g_clear_pointer (&self->matches, g_array_unref);
+  g_clear_pointer (&self->refining, g_array_unref);
+  g_clear_pointer (&self->query, g_free);
+
+  G_OBJECT_CLASS (editor_search_engine_parent_class)->finalize (object);
+}
+
+static void
+editor_search_engine_get_property (GObject    *object,
+                                   guint       prop_id,
+                                   GValue     *value,
+                                   GParamSpec *pspec)
+{
+  EditorSearchEngine *self = EDITOR_SEARCH_ENGINE (object);
+
+  switch (prop_id)
+    {
+    case PROP_BUSY:
+      g_value_set_boolean (value, _editor_search_engine_get_busy (self));
+      break;
+
+    case PROP_OCCURRENCE_COUNT:
+      g_value_set_uint (value, _editor_search_engine_get_occurrence_count (self));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+editor_search_engine_class_init (EditorSearchEngineClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = editor_search_engine_dispose;
+  object_class->finalize = editor_search_engine_finalize;
+  object_class->get_property = editor_search_engine_get_property;
+
+  properties [PROP_BUSY] =
+    g_param_spec_boolean ("busy",
+                          "Busy",
+                          "If the buffer is still being scanned",
+                          FALSE,
+                          (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  properties [PROP_OCCURRENCE_COUNT] =
+    g_param_spec_uint ("occurrence-count",
+                       "Occurrence Count",
+                       "The number of occurrences found so far",
+                       0, G_MAXUINT, 0,
+                       (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_properties (object_class, N_PROPS, properties);
+}
+
+static void
+editor_search_engine_init (EditorSearchEngine *self)
+{
+  self->matches = g_array_new (FALSE, FALSE, sizeof (Match));
+}
+
+EditorSearchEngine *
+_editor_search_engine_new (GtkTextBuffer           *buffer,
+                           GtkSourceSearchSettings *settings)
+{
+  EditorSearchEngine *self;
+
+  g_return_val_if_fail (GTK_SOURCE_IS_BUFFER (buffer), NULL);
+  g_return_val_if_fail (GTK_SOURCE_IS_SEARCH_SETTINGS (settings), NULL);
+
+  self = g_object_new (EDITOR_TYPE_SEARCH_ENGINE, NULL);
+  self->settings = g_object_ref (settings);
+  self->tag = g_object_ref (gtk_text_buffer_create_tag (buffer, NULL, NULL));
+  g_set_weak_pointer (&self->buffer, buffer);
+
+  editor_search_engine_update_style (self);
+
+  g_signal_connect_object (buffer,
+                           "notify::style-scheme",
+                           G_CALLBACK (editor_search_engine_update_style),
+                           self,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect_object (buffer,
+                           "insert-text",
+                           G_CALLBACK (editor_search_engine_insert_text_cb),
+                           self,
+                           G_CONNECT_SWAPPED | G_CONNECT_AFTER);
+  g_signal_connect_object (buffer,
+                           "delete-range",
+                           G_CALLBACK (editor_search_engine_delete_range_cb),
+                           self,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect_object (buffer,
+                           "delete-range",
+                           G_CALLBACK (editor_search_engine_delete_range_after_cb),
+                           self,
+                           G_CONNECT_SWAPPED | G_CONNECT_AFTER);
+
+  return self;
+}
+
+/**
+ * _editor_search_engine_update:
+ * @self: an #EditorSearchEngine
+ *
+ * Applies changes to the search settings, cancelling the current scan
+ * and starting a new one if necessary.
+ */
+void
+_editor_search_engine_update (EditorSearchEngine *self)
+{
+  GtkTextSearchFlags flags = GTK_TEXT_SEARCH_VISIBLE_ONLY | GTK_TEXT_SEARCH_TEXT_ONLY;
+  const char *query;
+  gboolean active;
+  gboolean refine;
+
+  g_return_if_fail (EDITOR_IS_SEARCH_ENGINE (self));
+
+  query = gtk_source_search_settings_get_search_text (self->settings);
+  active = query != NULL &&
+           query[0] != 0 &&
+           !gtk_source_search_settings_get_regex_enabled (self->settings) &&
+           !gtk_source_search_settings_get_at_word_boundaries (self->settings);
+
+  if (!gtk_source_search_settings_get_case_sensitive (self->settings))
+    flags |= GTK_TEXT_SEARCH_CASE_INSENSITIVE;
+
+  if (!active)
+    {
+      g_clear_pointer (&self->query, g_free);
+      self->active = FALSE;
+      editor_search_engine_reset (self, FALSE);
+      return;
+    }
+
+  if (self->active && flags == self->flags && g_strcmp0 (query, self->query) == 0)
+    return;
+
+  refine = self->active &&
+           flags == self->flags &&
+           self->query != NULL &&
+           g_str_has_prefix (query, self->query);
+
+  g_free (self->query);
+  self->query = g_strdup (query);
+  /* Upper bound on the number of characters a match may span */
+  self->query_len = strlen (query);
+  self->flags = flags;
+  self->active = TRUE;
+  self->use_literal = _editor_literal_search_init (&self->literal,
+                                                   self->query,
+                                                   gtk_source_search_settings_get_case_sensitive (self->settings));
+
+  editor_search_engine_reset (self, refine);
+}
+
+gboolean
+_editor_search_engine_get_active (EditorSearchEngine *self)
+{
+  g_return_val_if_fail (EDITOR_IS_SEARCH_ENGINE (self), FALSE);
+
+  return self->active;
+}
+
+gboolean
+_editor_search_engine_get_busy (EditorSearchEngine *self)
+{
+  g_return_val_if_fail (EDITOR_IS_SEARCH_ENGINE (self), FALSE);
+
+  return self->busy;
+}
+
+guint
+_editor_search_engine_get_occurrence_count (EditorSearchEngine *self)
+{
+  g_return_val_if_fail (EDITOR_IS_SEARCH_ENGINE (self), 0);
+
+  return self->occurrence_count;
+}
+
+static const Match *
+editor_search_engine_lookup (EditorSearchEngine *self,
+                             guint               offset)
+{
+  guint lo;
+
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+
+  for (lo = editor_search_engine_bisect (self, offset); lo < self->matches->len; lo++)
+    {
+      const Match *match = &g_array_index (self->matches, Match, lo);
+
+      if (match->position > 0)
+        return match;
+    }
+
+  return NULL;
+}
+
+static const Match *
+editor_search_engine_lookup_before (EditorSearchEngine *self,
+                                    guint               offset)
+{
+  g_assert (EDITOR_IS_SEARCH_ENGINE (self));
+
+  /* Find the last occurrence ending at or before @offset */
+  for (guint i = editor_search_engine_bisect (self, offset); i > 0; i--)
+    {
+      const Match *match = &g_array_index (self->matches, Match, i - 1);
+
+      if (match->position > 0 && match->end <= offset)
+        return match;
+    }
+
+  return NULL;
+}
+
+/**
+ * _editor_search_engine_get_occurrence_position:
+ * @self: an #EditorSearchEngine
+ * @match_begin: the start of a possible match
+ * @match_end: the end of a possible match
+ *
+ * Returns: the 1-based position of the occurrence, 0 if the range is
+ *   not an occurrence, or -1 if that part of the buffer has not been
+ *   scanned yet.
+ */
+int
+_editor_search_engine_get_occurrence_position (EditorSearchEngine *self,
+                                               const GtkTextIter  *match_begin,
+                                               const GtkTextIter  *match_end)
+{
+  const Match *match;
+  guint begin;
+
+  g_return_val_if_fail (EDITOR_IS_SEARCH_ENGINE (self), -1);
+  g_return_val_if_fail (match_begin != NULL, -1);
+  g_return_val_if_fail (match_end != NULL, -1);
+
+  if (!self->active)
+    return 0;
+
+  begin = gtk_text_iter_get_offset (match_begin);
+
+  if (self->refining != NULL || begin >= self->scan_offset)
+    return -1;
+
+  if ((match = editor_search_engine_lookup (self, begin)) &&
+      match->begin == begin &&
+      match->end == (guint)gtk_text_iter_get_offset (match_end))
+    return match->position;
+
+  return 0;
+}
+
+static gboolean
+editor_search_engine_get_match (EditorSearchEngine *self,
+                                const Match        *match,
+                                GtkTextIter        *match_begin,
+                                GtkTextIter        *match_end)
+{
+  if (match == NULL)
+    return FALSE;
+
+  gtk_text_buffer_get_iter_at_offset (self->buffer, match_begin, match->begin);
+  gtk_text_buffer_get_iter_at_offset (self->buffer, match_end, match->end);
+
+  return TRUE;
+}
+
+/**
+ * _editor_search_engine_find_nearest:
+ * @self: an #EditorSearchEngine
+ * @from: the position to search from
+ * @match_begin: (out): location for the start of the match
+ * @match_end: (out): location for the end of the match
+ *
+ * Finds the first occurrence at or after @from, wrapping around to the
+ * start of the buffer if necessary.
+ *
+ * This does not wait for the background scan to complete. Occurrences
+ * which have already been found are used when possible, otherwise only
+ * a small part of the buffer past what has been scanned is searched so
+ * that this never has to walk the whole buffer. Callers should try again
+ * as the scan progresses if no match was found while #EditorSearchEngine:busy
+ * is set.
+ *
+ * Returns: %TRUE if a match was found
+ */
+gboolean
+_editor_search_engine_find_nearest (EditorSearchEngine *self,
+                                    const GtkTextIter  *from,
+                                    GtkTextIter        *match_begin,
+                                    GtkTextIter        *match_end)
+{
+  GtkTextIter iter;
+  GtkTextIter limit;
+  guint offset;
+
+  g_return_val_if_fail (EDITOR_IS_SEARCH_ENGINE (self), FALSE);
+  g_return_val_if_fail (from != NULL, FALSE);
+  g_return_val_if_fail (match_begin != NULL, FALSE);
+  g_return_val_if_fail (match_end != NULL, FALSE);
+
+  if (!self->active || self->buffer == NULL)
+    return FALSE;
+
+  offset = gtk_text_iter_get_offset (from);
+
+  if (self->refining == NULL)
+    {
+      if (editor_search_engine_get_match (self,
+                                          editor_search_engine_lookup (self, offset),
+                                          match_begin, match_end))
+        return TRUE;
+
+      /* Everything before scan_offset is known to have no match */
+      offset = MAX (offset, self->scan_offset);
+    }
+
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &iter, offset);
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &limit, offset + NEAREST_CHARS);
+  if (gtk_text_iter_forward_search (&iter, self->query, self->flags, match_begin, match_end, &limit))
+    return TRUE;
+
+  /* Only wrap around once every occurrence is known */
+  if (self->busy)
+    return FALSE;
+
+  return editor_search_engine_get_match (self,
+                                         editor_search_engine_lookup (self, 0),
+                                         match_begin, match_end);
+}
+
+/**
+ * _editor_search_engine_forward:
+ * @self: an #EditorSearchEngine
+ * @from: the position to search from
+ * @match_begin: (out): location for the start of the match
+ * @match_end: (out): location for the end of the match
+ *
+ * Finds the next occurrence at or after @from, wrapping around to the
+ * start of the buffer if necessary. Unlike
+ * _editor_search_engine_find_nearest(), the part of the buffer which has
+ * not been scanned yet is searched in full.
+ *
+ * Returns: %TRUE if a match was found
+ */
+gboolean
+_editor_search_engine_forward (EditorSearchEngine *self,
+                               const GtkTextIter  *from,
+                               GtkTextIter        *match_begin,
+                               GtkTextIter        *match_end)
+{
+  GtkTextIter iter;
+  guint offset;
+
+  g_return_val_if_fail (EDITOR_IS_SEARCH_ENGINE (self), FALSE);
+  g_return_val_if_fail (from != NULL, FALSE);
+  g_return_val_if_fail (match_begin != NULL, FALSE);
+  g_return_val_if_fail (match_end != NULL, FALSE);
+
+  if (!self->active || self->buffer == NULL)
+    return FALSE;
+
+  offset = gtk_text_iter_get_offset (from);
+
+  if (self->refining == NULL)
+    {
+      if (editor_search_engine_get_match (self,
+                                          editor_search_engine_lookup (self, offset),
+                                          match_begin, match_end))
+        return TRUE;
+
+      offset = MAX (offset, self->scan_offset);
+    }
+
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &iter, offset);
+  if (gtk_text_iter_forward_search (&iter, self->query, self->flags, match_begin, match_end, NULL))
+    return TRUE;
+
+  if (self->refining == NULL &&
+      editor_search_engine_get_match (self,
+                                      editor_search_engine_lookup (self, 0),
+                                      match_begin, match_end))
+    return TRUE;
+
+  gtk_text_buffer_get_start_iter (self->buffer, &iter);
+  return gtk_text_iter_forward_search (&iter, self->query, self->flags, match_begin, match_end, from);
+}
+
+/**
+ * _editor_search_engine_backward:
+ * @self: an #EditorSearchEngine
+ * @from: the position to search from
+ * @match_begin: (out): location for the start of the match
+ * @match_end: (out): location for the end of the match
+ *
+ * Finds the previous occurrence ending at or before @from, wrapping
+ * around to the end of the buffer if necessary.
+ *
+ * Returns: %TRUE if a match was found
+ */
+gboolean
+_editor_search_engine_backward (EditorSearchEngine *self,
+                                const GtkTextIter  *from,
+                                GtkTextIter        *match_begin,
+                                GtkTextIter        *match_end)
+{
+  GtkTextIter iter;
+
+  g_return_val_if_fail (EDITOR_IS_SEARCH_ENGINE (self), FALSE);
+  g_return_val_if_fail (from != NULL, FALSE);
+  g_return_val_if_fail (match_begin != NULL, FALSE);
+  g_return_val_if_fail (match_end != NULL, FALSE);
+
+  if (!self->active || self->buffer == NULL)
+    return FALSE;
+
+  /* Every occurrence is known once the scan has completed */
+  if (self->refining == NULL && !self->busy)
+    return editor_search_engine_get_match (self,
+                                           editor_search_engine_lookup_before (self, gtk_text_iter_get_offset (from)),
+                                           match_begin, match_end) ||
+           editor_search_engine_get_match (self,
+                                           editor_search_engine_lookup_before (self, G_MAXUINT),
+                                           match_begin, match_end);
+
+  iter = *from;
+  if (gtk_text_iter_backward_search (&iter, self->query, self->flags, match_begin, match_end, NULL))
+    return TRUE;
+
+  gtk_text_buffer_get_end_iter (self->buffer, &iter);
+  return gtk_text_iter_backward_search (&iter, self->query, self->flags, match_begin, match_end, from);
+}
+
+/**
+ * _editor_search_engine_list_occurrences:
+ * @self: an #EditorSearchEngine
+ *
+ * Completes the scan of the buffer, if necessary, and lists the offsets
+ * of every occurrence so that they may be replaced in bulk.
+ *
+ * Returns: (transfer full) (element-type EditorSearchOccurrence): an array
+ *   of occurrences sorted by offset
+ */
+GArray *
+_editor_search_engine_list_occurrences (EditorSearchEngine *self)
+{
+  GArray *ret;
+  guint occurrence_count;
+
+  g_return_val_if_fail (EDITOR_IS_SEARCH_ENGINE (self), NULL);
+
+  if (!self->active || self->buffer == NULL)
+    return g_array_new (FALSE, FALSE, sizeof (EditorSearchOccurrence));
+
+  occurrence_count = self->occurrence_count;
+
+  gtk_source_scheduler_clear (&self->scan_source);
+
+  while (self->refining != NULL)
+    editor_search_engine_refine (self);
+
+  while (editor_search_engine_scan_chunk (self))
+    continue;
+
+  editor_search_engine_set_busy (self, FALSE);
+
+  if (occurrence_count != self->occurrence_count)
+    g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_OCCURRENCE_COUNT]);
+
+  ret = g_array_sized_new (FALSE, FALSE, sizeof (EditorSearchOccurrence), self->occurrence_count);
+
+  for (guint i = 0; i < self->matches->len; i++)
+    {
+      const Match *match = &g_array_index (self->matches, Match, i);
+      EditorSearchOccurrence occurrence = { match->begin, match->end };
+
+      if (match->position > 0)
+        g_array_append_val (ret, occurrence);
+    }
+
+  return ret;
+}
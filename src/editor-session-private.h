@@ -43,13 +43,23 @@ struct _EditorSession
   GHashTable         *forgot;
   GArray             *drafts;
   EditorSidebarModel *recents;
+  EditorWindow       *snapshot_window;
+  GHashTable         *queued_loads;
+  GQueue              local_loads;
+  GQueue              remote_loads;
+
+  gint64              restore_begin_time;
 
   guint               auto_save_delay;
   guint               auto_save_source;
+  guint               n_local_loading;
+  guint               n_remote_loading;
+  guint               pump_loads_source;
 
 
   guint               auto_save : 1;
   guint               did_restore : 1;
+  guint               restoring : 1;
   guint               restore_pages : 1;
   guint               dirty : 1;
 };
@@ -57,6 +67,7 @@ struct _EditorSession
 EditorSession *_editor_session_new                    (void);
 EditorWindow  *_editor_session_create_window_no_draft (EditorSession  *self);
 gboolean       _editor_session_did_restore            (EditorSession  *self);
+gboolean       _editor_session_restore_snapshot       (EditorSession  *self);
 GPtrArray     *_editor_session_get_pages              (EditorSession  *self);
 void           _editor_session_document_seen          (EditorSession  *self,
                                                        EditorDocument *document);
@@ -72,6 +83,10 @@ void           _editor_session_remove_draft           (EditorSession  *self,
 EditorPage    *_editor_session_open_draft             (EditorSession  *self,
                                                        EditorWindow   *window,
                                                        const gchar    *draft_id);
+void           _editor_session_open_files             (EditorSession  *self,
+                                                       EditorWindow   *window,
+                                                       GFile         **files,
+                                                       guint           n_files);
 void           _editor_session_move_page_to_window    (EditorSession  *session,
                                                        EditorPage     *page,
                                                        EditorWindow   *window);
@@ -28,17 +28,23 @@
 #include "editor-document-private.h"
 #include "editor-page-private.h"
 #include "editor-session-private.h"
+#include "editor-trace-private.h"
 #include "editor-window-private.h"
 
 #define DEFAULT_AUTO_SAVE_TIMEOUT_SECONDS 3
 #define MAX_AUTO_SAVE_TIMEOUT_SECONDS (60*5)
 #define MAX_BOOKMARKS 100
+#define MAX_LOCAL_LOADS 4
+#define MAX_REMOTE_LOADS 2
+#define OPEN_BATCH_FRAME_BUDGET_USEC 4000
 
 typedef struct
 {
   GApplication *app;
   GFile        *state_file;
   GBytes       *state_bytes;
+  GFile        *snapshot_file;
+  GBytes       *snapshot_bytes;
   GPtrArray    *seen;
   GPtrArray    *forgot;
   guint         n_active;
@@ -62,6 +68,29 @@ typedef struct
   GDateTime *age;
 } Recent;
 
+typedef struct
+{
+  EditorSession       *self;
+  EditorPage          *page;
+  GAsyncReadyCallback  callback;
+  gpointer             user_data;
+  GDestroyNotify       user_data_destroy;
+  guint                is_remote : 1;
+} EditorSessionLoad;
+
+typedef struct
+{
+  GFile *file;
+  char  *draft_id;
+} EditorSessionOpen;
+
+typedef struct
+{
+  EditorSession *self;
+  GArray        *queue;
+  guint          pos;
+} EditorSessionBatch;
+
 G_DEFINE_TYPE (EditorSession, editor_session, G_TYPE_OBJECT)
 
 enum {
@@ -140,11 +169,22 @@ get_bookmarks_filename (void)
                            NULL);
 }
 
+static gchar *
+get_snapshot_filename (void)
+{
+  return g_build_filename (g_get_user_data_dir (),
+                           APP_ID,
+                           "startup.gvariant",
+                           NULL);
+}
+
 static void
 editor_session_save_free (EditorSessionSave *state)
 {
   g_clear_pointer (&state->state_bytes, g_bytes_unref);
   g_clear_object (&state->state_file);
+  g_clear_pointer (&state->snapshot_bytes, g_bytes_unref);
+  g_clear_object (&state->snapshot_file);
   g_clear_pointer (&state->app, g_application_release);
   g_clear_pointer (&state->seen, g_ptr_array_unref);
   g_clear_pointer (&state->forgot, g_ptr_array_unref);
@@ -180,104 +220,140 @@ add_draft_state (EditorSession   *self,
 }
 
 static void
-add_window_state (EditorSession   *self,
-                  GVariantBuilder *builder)
+add_window (EditorSession   *self,
+            GVariantBuilder *builder,
+            EditorWindow    *window)
 {
+  const GList *pages = _editor_window_get_pages (window);
+  gboolean is_active = gtk_window_is_active (GTK_WINDOW (window));
+  gint width, height;
+
   g_assert (EDITOR_IS_SESSION (self));
   g_assert (builder != NULL);
+  g_assert (EDITOR_IS_WINDOW (window));
 
+  g_variant_builder_open (builder, G_VARIANT_TYPE ("a{sv}"));
+
+  /* Track if this should be the foreground window */
+  if (is_active)
+    g_variant_builder_add_parsed (builder, "{'is-active', <%b>}", is_active);
+
+  /* Store the window size */
+  width = gtk_widget_get_width (GTK_WIDGET (window));
+  height = gtk_widget_get_height (GTK_WIDGET (window));
+  g_variant_builder_add_parsed (builder,
+                                "{'size', <(%u,%u)>}",
+                                CLAMP (width, 0, 10000),
+                                CLAMP (height, 0, 10000));
+
+  /* Add all of the pages from the window */
   g_variant_builder_open (builder, G_VARIANT_TYPE ("{sv}"));
-  g_variant_builder_add (builder, "s", "windows");
+  g_variant_builder_add (builder, "s", "pages");
   g_variant_builder_open (builder, G_VARIANT_TYPE ("v"));
   g_variant_builder_open (builder, G_VARIANT_TYPE ("aa{sv}"));
-
-  for (guint i = 0; i < self->windows->len; i++)
+  for (const GList *iter = pages; iter; iter = iter->next)
     {
-      EditorWindow *window = g_ptr_array_index (self->windows, i);
-      const GList *pages = _editor_window_get_pages (window);
-      gboolean is_active = gtk_window_is_active (GTK_WINDOW (window));
-      gint width, height;
+      EditorPage *page = iter->data;
+      EditorDocument *document = editor_page_get_document (page);
+      GtkSourceLanguage *language = gtk_source_buffer_get_language (GTK_SOURCE_BUFFER (document));
+      GFile *file = editor_document_get_file (document);
+      const gchar *draft_id = _editor_document_get_draft_id (document);
+      const GtkSourceEncoding *encoding = _editor_document_get_encoding (document);
+      gboolean page_is_active = editor_page_is_active (page);
+      GtkTextMark *insert = gtk_text_buffer_get_insert (GTK_TEXT_BUFFER (document));
+      GtkTextMark *bound = gtk_text_buffer_get_selection_bound (GTK_TEXT_BUFFER (document));
+      GtkTextIter begin, end;
+      Selection sel;
 
-      g_variant_builder_open (builder, G_VARIANT_TYPE ("a{sv}"));
+      /* If this is a draft (meaning no backing file has been set) and
+       * there are no modifications, we should ignore this page as we don't
+       * want to restore it.
+       */
+      if (editor_page_get_can_discard (page))
+        continue;
 
-      /* Track if this should be the foreground window */
-      if (is_active)
-        g_variant_builder_add_parsed (builder, "{'is-active', <%b>}", is_active);
-
-      /* Store the window size */
-      width = gtk_widget_get_width (GTK_WIDGET (window));
-      height = gtk_widget_get_height (GTK_WIDGET (window));
-      g_variant_builder_add_parsed (builder,
-                                    "{'size', <(%u,%u)>}",
-                                    CLAMP (width, 0, 10000),
-                                    CLAMP (height, 0, 10000));
-
-      /* Add all of the pages from the window */
-      g_variant_builder_open (builder, G_VARIANT_TYPE ("{sv}"));
-      g_variant_builder_add (builder, "s", "pages");
-      g_variant_builder_open (builder, G_VARIANT_TYPE ("v"));
-      g_variant_builder_open (builder, G_VARIANT_TYPE ("aa{sv}"));
-      for (const GList *iter = pages; iter; iter = iter->next)
+      gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (document), &begin, insert);
+      gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (document), &end, bound);
+
+      sel.begin.line = gtk_text_iter_get_line (&begin);
+      sel.begin.line_offset = gtk_text_iter_get_line_offset (&begin);
+      sel.end.line = gtk_text_iter_get_line (&end);
+      sel.end.line_offset = gtk_text_iter_get_line_offset (&end);
+
+      g_variant_builder_open (builder, G_VARIANT_TYPE ("a{sv}"));
+      g_variant_builder_add_parsed (builder, "{'draft-id', <%s>}", draft_id);
+      if (language != NULL)
+        g_variant_builder_add_parsed (builder,
+                                      "{'language', <%s>}",
+                                      gtk_source_language_get_id (language));
+      if (encoding != NULL)
+        g_variant_builder_add_parsed (builder,
+                                      "{'encoding', <%s>}",
+                                      gtk_source_encoding_get_charset (encoding));
+      g_variant_builder_add (builder, "{sv}", "selection", selection_to_variant (&sel));
+      if (page_is_active)
+        g_variant_builder_add_parsed (builder, "{'is-active', <%b>}", page_is_active);
+      if (file != NULL)
         {
-          EditorPage *page = iter->data;
-          EditorDocument *document = editor_page_get_document (page);
-          GtkSourceLanguage *language = gtk_source_buffer_get_language (GTK_SOURCE_BUFFER (document));
-          GFile *file = editor_document_get_file (document);
-          const gchar *draft_id = _editor_document_get_draft_id (document);
-          const GtkSourceEncoding *encoding = _editor_document_get_encoding (document);
-          gboolean page_is_active = editor_page_is_active (page);
-          GtkTextMark *insert = gtk_text_buffer_get_insert (GTK_TEXT_BUFFER (document));
-          GtkTextMark *bound = gtk_text_buffer_get_selection_bound (GTK_TEXT_BUFFER (document));
-          GtkTextIter begin, end;
-          Selection sel;
-
-          /* If this is a draft (meaning no backing file has been set) and
-           * there are no modifications, we should ignore this page as we don't
-           * want to restore it.
-           */
-          if (editor_page_get_can_discard (page))
-            continue;
-
-          gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (document), &begin, insert);
-          gtk_text_buffer_get_iter_at_mark (GTK_TEXT_BUFFER (document), &end, bound);
-
-          sel.begin.line = gtk_text_iter_get_line (&begin);
-          sel.begin.line_offset = gtk_text_iter_get_line_offset (&begin);
-          sel.end.line = gtk_text_iter_get_line (&end);
-          sel.end.line_offset = gtk_text_iter_get_line_offset (&end);
-
-          g_variant_builder_open (builder, G_VARIANT_TYPE ("a{sv}"));
-          g_variant_builder_add_parsed (builder, "{'draft-id', <%s>}", draft_id);
-          if (language != NULL)
-            g_variant_builder_add_parsed (builder,
-                                          "{'language', <%s>}",
-                                          gtk_source_language_get_id (language));
-          if (encoding != NULL)
-            g_variant_builder_add_parsed (builder,
-                                          "{'encoding', <%s>}",
-                                          gtk_source_encoding_get_charset (encoding));
-          g_variant_builder_add (builder, "{sv}", "selection", selection_to_variant (&sel));
-          if (page_is_active)
-            g_variant_builder_add_parsed (builder, "{'is-active', <%b>}", page_is_active);
-          if (file != NULL)
-            {
-              g_autofree gchar *uri = g_file_get_uri (file);
-              g_variant_builder_add_parsed (builder, "{'uri', <%s>}", uri);
-            }
-          g_variant_builder_close (builder);
+          g_autofree gchar *uri = g_file_get_uri (file);
+          g_variant_builder_add_parsed (builder, "{'uri', <%s>}", uri);
         }
       g_variant_builder_close (builder);
-      g_variant_builder_close (builder);
-      g_variant_builder_close (builder);
-
-      g_variant_builder_close (builder);
     }
+  g_variant_builder_close (builder);
+  g_variant_builder_close (builder);
+  g_variant_builder_close (builder);
+
+  g_variant_builder_close (builder);
+}
+
+static void
+add_window_state (EditorSession   *self,
+                  GVariantBuilder *builder)
+{
+  g_assert (EDITOR_IS_SESSION (self));
+  g_assert (builder != NULL);
+
+  g_variant_builder_open (builder, G_VARIANT_TYPE ("{sv}"));
+  g_variant_builder_add (builder, "s", "windows");
+  g_variant_builder_open (builder, G_VARIANT_TYPE ("v"));
+  g_variant_builder_open (builder, G_VARIANT_TYPE ("aa{sv}"));
+
+  for (guint i = 0; i < self->windows->len; i++)
+    add_window (self, builder, g_ptr_array_index (self->windows, i));
 
   g_variant_builder_close (builder);
   g_variant_builder_close (builder);
   g_variant_builder_close (builder);
 }
 
+/* The startup snapshot contains only the first window of the session
+ * so that it is cheap to load synchronously and the window can be
+ * displayed before the rest of the session has been restored.
+ */
+static GVariant *
+create_snapshot (EditorSession *self)
+{
+  GVariantBuilder builder;
+
+  g_assert (EDITOR_IS_SESSION (self));
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+  g_variant_builder_add_parsed (&builder, "{'version', <%u>}", 1);
+
+  if (self->windows->len > 0)
+    {
+      g_variant_builder_open (&builder, G_VARIANT_TYPE ("{sv}"));
+      g_variant_builder_add (&builder, "s", "window");
+      g_variant_builder_open (&builder, G_VARIANT_TYPE ("v"));
+      add_window (self, &builder, g_ptr_array_index (self->windows, 0));
+      g_variant_builder_close (&builder);
+      g_variant_builder_close (&builder);
+    }
+
+  return g_variant_builder_end (&builder);
+}
+
 static EditorWindow *
 find_or_create_window (EditorSession *self)
 {
@@ -305,6 +381,25 @@ find_or_create_window (EditorSession *self)
   return window;
 }
 
+static EditorPage *
+find_page_for_draft_id (EditorSession *self,
+                        const gchar   *draft_id)
+{
+  g_assert (EDITOR_IS_SESSION (self));
+  g_assert (draft_id != NULL);
+
+  for (guint i = 0; i < self->pages->len; i++)
+    {
+      EditorPage *page = g_ptr_array_index (self->pages, i);
+      EditorDocument *document = editor_page_get_document (page);
+
+      if (g_strcmp0 (_editor_document_get_draft_id (document), draft_id) == 0)
+        return page;
+    }
+
+  return NULL;
+}
+
 static EditorPage *
 find_page_for_file (EditorSession *self,
                     GFile         *file)
@@ -325,6 +420,284 @@ find_page_for_file (EditorSession *self,
   return NULL;
 }
 
+static void
+editor_session_load_free (EditorSessionLoad *load)
+{
+  if (load->user_data != NULL && load->user_data_destroy != NULL)
+    load->user_data_destroy (load->user_data);
+
+  g_clear_object (&load->page);
+  g_clear_object (&load->self);
+  g_slice_free (EditorSessionLoad, load);
+}
+
+static void editor_session_pump_loads (EditorSession *self);
+
+static void
+editor_session_load_page_cb (GObject      *object,
+                             GAsyncResult *result,
+                             gpointer      user_data)
+{
+  EditorDocument *document = (EditorDocument *)object;
+  EditorSessionLoad *load = user_data;
+  g_autoptr(EditorSession) self = NULL;
+
+  g_assert (EDITOR_IS_DOCUMENT (document));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (load != NULL);
+  g_assert (EDITOR_IS_SESSION (load->self));
+
+  self = g_object_ref (load->self);
+
+  if (load->callback != NULL)
+    {
+      load->callback (object, result, g_steal_pointer (&load->user_data));
+    }
+  else
+    {
+      g_autoptr(GError) error = NULL;
+
+      if (!_editor_document_load_finish (document, result, &error))
+        g_debug ("Failed to load document: %s", error->message);
+    }
+
+  if (load->is_remote)
+    {
+      g_assert (self->n_remote_loading > 0);
+      self->n_remote_loading--;
+    }
+  else
+    {
+      g_assert (self->n_local_loading > 0);
+      self->n_local_loading--;
+    }
+
+  editor_session_load_free (load);
+
+  editor_session_pump_loads (self);
+}
+
+static void
+editor_session_start_load (EditorSession     *self,
+                           EditorSessionLoad *load)
+{
+  EditorDocument *document;
+  EditorWindow *window;
+  gint io_priority;
+
+  g_assert (EDITOR_IS_SESSION (self));
+  g_assert (load != NULL);
+  g_assert (EDITOR_IS_PAGE (load->page));
+
+  document = editor_page_get_document (load->page);
+  window = _editor_page_get_window (load->page);
+
+  /* The window may have been closed, or the user may have reloaded
+   * the page, while it was waiting for its turn.
+   */
+  if (window == NULL || _editor_document_get_loading (document))
+    {
+      editor_session_load_free (load);
+      return;
+    }
+
+  if (load->is_remote)
+    self->n_remote_loading++;
+  else
+    self->n_local_loading++;
+
+  /* Only hold the session while the load is in flight */
+  load->self = g_object_ref (self);
+
+  /* Let the page the user is looking at win the main loop against
+   * the background loads when inserting text.
+   */
+  if (editor_window_get_visible_page (window) == load->page)
+    io_priority = G_PRIORITY_DEFAULT;
+  else
+    io_priority = G_PRIORITY_LOW;
+
+  _editor_document_load_async (document,
+                               window,
+                               io_priority,
+                               NULL,
+                               editor_session_load_page_cb,
+                               load);
+}
+
+static EditorSessionLoad *
+editor_session_dequeue_load (EditorSession *self,
+                             EditorPage    *page)
+{
+  EditorSessionLoad *load;
+  GList *link;
+
+  g_assert (EDITOR_IS_SESSION (self));
+  g_assert (EDITOR_IS_PAGE (page));
+
+  if (!(link = g_hash_table_lookup (self->queued_loads, page)))
+    return NULL;
+
+  load = link->data;
+
+  g_hash_table_remove (self->queued_loads, page);
+
+  if (load->is_remote)
+    g_queue_delete_link (&self->remote_loads, link);
+  else
+    g_queue_delete_link (&self->local_loads, link);
+
+  return load;
+}
+
+static gboolean
+editor_session_can_start_load (EditorSession *self,
+                               gboolean       is_remote)
+{
+  g_assert (EDITOR_IS_SESSION (self));
+
+  if (is_remote)
+    return self->n_remote_loading < MAX_REMOTE_LOADS;
+  else
+    return self->n_local_loading < MAX_LOCAL_LOADS;
+}
+
+static void
+editor_session_start_visible_load (EditorSession *self,
+                                   EditorWindow  *window)
+{
+  EditorSessionLoad *load;
+  GList *link;
+  EditorPage *page;
+
+  g_assert (EDITOR_IS_SESSION (self));
+  g_assert (EDITOR_IS_WINDOW (window));
+
+  if (!(page = editor_window_get_visible_page (window)) ||
+      !(link = g_hash_table_lookup (self->queued_loads, page)))
+    return;
+
+  load = link->data;
+
+  if (editor_session_can_start_load (self, load->is_remote))
+    editor_session_start_load (self, editor_session_dequeue_load (self, page));
+}
+
+static void
+editor_session_pump_loads (EditorSession *self)
+{
+  EditorSessionLoad *load;
+  GtkWindow *active;
+
+  g_assert (EDITOR_IS_SESSION (self));
+
+  g_clear_handle_id (&self->pump_loads_source, g_source_remove);
+
+  if (g_hash_table_size (self->queued_loads) == 0)
+    return;
+
+  /* Pages that are visible go first, starting with the focused window */
+  active = gtk_application_get_active_window (GTK_APPLICATION (EDITOR_APPLICATION_DEFAULT));
+
+  if (EDITOR_IS_WINDOW (active))
+    editor_session_start_visible_load (self, EDITOR_WINDOW (active));
+
+  for (guint i = 0; i < self->windows->len; i++)
+    editor_session_start_visible_load (self, g_ptr_array_index (self->windows, i));
+
+  /* Then whatever is next in line for each medium, so that a slow
+   * remote mount does not hold back local files or vice versa.
+   */
+  while (editor_session_can_start_load (self, FALSE) &&
+         (load = g_queue_peek_head (&self->local_loads)))
+    editor_session_start_load (self, editor_session_dequeue_load (self, load->page));
+
+  while (editor_session_can_start_load (self, TRUE) &&
+         (load = g_queue_peek_head (&self->remote_loads)))
+    editor_session_start_load (self, editor_session_dequeue_load (self, load->page));
+}
+
+static gboolean
+editor_session_pump_loads_cb (gpointer data)
+{
+  EditorSession *self = data;
+
+  g_assert (EDITOR_IS_SESSION (self));
+
+  self->pump_loads_source = 0;
+  editor_session_pump_loads (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+/*
+ * editor_session_load_page:
+ * @self: an #EditorSession
+ * @page: an #EditorPage
+ * @callback: (nullable): a callback for _editor_document_load_async()
+ * @user_data: closure data for @callback
+ * @user_data_destroy: destroys @user_data if the load never starts
+ *
+ * Queues the document of @page to be loaded.
+ *
+ * Loads are started from an idle so that a batch of pages can be added
+ * first and the visible ones picked out of it.
+ */
+static void
+editor_session_load_page (EditorSession       *self,
+                          EditorPage          *page,
+                          GAsyncReadyCallback  callback,
+                          gpointer             user_data,
+                          GDestroyNotify       user_data_destroy)
+{
+  EditorSessionLoad *load;
+  GFile *file;
+
+  g_assert (EDITOR_IS_SESSION (self));
+  g_assert (EDITOR_IS_PAGE (page));
+  g_assert (!g_hash_table_contains (self->queued_loads, page));
+
+  file = editor_document_get_file (editor_page_get_document (page));
+
+  load = g_slice_new0 (EditorSessionLoad);
+  load->page = g_object_ref (page);
+  load->callback = callback;
+  load->user_data = user_data;
+  load->user_data_destroy = user_data_destroy;
+  load->is_remote = file != NULL && !g_file_is_native (file);
+
+  if (load->is_remote)
+    g_queue_push_tail (&self->remote_loads, load);
+  else
+    g_queue_push_tail (&self->local_loads, load);
+
+  g_hash_table_insert (self->queued_loads, page, load->is_remote ?
+                                                 self->remote_loads.tail :
+                                                 self->local_loads.tail);
+
+  if (self->pump_loads_source == 0)
+    self->pump_loads_source = g_idle_add (editor_session_pump_loads_cb, self);
+}
+
+static void
+editor_session_notify_visible_page_cb (EditorSession *self,
+                                       GParamSpec    *pspec,
+                                       EditorWindow  *window)
+{
+  EditorSessionLoad *load;
+  EditorPage *page;
+
+  g_assert (EDITOR_IS_SESSION (self));
+  g_assert (EDITOR_IS_WINDOW (window));
+
+  /* A page the user switched to jumps the queue, even if that means
+   * going over the limit of loads in flight.
+   */
+  if ((page = editor_window_get_visible_page (window)) &&
+      (load = editor_session_dequeue_load (self, page)))
+    editor_session_start_load (self, load);
+}
+
 static void
 editor_session_dispose (GObject *object)
 {
@@ -347,7 +720,13 @@ editor_session_dispose (GObject *object)
   if (self->windows->len > 0)
     g_ptr_array_remove_range (self->windows, 0, self->windows->len);
 
+  g_hash_table_remove_all (self->queued_loads);
+  g_queue_clear_full (&self->local_loads, (GDestroyNotify) editor_session_load_free);
+  g_queue_clear_full (&self->remote_loads, (GDestroyNotify) editor_session_load_free);
+  g_clear_handle_id (&self->pump_loads_source, g_source_remove);
+
   g_clear_handle_id (&self->auto_save_source, g_source_remove);
+  g_clear_weak_pointer (&self->snapshot_window);
 
   G_OBJECT_CLASS (editor_session_parent_class)->dispose (object);
 }
@@ -361,6 +740,7 @@ editor_session_finalize (GObject *object)
   g_clear_pointer (&self->windows, g_ptr_array_unref);
   g_clear_pointer (&self->seen, g_hash_table_unref);
   g_clear_pointer (&self->forgot, g_hash_table_unref);
+  g_clear_pointer (&self->queued_loads, g_hash_table_unref);
   g_clear_pointer (&self->drafts, g_array_unref);
   g_clear_object (&self->state_file);
 
@@ -561,6 +941,7 @@ editor_session_init (EditorSession *self)
   self->forgot = g_hash_table_new_full ((GHashFunc) g_file_hash,
                                         (GEqualFunc) g_file_equal,
                                         g_object_unref, NULL);
+  self->queued_loads = g_hash_table_new (NULL, NULL);
   self->pages = g_ptr_array_new_with_free_func (g_object_unref);
   self->windows = g_ptr_array_new_with_free_func (g_object_unref);
   self->state_file = g_file_new_build_filename (g_get_user_data_dir (),
@@ -619,6 +1000,12 @@ editor_session_add_window (EditorSession *self,
 
   g_ptr_array_add (self->windows, g_object_ref_sink (window));
 
+  g_signal_connect_object (window,
+                           "notify::visible-page",
+                           G_CALLBACK (editor_session_notify_visible_page_cb),
+                           self,
+                           G_CONNECT_SWAPPED);
+
   g_signal_emit (self, signals [WINDOW_ADDED], 0, window);
 
   _editor_session_mark_dirty (self);
@@ -681,6 +1068,30 @@ editor_session_create_window (EditorSession *self)
   return window;
 }
 
+static void
+editor_session_insert_page (EditorSession *self,
+                            EditorWindow  *window,
+                            EditorPage    *page,
+                            gboolean       activate)
+{
+  g_assert (EDITOR_IS_SESSION (self));
+  g_assert (EDITOR_IS_WINDOW (window));
+  g_assert (EDITOR_IS_PAGE (page));
+
+  g_ptr_array_add (self->pages, g_object_ref (page));
+
+  _editor_window_add_page (window, page, activate);
+
+  if (activate)
+    {
+      _editor_page_raise (page);
+      gtk_window_present (GTK_WINDOW (window));
+      editor_page_grab_focus (page);
+    }
+
+  g_signal_emit (self, signals [PAGE_ADDED], 0, window, page);
+}
+
 /**
  * editor_session_add_page:
  * @self: an #EditorSession
@@ -710,16 +1121,7 @@ editor_session_add_page (EditorSession *self,
   g_assert (window != NULL);
   g_assert (EDITOR_IS_WINDOW (window));
 
-  g_ptr_array_add (self->pages, g_object_ref (page));
-
-  _editor_window_add_page (window, page);
-  _editor_page_raise (page);
-
-  gtk_window_present (GTK_WINDOW (window));
-
-  editor_page_grab_focus (page);
-
-  g_signal_emit (self, signals [PAGE_ADDED], 0, window, page);
+  editor_session_insert_page (self, window, page, TRUE);
 
   _editor_session_mark_dirty (self);
 }
@@ -876,6 +1278,7 @@ void
 editor_session_remove_page (EditorSession *self,
                             EditorPage    *page)
 {
+  EditorSessionLoad *load;
   EditorDocument *document;
   EditorWindow *window;
 
@@ -890,6 +1293,9 @@ editor_session_remove_page (EditorSession *self,
 
   g_object_ref (page);
 
+  if ((load = editor_session_dequeue_load (self, page)))
+    editor_session_load_free (load);
+
   if (g_ptr_array_remove (self->pages, page))
     {
       /* If this page contains modifications, we don't want
@@ -1145,6 +1551,40 @@ editor_session_save_replace_contents_cb (GObject      *object,
     g_task_run_in_thread (task, editor_session_update_recent_worker);
 }
 
+static void
+editor_session_save_state_cb (GObject      *object,
+                              GAsyncResult *result,
+                              gpointer      user_data)
+{
+  GFile *file = (GFile *)object;
+  g_autoptr(GTask) task = user_data;
+  g_autoptr(GError) error = NULL;
+  EditorSessionSave *state;
+
+  g_assert (G_IS_FILE (file));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (G_IS_TASK (task));
+
+  if (!g_file_replace_contents_finish (file, result, NULL, &error))
+    {
+      g_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
+
+  /* Write the snapshot after the state so that it never describes
+   * a window which is missing from the state.
+   */
+  state = g_task_get_task_data (task);
+  g_file_replace_contents_bytes_async (state->snapshot_file,
+                                       state->snapshot_bytes,
+                                       NULL,
+                                       FALSE,
+                                       G_FILE_CREATE_REPLACE_DESTINATION,
+                                       NULL,
+                                       editor_session_save_replace_contents_cb,
+                                       g_steal_pointer (&task));
+}
+
 static void
 editor_session_save_draft_cb (GObject      *object,
                               GAsyncResult *result,
@@ -1172,7 +1612,7 @@ editor_session_save_draft_cb (GObject      *object,
                                          FALSE,
                                          G_FILE_CREATE_REPLACE_DESTINATION,
 	                                        NULL,
-                                         editor_session_save_replace_contents_cb,
+                                         editor_session_save_state_cb,
                                          g_steal_pointer (&task));
 }
 
@@ -1183,8 +1623,10 @@ editor_session_save_async (EditorSession       *self,
                            gpointer             user_data)
 {
   g_autoptr(GVariant) vstate = NULL;
+  g_autoptr(GVariant) vsnapshot = NULL;
   g_autoptr(GTask) task = NULL;
   g_autofree gchar *drafts_dir = NULL;
+  g_autofree gchar *snapshot_filename = NULL;
   EditorSessionSave *state;
   GVariantBuilder builder;
 
@@ -1198,10 +1640,14 @@ editor_session_save_async (EditorSession       *self,
   add_draft_state (self, &builder);
   add_window_state (self, &builder);
   vstate = g_variant_builder_end (&builder);
+  vsnapshot = create_snapshot (self);
+  snapshot_filename = get_snapshot_filename ();
 
   state = g_slice_new0 (EditorSessionSave);
   state->state_file = g_file_dup (self->state_file);
   state->state_bytes = g_variant_get_data_as_bytes (vstate);
+  state->snapshot_file = g_file_new_for_path (snapshot_filename);
+  state->snapshot_bytes = g_variant_get_data_as_bytes (vsnapshot);
   state->app = g_application_get_default ();
 
   if (g_hash_table_size (self->seen) > 0)
@@ -1269,7 +1715,7 @@ editor_session_save_async (EditorSession       *self,
                                          FALSE,
                                          G_FILE_CREATE_REPLACE_DESTINATION,
                                          NULL,
-                                         editor_session_save_replace_contents_cb,
+                                         editor_session_save_state_cb,
                                          g_steal_pointer (&task));
 }
 
@@ -1357,22 +1803,219 @@ editor_session_open (EditorSession           *self,
   if (remove)
     editor_session_remove_page (self, remove);
 
-  _editor_document_load_async (document, window, NULL, NULL, NULL);
+  editor_session_load_page (self, page, NULL, NULL, NULL);
 
   _editor_session_mark_dirty (self);
 
   return page;
 }
 
+static void
+clear_open (EditorSessionOpen *open)
+{
+  g_clear_object (&open->file);
+  g_clear_pointer (&open->draft_id, g_free);
+}
+
+static void
+editor_session_batch_free (EditorSessionBatch *batch)
+{
+  g_clear_object (&batch->self);
+  g_clear_pointer (&batch->queue, g_array_unref);
+  g_slice_free (EditorSessionBatch, batch);
+}
+
+static gboolean
+editor_session_batch_step (EditorSessionBatch *batch,
+                           EditorWindow       *window)
+{
+  EditorSession *self;
+  gint64 deadline;
+
+  g_assert (batch != NULL);
+  g_assert (EDITOR_IS_SESSION (batch->self));
+  g_assert (EDITOR_IS_WINDOW (window));
+
+  self = batch->self;
+  deadline = g_get_monotonic_time () + OPEN_BATCH_FRAME_BUDGET_USEC;
+
+  /* Create as many pages as fit in the frame budget, but always at
+   * least one so that we make progress on slow machines.
+   */
+  while (batch->pos < batch->queue->len)
+    {
+      const EditorSessionOpen *open = &g_array_index (batch->queue, EditorSessionOpen, batch->pos);
+      g_autoptr(EditorDocument) document = editor_document_new_for_file (open->file);
+      EditorPage *page;
+
+      if (open->draft_id != NULL)
+        _editor_document_set_draft_id (document, open->draft_id);
+
+      page = editor_page_new_for_document (document);
+      editor_session_insert_page (self, window, page, batch->pos == 0);
+      editor_session_load_page (self, page, NULL, NULL, NULL);
+
+      batch->pos++;
+
+      if (g_get_monotonic_time () >= deadline)
+        break;
+    }
+
+  _editor_session_mark_dirty (self);
+
+  return batch->pos < batch->queue->len;
+}
+
+static gboolean
+editor_session_batch_tick_cb (GtkWidget     *widget,
+                              GdkFrameClock *frame_clock,
+                              gpointer       user_data)
+{
+  g_assert (EDITOR_IS_WINDOW (widget));
+  g_assert (GDK_IS_FRAME_CLOCK (frame_clock));
+
+  if (editor_session_batch_step (user_data, EDITOR_WINDOW (widget)))
+    return G_SOURCE_CONTINUE;
+
+  return G_SOURCE_REMOVE;
+}
+
+/**
+ * _editor_session_open_files:
+ * @self: an #EditorSession
+ * @window: (nullable): an #EditorWindow or %NULL
+ * @files: (array length=n_files): the files to open
+ * @n_files: the number of elements in @files
+ *
+ * Opens @files in @window.
+ *
+ * Unlike calling editor_session_open() for each file, the lookups for
+ * already open files and drafts are done once for the whole batch. New
+ * pages are created over multiple frames and their contents are loaded
+ * with a limited number of loads in flight.
+ */
+void
+_editor_session_open_files (EditorSession  *self,
+                            EditorWindow   *window,
+                            GFile         **files,
+                            guint           n_files)
+{
+  g_autoptr(GHashTable) open_pages = NULL;
+  g_autoptr(GHashTable) drafts = NULL;
+  EditorSessionBatch *batch;
+  EditorPage *existing = NULL;
+  EditorPage *remove = NULL;
+  EditorPage *page;
+
+  g_return_if_fail (EDITOR_IS_SESSION (self));
+  g_return_if_fail (!window || EDITOR_IS_WINDOW (window));
+  g_return_if_fail (files != NULL || n_files == 0);
+
+  if (n_files == 0)
+    return;
+
+  if (n_files == 1)
+    {
+      editor_session_open (self, window, files[0], NULL);
+      return;
+    }
+
+  for (guint i = 0; i < n_files; i++)
+    g_return_if_fail (G_IS_FILE (files[i]));
+
+  open_pages = g_hash_table_new ((GHashFunc) g_file_hash, (GEqualFunc) g_file_equal);
+  drafts = g_hash_table_new (g_str_hash, g_str_equal);
+
+  for (guint i = 0; i < self->pages->len; i++)
+    {
+      EditorPage *item = g_ptr_array_index (self->pages, i);
+      GFile *file = editor_document_get_file (editor_page_get_document (item));
+
+      if (file != NULL)
+        g_hash_table_insert (open_pages, file, item);
+    }
+
+  for (guint i = 0; i < self->drafts->len; i++)
+    {
+      const EditorSessionDraft *draft = &g_array_index (self->drafts, EditorSessionDraft, i);
+
+      if (draft->uri != NULL)
+        g_hash_table_insert (drafts, draft->uri, draft->draft_id);
+    }
+
+  batch = g_slice_new0 (EditorSessionBatch);
+  batch->self = g_object_ref (self);
+  batch->queue = g_array_sized_new (FALSE, FALSE, sizeof (EditorSessionOpen), n_files);
+  g_array_set_clear_func (batch->queue, (GDestroyNotify) clear_open);
+
+  for (guint i = 0; i < n_files; i++)
+    {
+      g_autofree char *uri = NULL;
+      EditorSessionOpen open;
+
+      if (g_hash_table_lookup_extended (open_pages, files[i], NULL, (gpointer *)&page))
+        {
+          if (page != NULL)
+            existing = page;
+          continue;
+        }
+
+      uri = g_file_get_uri (files[i]);
+
+      open.file = g_object_ref (files[i]);
+      open.draft_id = g_strdup (g_hash_table_lookup (drafts, uri));
+      g_array_append_val (batch->queue, open);
+
+      /* Also catches duplicates within @files */
+      g_hash_table_insert (open_pages, open.file, NULL);
+    }
+
+  g_debug ("Opening %u files, %u already open",
+           batch->queue->len, n_files - batch->queue->len);
+
+  if (batch->queue->len == 0)
+    {
+      if (existing != NULL)
+        {
+          _editor_page_raise (existing);
+
+          if ((window = _editor_page_get_window (existing)))
+            gtk_window_present (GTK_WINDOW (window));
+        }
+
+      editor_session_batch_free (batch);
+      return;
+    }
+
+  if (window == NULL)
+    window = find_or_create_window (self);
+
+  if ((page = editor_window_get_visible_page (window)) &&
+      editor_page_get_can_discard (page))
+    remove = page;
+
+  /* Fill the first frame right away so the window has content */
+  if (!editor_session_batch_step (batch, window))
+    editor_session_batch_free (batch);
+  else
+    gtk_widget_add_tick_callback (GTK_WIDGET (window),
+                                  editor_session_batch_tick_cb,
+                                  batch,
+                                  (GDestroyNotify) editor_session_batch_free);
+
+  if (remove)
+    editor_session_remove_page (self, remove);
+}
+
 void
 editor_session_open_files (EditorSession  *self,
                            GFile         **files,
                            gint            n_files)
 {
   g_return_if_fail (EDITOR_IS_SESSION (self));
+  g_return_if_fail (n_files >= 0);
 
-  for (guint i = 0; i < n_files; i++)
-    editor_session_open (self, NULL, files[i], NULL);
+  _editor_session_open_files (self, NULL, files, n_files);
 }
 
 /**
@@ -1403,23 +2046,16 @@ _editor_session_open_draft (EditorSession *self,
       editor_page_get_can_discard (visible_page))
     remove = visible_page;
 
-  for (guint i = 0; i < self->pages->len; i++)
+  /* If a document matches the draft-id, short-circuit. */
+  if ((new_page = find_page_for_draft_id (self, draft_id)))
     {
-      EditorPage *page = g_ptr_array_index (self->pages, i);
-      EditorDocument *document = editor_page_get_document (page);
-      const gchar *doc_draft_id = _editor_document_get_draft_id (document);
-
-      /* If this document matches the draft-id, short-circuit. */
-      if (g_strcmp0 (doc_draft_id, draft_id) == 0)
-        {
-          _editor_page_raise (page);
-          return page;
-        }
+      _editor_page_raise (new_page);
+      return new_page;
     }
 
   new_document = _editor_document_new (NULL, draft_id);
   new_page = editor_session_add_document (self, window, new_document);
-  _editor_document_load_async (new_document, window, NULL, NULL, NULL);
+  editor_session_load_page (self, new_page, NULL, NULL, NULL);
 
   if (remove)
     editor_session_remove_page (self, remove);
@@ -1604,6 +2240,10 @@ editor_session_restore_v1_pages (EditorSession *self,
       if (uri == NULL && draft_id == NULL)
         continue;
 
+      /* Skip pages which were already restored from the snapshot */
+      if (draft_id != NULL && find_page_for_draft_id (self, draft_id))
+        continue;
+
       if (uri != NULL)
         file = g_file_new_for_uri (uri);
 
@@ -1615,11 +2255,11 @@ editor_session_restore_v1_pages (EditorSession *self,
       epage = editor_page_new_for_document (document);
       editor_session_add_page (self, window, epage);
 
-      _editor_document_load_async (document,
-                                   window,
-                                   NULL,
-                                   editor_session_load_cb,
-                                   g_slice_dup (Selection, &sel));
+      editor_session_load_page (self,
+                                epage,
+                                editor_session_load_cb,
+                                g_slice_dup (Selection, &sel),
+                                (GDestroyNotify) selection_free);
 
       if (is_active)
         active = epage;
@@ -1672,6 +2312,7 @@ editor_session_restore_v1 (EditorSession *self,
   GVariantIter iter;
   GVariant *window;
   gboolean had_failure = FALSE;
+  guint n_windows = 0;
 
   g_assert (EDITOR_IS_SESSION (self));
   g_assert (state != NULL);
@@ -1698,6 +2339,17 @@ editor_session_restore_v1 (EditorSession *self,
           height = 0;
         }
 
+      if (n_windows++ == 0 && self->snapshot_window != NULL)
+        {
+          /* The first window was displayed from the startup snapshot.
+           * Usually this finds all of its pages already restored, but
+           * anything missing from the snapshot is added now.
+           */
+          if ((pages = g_variant_lookup_value (window, "pages", G_VARIANT_TYPE ("aa{sv}"))))
+            editor_session_restore_v1_pages (self, self->snapshot_window, pages);
+          continue;
+        }
+
       if ((pages = g_variant_lookup_value (window, "pages", G_VARIANT_TYPE ("aa{sv}"))) &&
           g_variant_n_children (pages) > 0)
         {
@@ -1746,7 +2398,8 @@ failure:
   if (!self->restore_pages)
     g_debug ("Failed to restore session or nothing to restore");
 
-  editor_session_create_window (self);
+  if (self->windows->len == 0)
+    editor_session_create_window (self);
 }
 
 static void
@@ -1763,12 +2416,27 @@ editor_session_restore (EditorSession *self,
 
   if (g_variant_lookup (state, "version", "u", &version) && version == 1)
     editor_session_restore_v1 (self, state);
-  else
+  else if (self->windows->len == 0)
     editor_session_create_window (self);
 
   g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_RECENTS]);
 }
 
+static void
+editor_session_restore_completed (EditorSession *self)
+{
+  g_assert (EDITOR_IS_SESSION (self));
+
+  self->restoring = FALSE;
+
+  /* Auto-save was held back until the whole session is known */
+  if (self->dirty)
+    {
+      self->dirty = FALSE;
+      _editor_session_mark_dirty (self);
+    }
+}
+
 static void
 editor_session_restore_load_cb (GObject      *object,
                                 GAsyncResult *result,
@@ -1781,24 +2449,31 @@ editor_session_restore_load_cb (GObject      *object,
   g_autoptr(GVariant) state = NULL;
   g_autofree gchar *contents = NULL;
   EditorSession *self;
+  gint64 begin_time;
   gsize len;
 
   g_assert (G_IS_FILE (file));
   g_assert (G_IS_ASYNC_RESULT (result));
   g_assert (G_IS_TASK (task));
 
+  self = g_task_get_source_object (task);
+
+  _editor_trace_mark ("startup", "Load session state", self->restore_begin_time, g_get_monotonic_time (), NULL);
+
+  /* Nothing is restored, so the session is complete as is */
   if (!g_file_load_contents_finish (file, result, &contents, &len, NULL, &error))
     {
+      editor_session_restore_completed (self);
       g_task_return_error (task, g_steal_pointer (&error));
       return;
     }
 
-  self = g_task_get_source_object (task);
   bytes = g_bytes_new_take (g_steal_pointer (&contents), len);
   state = g_variant_new_from_bytes (G_VARIANT_TYPE_VARDICT, bytes, FALSE);
 
   if (state == NULL)
     {
+      editor_session_restore_completed (self);
       g_task_return_new_error (task,
                                G_IO_ERROR,
                                G_IO_ERROR_INVALID_DATA,
@@ -1806,7 +2481,12 @@ editor_session_restore_load_cb (GObject      *object,
       return;
     }
 
+  begin_time = g_get_monotonic_time ();
   editor_session_restore (self, state);
+  _editor_trace_mark ("startup", "Restore session", begin_time, g_get_monotonic_time (), NULL);
+
+  /* Only once the pages of the session exist */
+  editor_session_restore_completed (self);
 
   g_task_return_boolean (task, TRUE);
 }
@@ -1824,6 +2504,8 @@ editor_session_restore_async (EditorSession       *self,
   g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
 
   self->did_restore = TRUE;
+  self->restoring = TRUE;
+  self->restore_begin_time = g_get_monotonic_time ();
 
   task = g_task_new (self, cancellable, callback, user_data);
   g_task_set_source_tag (task, editor_session_restore_async);
@@ -1850,6 +2532,71 @@ editor_session_restore_finish (EditorSession  *self,
   return g_task_propagate_boolean (G_TASK (result), error);
 }
 
+/**
+ * _editor_session_restore_snapshot:
+ * @self: an #EditorSession
+ *
+ * Synchronously restores the first window of the previous session from
+ * the startup snapshot so that it may be displayed immediately, rather
+ * than after editor_session_restore_async() has loaded the full state.
+ *
+ * This must be called before editor_session_restore_async(), which will
+ * then restore the remaining windows and the list of drafts.
+ *
+ * Returns: %TRUE if a window was restored
+ */
+gboolean
+_editor_session_restore_snapshot (EditorSession *self)
+{
+  g_autofree gchar *filename = NULL;
+  g_autofree gchar *contents = NULL;
+  g_autoptr(GBytes) bytes = NULL;
+  g_autoptr(GVariant) state = NULL;
+  g_autoptr(GVariant) window = NULL;
+  g_autoptr(GVariant) pages = NULL;
+  EditorWindow *ewin;
+  guint32 version = 0;
+  guint width, height;
+  gint64 begin_time;
+  gsize len;
+
+  g_return_val_if_fail (EDITOR_IS_SESSION (self), FALSE);
+
+  if (self->did_restore || !self->restore_pages || self->windows->len > 0)
+    return FALSE;
+
+  begin_time = g_get_monotonic_time ();
+  filename = get_snapshot_filename ();
+
+  if (!g_file_get_contents (filename, &contents, &len, NULL))
+    return FALSE;
+
+  bytes = g_bytes_new_take (g_steal_pointer (&contents), len);
+  state = g_variant_new_from_bytes (G_VARIANT_TYPE_VARDICT, bytes, FALSE);
+
+  if (!g_variant_lookup (state, "version", "u", &version) || version != 1 ||
+      !(window = g_variant_lookup_value (state, "window", G_VARIANT_TYPE_VARDICT)) ||
+      !(pages = g_variant_lookup_value (window, "pages", G_VARIANT_TYPE ("aa{sv}"))) ||
+      g_variant_n_children (pages) == 0)
+    return FALSE;
+
+  ewin = _editor_session_create_window_no_draft (self);
+
+  if (g_variant_lookup (window, "size", "(uu)", &width, &height) &&
+      width > 0 && width <= 10000 &&
+      height > 0 && height <= 10000)
+    gtk_window_set_default_size (GTK_WINDOW (ewin), width, height);
+
+  editor_session_restore_v1_pages (self, ewin, pages);
+  gtk_window_present (GTK_WINDOW (ewin));
+
+  g_set_weak_pointer (&self->snapshot_window, ewin);
+
+  _editor_trace_mark ("startup", "Restore startup snapshot", begin_time, g_get_monotonic_time (), NULL);
+
+  return TRUE;
+}
+
 gboolean
 _editor_session_did_restore (EditorSession *self)
 {
@@ -2110,6 +2857,12 @@ editor_session_auto_save_timeout_cb (gpointer user_data)
 
   self->auto_save_source = 0;
 
+  /* Saving now would drop the windows which have not been restored yet.
+   * We remain dirty and are rescheduled once restoring completes.
+   */
+  if (self->restoring)
+    return G_SOURCE_REMOVE;
+
   g_debug ("Performing auto-save of session state");
   editor_session_save_async (self, NULL, NULL, NULL);
 
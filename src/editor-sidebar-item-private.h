@@ -33,6 +33,11 @@ EditorSidebarItem *_editor_sidebar_item_new             (GFile             *file
 GDateTime         *_editor_sidebar_item_get_age         (EditorSidebarItem *self);
 void               _editor_sidebar_item_set_age         (EditorSidebarItem *self,
                                                          gint64             age_local);
+const char        *_editor_sidebar_item_get_age_label   (EditorSidebarItem *self);
+void               _editor_sidebar_item_update_age      (EditorSidebarItem *self,
+                                                         GDateTime         *now);
+void               _editor_sidebar_item_watch_age       (EditorSidebarItem *self);
+void               _editor_sidebar_item_unwatch_age     (EditorSidebarItem *self);
 gboolean           _editor_sidebar_item_get_empty       (EditorSidebarItem *self);
 GFile             *_editor_sidebar_item_get_file        (EditorSidebarItem *self);
 EditorPage        *_editor_sidebar_item_get_page        (EditorSidebarItem *self);
@@ -53,7 +58,9 @@ void               _editor_sidebar_item_open            (EditorSidebarItem *self
                                                          EditorSession     *session,
                                                          EditorWindow      *window);
 gboolean           _editor_sidebar_item_matches         (EditorSidebarItem *self,
-                                                         const char        *search);
+                                                         const char        *search,
+                                                         guint64            search_mask,
+                                                         guint             *priority);
 int                _editor_sidebar_item_compare         (EditorSidebarItem *a,
                                                          EditorSidebarItem *b);
 
@@ -30,8 +30,11 @@
 #include "editor-path-private.h"
 #include "editor-session-private.h"
 #include "editor-sidebar-item-private.h"
+#include "editor-utils-private.h"
 #include "editor-window.h"
 
+#define AGE_BUCKET_INVALID G_MAXUINT
+
 struct _EditorSidebarItem
 {
   GObject     parent_instance;
@@ -39,11 +42,20 @@ struct _EditorSidebarItem
   GFile      *file;
   EditorPage *page;
   gchar      *search_text;
+  guint64     search_mask;
   gchar      *draft_id;
   gchar      *title;
   gchar      *subtitle;
+  gchar      *age_label;
   gint64      age;
 
+  /* The bucket used to format age_label and the number of rows that are
+   * currently displaying it. Age changes are only propagated to items
+   * which are visible to the user.
+   */
+  guint       age_bucket;
+  guint       age_watch_count;
+
   guint       is_modified_set : 1;
   guint       is_modified : 1;
 };
@@ -51,6 +63,7 @@ struct _EditorSidebarItem
 enum {
   PROP_0,
   PROP_AGE,
+  PROP_AGE_LABEL,
   PROP_DRAFT_ID,
   PROP_EMPTY,
   PROP_FILE,
@@ -65,6 +78,18 @@ G_DEFINE_TYPE (EditorSidebarItem, editor_sidebar_item, G_TYPE_OBJECT)
 
 static GParamSpec *properties [N_PROPS];
 
+static void
+editor_sidebar_item_invalidate_age (EditorSidebarItem *self)
+{
+  g_assert (EDITOR_IS_SIDEBAR_ITEM (self));
+
+  self->age_bucket = AGE_BUCKET_INVALID;
+  g_clear_pointer (&self->age_label, g_free);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_AGE]);
+  g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_AGE_LABEL]);
+}
+
 static void
 editor_sidebar_item_update_subtitle (EditorSidebarItem *self)
 {
@@ -73,6 +98,7 @@ editor_sidebar_item_update_subtitle (EditorSidebarItem *self)
   g_assert (EDITOR_IS_SIDEBAR_ITEM (self));
 
   g_free (self->subtitle);
+  g_clear_pointer (&self->search_text, g_free);
 
   if (self->file == NULL)
     {
@@ -119,7 +145,7 @@ editor_sidebar_item_query_info_cb (GObject      *object,
   else
     self->age = 0;
 
-  g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_AGE]);
+  editor_sidebar_item_invalidate_age (self);
 }
 
 void
@@ -131,7 +157,7 @@ _editor_sidebar_item_set_age (EditorSidebarItem *self,
   if (age != self->age)
     {
       self->age = age;
-      g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_AGE]);
+      editor_sidebar_item_invalidate_age (self);
     }
 }
 
@@ -260,6 +286,7 @@ editor_sidebar_item_finalize (GObject *object)
   g_clear_pointer (&self->search_text, g_free);
   g_clear_pointer (&self->draft_id, g_free);
   g_clear_pointer (&self->subtitle, g_free);
+  g_clear_pointer (&self->age_label, g_free);
 
   G_OBJECT_CLASS (editor_sidebar_item_parent_class)->finalize (object);
 }
@@ -278,6 +305,10 @@ editor_sidebar_item_get_property (GObject    *object,
       g_value_take_boxed (value, _editor_sidebar_item_get_age (self));
       break;
 
+    case PROP_AGE_LABEL:
+      g_value_set_string (value, _editor_sidebar_item_get_age_label (self));
+      break;
+
     case PROP_DRAFT_ID:
       g_value_set_string (value, self->draft_id);
       break;
@@ -357,6 +388,13 @@ editor_sidebar_item_class_init (EditorSidebarItemClass *klass)
                         G_TYPE_DATE_TIME,
                         (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  properties [PROP_AGE_LABEL] =
+    g_param_spec_string ("age-label",
+                         "Age Label",
+                         "The age formatted for display",
+                         NULL,
+                         (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   properties [PROP_DRAFT_ID] =
     g_param_spec_string ("draft-id",
                          "Draft ID",
@@ -413,6 +451,7 @@ static void
 editor_sidebar_item_init (EditorSidebarItem *self)
 {
   self->subtitle = g_strdup ("");
+  self->age_bucket = AGE_BUCKET_INVALID;
 }
 
 EditorSidebarItem *
@@ -517,11 +556,30 @@ _editor_sidebar_item_get_empty (EditorSidebarItem *self)
          !editor_page_get_is_modified (self->page);
 }
 
+/**
+ * _editor_sidebar_item_matches:
+ * @self: an #EditorSidebarItem
+ * @search: (nullable): a casefolded search query
+ * @search_mask: the result of _editor_fuzzy_mask() for @search
+ * @priority: (out) (optional): location for the match priority
+ *
+ * Fuzzy matches @search against the casefolded title and subtitle of
+ * the item. The casefolded text and its character mask are cached on
+ * the item so that items which cannot possibly match are rejected
+ * without running the fuzzy matcher.
+ *
+ * Returns: %TRUE if @search matches; lower @priority is a better match.
+ */
 gboolean
 _editor_sidebar_item_matches (EditorSidebarItem *self,
-                              const char        *search)
+                              const char        *search,
+                              guint64            search_mask,
+                              guint             *priority)
 {
-  guint prio;
+  guint prio = 0;
+
+  if (priority != NULL)
+    *priority = 0;
 
   if (search == NULL)
     return TRUE;
@@ -533,9 +591,19 @@ _editor_sidebar_item_matches (EditorSidebarItem *self,
       g_autofree gchar *subtitle_fold = g_utf8_casefold (self->subtitle, -1);
 
       self->search_text = g_strdup_printf ("%s %s", title_fold, subtitle_fold);
+      self->search_mask = _editor_fuzzy_mask (self->search_text);
     }
 
-  return gtk_source_completion_fuzzy_match (self->search_text, search, &prio);
+  if ((self->search_mask & search_mask) != search_mask)
+    return FALSE;
+
+  if (!gtk_source_completion_fuzzy_match (self->search_text, search, &prio))
+    return FALSE;
+
+  if (priority != NULL)
+    *priority = prio;
+
+  return TRUE;
 }
 
 void
@@ -559,6 +627,7 @@ _editor_sidebar_item_set_title (EditorSidebarItem *self,
     {
       g_free (self->title);
       self->title = g_strdup (title);
+      g_clear_pointer (&self->search_text, g_free);
       g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_TITLE]);
     }
 }
@@ -612,3 +681,86 @@ _editor_sidebar_item_compare (EditorSidebarItem *a,
   else
     return 0;
 }
+
+const char *
+_editor_sidebar_item_get_age_label (EditorSidebarItem *self)
+{
+  g_autoptr(GDateTime) dt = NULL;
+
+  g_return_val_if_fail (EDITOR_IS_SIDEBAR_ITEM (self), NULL);
+
+  if (self->age_label != NULL)
+    return self->age_label;
+
+  if (!(dt = _editor_sidebar_item_get_age (self)))
+    return "";
+
+  if (self->age_bucket == AGE_BUCKET_INVALID)
+    {
+      g_autoptr(GDateTime) now = g_date_time_new_now_utc ();
+      self->age_bucket = _editor_date_time_get_bucket (dt, now);
+    }
+
+  self->age_label = _editor_date_time_format_bucket (dt, self->age_bucket);
+
+  return self->age_label;
+}
+
+/**
+ * _editor_sidebar_item_update_age:
+ * @self: an #EditorSidebarItem
+ * @now: the current time
+ *
+ * Recomputes the age bucket relative to @now and notifies
+ * #EditorSidebarItem:age-label only if the displayed label changed.
+ *
+ * Items which are not watched by any row are skipped entirely and will
+ * be refreshed when they are next watched.
+ */
+void
+_editor_sidebar_item_update_age (EditorSidebarItem *self,
+                                 GDateTime         *now)
+{
+  g_autoptr(GDateTime) dt = NULL;
+  guint bucket;
+
+  g_return_if_fail (EDITOR_IS_SIDEBAR_ITEM (self));
+  g_return_if_fail (now != NULL);
+
+  if (self->age_watch_count == 0)
+    return;
+
+  if (!(dt = _editor_sidebar_item_get_age (self)))
+    return;
+
+  bucket = _editor_date_time_get_bucket (dt, now);
+
+  if (bucket != self->age_bucket)
+    {
+      self->age_bucket = bucket;
+      g_clear_pointer (&self->age_label, g_free);
+      g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_AGE_LABEL]);
+    }
+}
+
+void
+_editor_sidebar_item_watch_age (EditorSidebarItem *self)
+{
+  g_return_if_fail (EDITOR_IS_SIDEBAR_ITEM (self));
+
+  /* Labels may have gone stale while nobody was looking */
+  if (self->age_watch_count++ == 0)
+    {
+      g_autoptr(GDateTime) now = g_date_time_new_now_utc ();
+      _editor_sidebar_item_update_age (self, now);
+    }
+}
+
+void
+_editor_sidebar_item_unwatch_age (EditorSidebarItem *self)
+{
+  g_return_if_fail (EDITOR_IS_SIDEBAR_ITEM (self));
+  g_return_if_fail (self->age_watch_count > 0);
+
+  self->age_watch_count--;
+}
@@ -63,15 +63,21 @@ static gboolean
 update_timeout_cb (gpointer data)
 {
   EditorSidebarModel *self = data;
+  g_autoptr(GDateTime) now = NULL;
 
   g_assert (EDITOR_IS_SIDEBAR_MODEL (self));
 
+  /* Items only notify when their displayed label changes, and only
+   * if a row is currently showing them.
+   */
+  now = g_date_time_new_now_utc ();
+
   for (GSequenceIter *iter = g_sequence_get_begin_iter (self->seq);
        !g_sequence_iter_is_end (iter);
        iter = g_sequence_iter_next (iter))
     {
       EditorSidebarItem *item = g_sequence_get (iter);
-      g_object_notify (G_OBJECT (item), "age");
+      _editor_sidebar_item_update_age (item, now);
     }
 
   return G_SOURCE_CONTINUE;
@@ -28,7 +28,6 @@
 #include "editor-session-private.h"
 #include "editor-sidebar-item-private.h"
 #include "editor-sidebar-row-private.h"
-#include "editor-utils-private.h"
 
 struct _EditorSidebarRow
 {
@@ -81,26 +80,6 @@ modified_to_child (GBinding     *binding,
   return TRUE;
 }
 
-static gboolean
-age_to_string (GBinding     *binding,
-               const GValue *from_value,
-               GValue       *to_value,
-               gpointer      user_data)
-{
-  GDateTime *dt;
-
-  g_assert (G_IS_BINDING (binding));
-  g_assert (EDITOR_IS_SIDEBAR_ROW (user_data));
-
-  if ((dt = g_value_get_boxed (from_value)))
-    g_value_take_string (to_value,
-                         _editor_date_time_format (dt));
-  else
-    g_value_set_static_string (to_value, "");
-
-  return TRUE;
-}
-
 static void
 on_remove_clicked_cb (EditorSidebarRow *self,
                       GtkButton        *button)
@@ -125,6 +104,32 @@ on_remove_clicked_cb (EditorSidebarRow *self,
                               draft_id ? draft_id : "");
 }
 
+static void
+editor_sidebar_row_map (GtkWidget *widget)
+{
+  EditorSidebarRow *self = (EditorSidebarRow *)widget;
+
+  g_assert (EDITOR_IS_SIDEBAR_ROW (self));
+
+  GTK_WIDGET_CLASS (editor_sidebar_row_parent_class)->map (widget);
+
+  if (self->item != NULL)
+    _editor_sidebar_item_watch_age (self->item);
+}
+
+static void
+editor_sidebar_row_unmap (GtkWidget *widget)
+{
+  EditorSidebarRow *self = (EditorSidebarRow *)widget;
+
+  g_assert (EDITOR_IS_SIDEBAR_ROW (self));
+
+  if (self->item != NULL)
+    _editor_sidebar_item_unwatch_age (self->item);
+
+  GTK_WIDGET_CLASS (editor_sidebar_row_parent_class)->unmap (widget);
+}
+
 static void
 editor_sidebar_row_dispose (GObject *object)
 {
@@ -189,6 +194,9 @@ editor_sidebar_row_class_init (EditorSidebarRowClass *klass)
   object_class->get_property = editor_sidebar_row_get_property;
   object_class->set_property = editor_sidebar_row_set_property;
 
+  widget_class->map = editor_sidebar_row_map;
+  widget_class->unmap = editor_sidebar_row_unmap;
+
   gtk_widget_class_set_template_from_resource (widget_class, "/org/gnome/TextEditor/ui/editor-sidebar-row.ui");
   gtk_widget_class_set_layout_manager_type (widget_class, GTK_TYPE_BIN_LAYOUT);
   gtk_widget_class_bind_template_child (widget_class, EditorSidebarRow, age);
@@ -246,10 +254,19 @@ _editor_sidebar_row_set_item (EditorSidebarRow  *self,
   if (item != NULL)
     g_object_ref (item);
 
+  if (gtk_widget_get_mapped (GTK_WIDGET (self)))
+    {
+      if (previous != NULL)
+        _editor_sidebar_item_unwatch_age (previous);
+      if (item != NULL)
+        _editor_sidebar_item_watch_age (item);
+    }
+
   g_clear_pointer (&self->title_binding, g_binding_unbind);
   g_clear_pointer (&self->subtitle_binding, g_binding_unbind);
   g_clear_pointer (&self->empty_binding, g_binding_unbind);
   g_clear_pointer (&self->modified_binding, g_binding_unbind);
+  g_clear_pointer (&self->age_binding, g_binding_unbind);
 
   self->item = item;
 
@@ -274,10 +291,8 @@ _editor_sidebar_row_set_item (EditorSidebarRow  *self,
                                      modified_to_child,
                                      NULL, self, NULL);
       self->age_binding =
-        g_object_bind_property_full (self->item, "age",
-                                     self->age, "label",
-                                     G_BINDING_SYNC_CREATE,
-                                     age_to_string,
-                                     NULL, self, NULL);
+        g_object_bind_property (self->item, "age-label",
+                                self->age, "label",
+                                G_BINDING_SYNC_CREATE);
     }
 }
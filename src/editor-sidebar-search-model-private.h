@@ -0,0 +1,36 @@
+/* editor-sidebar-search-model-private.h
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include "editor-types-private.h"
+
+G_BEGIN_DECLS
+
+#define EDITOR_TYPE_SIDEBAR_SEARCH_MODEL (editor_sidebar_search_model_get_type())
+
+G_DECLARE_FINAL_TYPE (EditorSidebarSearchModel, editor_sidebar_search_model, EDITOR, SIDEBAR_SEARCH_MODEL, GObject)
+
+EditorSidebarSearchModel *_editor_sidebar_search_model_new       (GListModel               *model);
+const char               *_editor_sidebar_search_model_get_query (EditorSidebarSearchModel *self);
+void                      _editor_sidebar_search_model_set_query (EditorSidebarSearchModel *self,
+                                                                  const char               *query);
+
+G_END_DECLS
@@ -0,0 +1,289 @@
+/* editor-sidebar-search-model.c
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "editor-sidebar-search-model"
+
+#include "config.h"
+
+#include "editor-sidebar-item-private.h"
+#include "editor-sidebar-search-model-private.h"
+#include "editor-utils-private.h"
+
+/*
+ * EditorSidebarSearchModel is a GListModel of the items from a source
+ * model which fuzzy match the current query, sorted by how well they
+ * match. Each EditorSidebarItem caches its casefolded search text and
+ * character mask so that the per-keystroke cost is a mask comparison for
+ * most items. When the query only grows, the previous results are
+ * refined instead of scanning the whole source model again.
+ */
+
+struct _EditorSidebarSearchModel
+{
+  GObject     parent_instance;
+  GListModel *model;
+  GArray     *results;
+  char       *query;
+  guint64     query_mask;
+  guint       can_refine : 1;
+};
+
+typedef struct
+{
+  EditorSidebarItem *item;
+  guint              position;
+  guint              priority;
+} Result;
+
+static GType
+editor_sidebar_search_model_get_item_type (GListModel *model)
+{
+  return EDITOR_TYPE_SIDEBAR_ITEM;
+}
+
+static guint
+editor_sidebar_search_model_get_n_items (GListModel *model)
+{
+  EditorSidebarSearchModel *self = EDITOR_SIDEBAR_SEARCH_MODEL (model);
+
+  return self->results->len;
+}
+
+static gpointer
+editor_sidebar_search_model_get_item (GListModel *model,
+                                      guint       position)
+{
+  EditorSidebarSearchModel *self = EDITOR_SIDEBAR_SEARCH_MODEL (model);
+
+  if (position >= self->results->len)
+    return NULL;
+
+  return g_object_ref (g_array_index (self->results, Result, position).item);
+}
+
+static void
+list_model_iface_init (GListModelInterface *iface)
+{
+  iface->get_item_type = editor_sidebar_search_model_get_item_type;
+  iface->get_n_items = editor_sidebar_search_model_get_n_items;
+  iface->get_item = editor_sidebar_search_model_get_item;
+}
+
+G_DEFINE_TYPE_WITH_CODE (EditorSidebarSearchModel, editor_sidebar_search_model, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (G_TYPE_LIST_MODEL, list_model_iface_init))
+
+static void
+clear_result (gpointer data)
+{
+  Result *result = data;
+
+  g_clear_object (&result->item);
+}
+
+static int
+compare_result (gconstpointer a,
+                gconstpointer b)
+{
+  const Result *ra = a;
+  const Result *rb = b;
+
+  /* Better matches first, then keep the order of the source model */
+
+  if (ra->priority < rb->priority)
+    return -1;
+  else if (ra->priority > rb->priority)
+    return 1;
+  else if (ra->position < rb->position)
+    return -1;
+  else if (ra->position > rb->position)
+    return 1;
+  else
+    return 0;
+}
+
+static GArray *
+create_results (void)
+{
+  GArray *ar = g_array_new (FALSE, FALSE, sizeof (Result));
+  g_array_set_clear_func (ar, clear_result);
+  return ar;
+}
+
+static void
+editor_sidebar_search_model_update (EditorSidebarSearchModel *self,
+                                    gboolean                  refine)
+{
+  g_autoptr(GArray) results = NULL;
+  guint old_len;
+
+  g_assert (EDITOR_IS_SIDEBAR_SEARCH_MODEL (self));
+
+  results = create_results ();
+
+  if (self->query == NULL || self->model == NULL)
+    {
+      /* Nothing to match against */
+    }
+  else if (refine)
+    {
+      for (guint i = 0; i < self->results->len; i++)
+        {
+          const Result *prev = &g_array_index (self->results, Result, i);
+          Result result = { NULL, prev->position, 0 };
+
+          if (_editor_sidebar_item_matches (prev->item, self->query, self->query_mask, &result.priority))
+            {
+              result.item = g_object_ref (prev->item);
+              g_array_append_val (results, result);
+            }
+        }
+    }
+  else
+    {
+      guint n_items = g_list_model_get_n_items (self->model);
+
+      for (guint i = 0; i < n_items; i++)
+        {
+          g_autoptr(EditorSidebarItem) item = g_list_model_get_item (self->model, i);
+          Result result = { NULL, i, 0 };
+
+          if (_editor_sidebar_item_matches (item, self->query, self->query_mask, &result.priority))
+            {
+              result.item = g_steal_pointer (&item);
+              g_array_append_val (results, result);
+            }
+        }
+    }
+
+  g_array_sort (results, compare_result);
+
+  old_len = self->results->len;
+  g_clear_pointer (&self->results, g_array_unref);
+  self->results = g_steal_pointer (&results);
+  self->can_refine = self->query != NULL;
+
+  if (old_len || self->results->len)
+    g_list_model_items_changed (G_LIST_MODEL (self), 0, old_len, self->results->len);
+}
+
+static void
+editor_sidebar_search_model_items_changed_cb (EditorSidebarSearchModel *self,
+                                              guint                     position,
+                                              guint                     removed,
+                                              guint                     added,
+                                              GListModel               *model)
+{
+  g_assert (EDITOR_IS_SIDEBAR_SEARCH_MODEL (self));
+  g_assert (G_IS_LIST_MODEL (model));
+
+  /* Positions of previous results are no longer valid */
+  editor_sidebar_search_model_update (self, FALSE);
+}
+
+static void
+editor_sidebar_search_model_finalize (GObject *object)
+{
+  EditorSidebarSearchModel *self = (EditorSidebarSearchModel *)object;
+
+  g_clear_object (&self->model);
+  g_clear_pointer (&self->results, g_array_unref);
+  g_clear_pointer (&self->query, g_free);
+
+  G_OBJECT_CLASS (editor_sidebar_search_model_parent_class)->finalize (object);
+}
+
+static void
+editor_sidebar_search_model_class_init (EditorSidebarSearchModelClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = editor_sidebar_search_model_finalize;
+}
+
+static void
+editor_sidebar_search_model_init (EditorSidebarSearchModel *self)
+{
+  self->results = create_results ();
+}
+
+EditorSidebarSearchModel *
+_editor_sidebar_search_model_new (GListModel *model)
+{
+  EditorSidebarSearchModel *self;
+
+  g_return_val_if_fail (G_IS_LIST_MODEL (model), NULL);
+
+  self = g_object_new (EDITOR_TYPE_SIDEBAR_SEARCH_MODEL, NULL);
+  self->model = g_object_ref (model);
+
+  g_signal_connect_object (model,
+                           "items-changed",
+                           G_CALLBACK (editor_sidebar_search_model_items_changed_cb),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  return self;
+}
+
+const char *
+_editor_sidebar_search_model_get_query (EditorSidebarSearchModel *self)
+{
+  g_return_val_if_fail (EDITOR_IS_SIDEBAR_SEARCH_MODEL (self), NULL);
+
+  return self->query;
+}
+
+/**
+ * _editor_sidebar_search_model_set_query:
+ * @self: an #EditorSidebarSearchModel
+ * @query: (nullable): the text to search for
+ *
+ * Updates the results to contain items matching @query.
+ *
+ * If @query extends the previous query, only the previous results are
+ * checked since a fuzzy match of the longer query implies a match of
+ * the shorter one.
+ */
+void
+_editor_sidebar_search_model_set_query (EditorSidebarSearchModel *self,
+                                        const char               *query)
+{
+  g_autofree char *query_fold = NULL;
+  gboolean refine;
+
+  g_return_if_fail (EDITOR_IS_SIDEBAR_SEARCH_MODEL (self));
+
+  if (query != NULL && query[0] != 0)
+    query_fold = g_utf8_casefold (query, -1);
+
+  if (g_strcmp0 (query_fold, self->query) == 0)
+    return;
+
+  refine = self->can_refine &&
+           query_fold != NULL &&
+           self->query != NULL &&
+           g_str_has_prefix (query_fold, self->query);
+
+  g_free (self->query);
+  self->query = g_steal_pointer (&query_fold);
+  self->query_mask = _editor_fuzzy_mask (self->query);
+
+  editor_sidebar_search_model_update (self, refine);
+}
@@ -23,9 +23,13 @@
 #include "editor-document-private.h"
 #include "editor-source-view.h"
 #include "editor-joined-menu-private.h"
+#include "editor-spell-checker.h"
 #include "editor-spell-menu.h"
 #include "editor-utils-private.h"
 
+#define PREFETCH_DELAY_USEC   (G_USEC_PER_SEC / 4)
+#define MAX_PREFETCH_PER_LINE 8
+
 struct _EditorSourceView
 {
   GtkSourceView parent_instance;
@@ -33,7 +37,15 @@ struct _EditorSourceView
   PangoFontDescription *font_desc;
   GMenuModel *spelling_menu;
   char *spelling_word;
+  GCancellable *corrections_cancellable;
+  GCancellable *prefetch_cancellable;
+  GSource *prefetch_source;
+  EditorDocument *document;
+  double pointer_x;
+  double pointer_y;
   int font_scale;
+  guint update_css_tick_id;
+  guint has_pointer : 1;
 };
 
 G_DEFINE_TYPE (EditorSourceView, editor_source_view, GTK_SOURCE_TYPE_VIEW)
@@ -46,53 +58,142 @@ enum {
   N_PROPS
 };
 
+#define CSS_PROVIDER_CACHE_SIZE 32
+
 static GParamSpec *properties [N_PROPS];
 
-static void
-editor_source_view_update_css (EditorSourceView *self)
+/* Providers are shared by every view using the same font at the same
+ * size, so zooming back and forth or opening more views does not parse
+ * the same CSS again.
+ */
+static GHashTable *css_provider_cache;
+
+static GtkCssProvider *
+editor_source_view_get_css_provider (const PangoFontDescription *font_desc)
 {
-  const PangoFontDescription *font_desc;
-  PangoFontDescription *scaled = NULL;
   g_autoptr(GString) str = NULL;
   g_autofree char *font_css = NULL;
-  int size = 11; /* 11pt */
+  g_autofree char *key = NULL;
+  GtkCssProvider *provider;
+
+  g_assert (font_desc != NULL);
+
+  if (css_provider_cache == NULL)
+    css_provider_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+
+  key = pango_font_description_to_string (font_desc);
+
+  if ((provider = g_hash_table_lookup (css_provider_cache, key)))
+    return g_object_ref (provider);
+
+  str = g_string_new ("textview {\n");
+  font_css = _editor_font_description_to_css (font_desc);
+  g_string_append (str, font_css);
+  g_string_append (str, "\nline-height:1.2;\n");
+  g_string_append (str, "}\n");
 
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider, str->str, -1);
+
+  /* Views keep their own reference, so dropping the cache is harmless */
+  if (g_hash_table_size (css_provider_cache) >= CSS_PROVIDER_CACHE_SIZE)
+    g_hash_table_remove_all (css_provider_cache);
+
+  g_hash_table_insert (css_provider_cache, g_steal_pointer (&key), g_object_ref (provider));
+
+  return provider;
+}
+
+static int
+editor_source_view_get_font_size (EditorSourceView *self)
+{
   g_assert (EDITOR_IS_SOURCE_VIEW (self));
 
   if (self->font_desc != NULL &&
       pango_font_description_get_set_fields (self->font_desc) & PANGO_FONT_MASK_SIZE)
-    size = pango_font_description_get_size (self->font_desc) / PANGO_SCALE;
+    return pango_font_description_get_size (self->font_desc) / PANGO_SCALE;
 
-  if (size + self->font_scale < 1)
-    self->font_scale = -size + 1;
+  return 11; /* 11pt */
+}
 
-  size = MAX (1, size + self->font_scale);
+static void
+editor_source_view_update_css (EditorSourceView *self)
+{
+  g_autoptr(GtkCssProvider) css_provider = NULL;
+  PangoFontDescription *scaled;
+  GtkStyleContext *style_context;
+  int size;
 
-  font_desc = self->font_desc;
+  g_assert (EDITOR_IS_SOURCE_VIEW (self));
 
-  if (size != 0)
-    {
-      if (font_desc)
-        scaled = pango_font_description_copy (font_desc);
-      else
-        scaled = pango_font_description_new ();
-      pango_font_description_set_size (scaled, size * PANGO_SCALE);
-      font_desc = scaled;
-    }
+  size = MAX (1, editor_source_view_get_font_size (self) + self->font_scale);
 
-  str = g_string_new ("textview {\n");
-  if (font_desc)
-    {
+  if (self->font_desc)
+    scaled = pango_font_description_copy (self->font_desc);
+  else
+    scaled = pango_font_description_new ();
+  pango_font_description_set_size (scaled, size * PANGO_SCALE);
 
-      font_css = _editor_font_description_to_css (font_desc);
-      g_string_append (str, font_css);
-      g_string_append (str, "\nline-height:1.2;\n");
-    }
-  g_string_append (str, "}\n");
+  css_provider = editor_source_view_get_css_provider (scaled);
+
+  pango_font_description_free (scaled);
+
+  if (css_provider == self->css_provider)
+    return;
+
+  /* Swapping providers only restyles this view */
+  style_context = gtk_widget_get_style_context (GTK_WIDGET (self));
+
+  if (self->css_provider != NULL)
+    gtk_style_context_remove_provider (style_context,
+                                       GTK_STYLE_PROVIDER (self->css_provider));
+
+  g_set_object (&self->css_provider, css_provider);
+
+  gtk_style_context_add_provider (style_context,
+                                  GTK_STYLE_PROVIDER (self->css_provider),
+                                  GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+}
+
+static gboolean
+editor_source_view_update_css_cb (GtkWidget     *widget,
+                                  GdkFrameClock *frame_clock,
+                                  gpointer       user_data)
+{
+  EditorSourceView *self = (EditorSourceView *)widget;
+
+  g_assert (EDITOR_IS_SOURCE_VIEW (self));
 
-  gtk_css_provider_load_from_data (self->css_provider, str->str, -1);
+  self->update_css_tick_id = 0;
+  editor_source_view_update_css (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+editor_source_view_set_font_scale (EditorSourceView *self,
+                                   int               font_scale)
+{
+  g_assert (EDITOR_IS_SOURCE_VIEW (self));
 
-  g_clear_pointer (&scaled, pango_font_description_free);
+  font_scale = MAX (font_scale, 1 - editor_source_view_get_font_size (self));
+
+  if (font_scale == self->font_scale)
+    return;
+
+  self->font_scale = font_scale;
+
+  /* Restyle at most once per frame while zooming quickly */
+  if (!gtk_widget_get_mapped (GTK_WIDGET (self)))
+    editor_source_view_update_css (self);
+  else if (self->update_css_tick_id == 0)
+    self->update_css_tick_id =
+      gtk_widget_add_tick_callback (GTK_WIDGET (self),
+                                    editor_source_view_update_css_cb,
+                                    NULL, NULL);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_FONT_SCALE]);
+  g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_ZOOM_LEVEL]);
 }
 
 static gboolean
@@ -161,6 +262,232 @@ tweak_gutter_spacing (GtkSourceView *view)
     }
 }
 
+static void
+editor_source_view_list_corrections_cb (GObject      *object,
+                                        GAsyncResult *result,
+                                        gpointer      user_data)
+{
+  EditorSpellChecker *spell_checker = (EditorSpellChecker *)object;
+  g_autoptr(EditorSourceView) self = user_data;
+  g_autoptr(GError) error = NULL;
+  g_auto(GStrv) corrections = NULL;
+
+  g_assert (EDITOR_IS_SPELL_CHECKER (spell_checker));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (EDITOR_IS_SOURCE_VIEW (self));
+
+  /* Cancelled when another click changed the word */
+  if (!(corrections = editor_spell_checker_list_corrections_finish (spell_checker, result, &error)) &&
+      error != NULL)
+    return;
+
+  editor_spell_menu_set_corrections (self->spelling_menu,
+                                     self->spelling_word,
+                                     (const char * const *)corrections);
+}
+
+static void
+editor_source_view_prefetch_word (EditorSourceView  *self,
+                                  GHashTable        *batches,
+                                  const GtkTextIter *begin,
+                                  const GtkTextIter *end)
+{
+  EditorSpellChecker *spell_checker;
+  GtkTextBuffer *buffer;
+  GPtrArray *words;
+
+  g_assert (EDITOR_IS_SOURCE_VIEW (self));
+  g_assert (batches != NULL);
+
+  if (gtk_text_iter_equal (begin, end))
+    return;
+
+  /* The paragraph may be in another language than the document */
+  buffer = gtk_text_iter_get_buffer (begin);
+  if (!(spell_checker = _editor_document_get_spell_checker_at (EDITOR_DOCUMENT (buffer), begin)))
+    return;
+
+  if (!(words = g_hash_table_lookup (batches, spell_checker)))
+    {
+      words = g_ptr_array_new_with_free_func (g_free);
+      g_hash_table_insert (batches, spell_checker, words);
+    }
+
+  g_ptr_array_add (words, gtk_text_iter_get_slice (begin, end));
+}
+
+static void
+editor_source_view_prefetch_tagged (EditorSourceView  *self,
+                                    GHashTable        *batches,
+                                    GtkTextTag        *tag,
+                                    const GtkTextIter *iter)
+{
+  GtkTextIter begin = *iter;
+  GtkTextIter end = *iter;
+
+  g_assert (EDITOR_IS_SOURCE_VIEW (self));
+  g_assert (GTK_IS_TEXT_TAG (tag));
+
+  if (!gtk_text_iter_has_tag (iter, tag))
+    return;
+
+  if (!gtk_text_iter_starts_tag (&begin, tag))
+    gtk_text_iter_backward_to_tag_toggle (&begin, tag);
+  gtk_text_iter_forward_to_tag_toggle (&end, tag);
+
+  editor_source_view_prefetch_word (self, batches, &begin, &end);
+}
+
+static void
+editor_source_view_cancel_prefetch (EditorSourceView *self)
+{
+  g_assert (EDITOR_IS_SOURCE_VIEW (self));
+
+  g_cancellable_cancel (self->prefetch_cancellable);
+  g_clear_object (&self->prefetch_cancellable);
+}
+
+static gboolean
+editor_source_view_prefetch_cb (gpointer user_data)
+{
+  EditorSourceView *self = user_data;
+  g_autoptr(GHashTable) batches = NULL;
+  GtkTextBuffer *buffer;
+  GHashTableIter hiter;
+  GtkTextTag *tag;
+  GtkTextIter iter;
+  GtkTextIter line_end;
+  gpointer key, value;
+  guint n_words = 0;
+
+  g_assert (EDITOR_IS_SOURCE_VIEW (self));
+
+  buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (self));
+
+  if (!EDITOR_IS_DOCUMENT (buffer) ||
+      !editor_document_get_spell_checker (EDITOR_DOCUMENT (buffer)) ||
+      !(tag = _editor_document_get_spelling_tag (EDITOR_DOCUMENT (buffer))))
+    return G_SOURCE_CONTINUE;
+
+  /* Words are grouped by the spell checker for their paragraph */
+  batches = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify)g_ptr_array_unref);
+
+  /* Misspelled word under the pointer, the one most likely to be
+   * right-clicked next.
+   */
+  if (self->has_pointer)
+    {
+      int buf_x, buf_y;
+
+      gtk_text_view_window_to_buffer_coords (GTK_TEXT_VIEW (self),
+                                             GTK_TEXT_WINDOW_WIDGET,
+                                             self->pointer_x, self->pointer_y,
+                                             &buf_x, &buf_y);
+      if (gtk_text_view_get_iter_at_location (GTK_TEXT_VIEW (self), &iter, buf_x, buf_y))
+        editor_source_view_prefetch_tagged (self, batches, tag, &iter);
+    }
+
+  /* Misspelled words on the cursor line */
+  gtk_text_buffer_get_iter_at_mark (buffer, &iter, gtk_text_buffer_get_insert (buffer));
+  gtk_text_iter_set_line_offset (&iter, 0);
+  line_end = iter;
+  if (!gtk_text_iter_ends_line (&line_end))
+    gtk_text_iter_forward_to_line_end (&line_end);
+
+  if (!gtk_text_iter_has_tag (&iter, tag))
+    gtk_text_iter_forward_to_tag_toggle (&iter, tag);
+
+  while (n_words < MAX_PREFETCH_PER_LINE &&
+         gtk_text_iter_compare (&iter, &line_end) < 0)
+    {
+      GtkTextIter word_end = iter;
+
+      gtk_text_iter_forward_to_tag_toggle (&word_end, tag);
+      editor_source_view_prefetch_word (self, batches, &iter, &word_end);
+      n_words++;
+
+      iter = word_end;
+      if (!gtk_text_iter_forward_to_tag_toggle (&iter, tag))
+        break;
+    }
+
+  /* A single prefetch computes the words one after the other so that
+   * it may be cancelled between them.
+   */
+  editor_source_view_cancel_prefetch (self);
+  self->prefetch_cancellable = g_cancellable_new ();
+
+  g_hash_table_iter_init (&hiter, batches);
+  while (g_hash_table_iter_next (&hiter, &key, &value))
+    {
+      GPtrArray *words = value;
+
+      g_ptr_array_add (words, NULL);
+      editor_spell_checker_prefetch_corrections (key,
+                                                 (const char * const *)words->pdata,
+                                                 self->prefetch_cancellable);
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+static void
+editor_source_view_queue_prefetch (EditorSourceView *self)
+{
+  g_assert (EDITOR_IS_SOURCE_VIEW (self));
+
+  /* Words from the previous position are no longer interesting */
+  editor_source_view_cancel_prefetch (self);
+
+  if (self->prefetch_source == NULL)
+    self->prefetch_source =
+      _editor_ready_time_source_new ("[editor-source-view-prefetch]",
+                                     G_PRIORITY_LOW,
+                                     editor_source_view_prefetch_cb,
+                                     self);
+
+  /* Wait for the pointer or cursor to settle */
+  g_source_set_ready_time (self->prefetch_source,
+                           g_get_monotonic_time () + PREFETCH_DELAY_USEC);
+}
+
+static void
+on_motion_cb (GtkEventControllerMotion *motion,
+              double                    x,
+              double                    y,
+              EditorSourceView         *self)
+{
+  g_assert (GTK_IS_EVENT_CONTROLLER_MOTION (motion));
+  g_assert (EDITOR_IS_SOURCE_VIEW (self));
+
+  self->has_pointer = TRUE;
+  self->pointer_x = x;
+  self->pointer_y = y;
+
+  editor_source_view_queue_prefetch (self);
+}
+
+static void
+on_cursor_changed_cb (EditorSourceView *self,
+                      gconstpointer     cursor,
+                      EditorDocument   *document)
+{
+  g_assert (EDITOR_IS_SOURCE_VIEW (self));
+  g_assert (EDITOR_IS_DOCUMENT (document));
+
+  editor_source_view_queue_prefetch (self);
+}
+
+static void
+on_leave_cb (GtkEventControllerMotion *motion,
+             EditorSourceView         *self)
+{
+  g_assert (GTK_IS_EVENT_CONTROLLER_MOTION (motion));
+  g_assert (EDITOR_IS_SOURCE_VIEW (self));
+
+  self->has_pointer = FALSE;
+}
+
 static void
 on_click_pressed_cb (GtkGestureClick  *click,
                      int               n_press,
@@ -179,6 +506,12 @@ on_click_pressed_cb (GtkGestureClick  *click,
   g_assert (EDITOR_IS_SOURCE_VIEW (self));
   g_assert (GTK_IS_GESTURE_CLICK (click));
 
+  g_cancellable_cancel (self->corrections_cancellable);
+  g_clear_object (&self->corrections_cancellable);
+
+  /* Let the request for the context menu run first */
+  editor_source_view_cancel_prefetch (self);
+
   sequence = gtk_gesture_single_get_current_sequence (GTK_GESTURE_SINGLE (click));
   event = gtk_gesture_get_last_event (GTK_GESTURE (click), sequence);
 
@@ -212,8 +545,23 @@ on_click_pressed_cb (GtkGestureClick  *click,
     {
       word = gtk_text_iter_get_slice (&begin, &end);
 
-      if (!_editor_document_check_spelling (EDITOR_DOCUMENT (buffer), word))
-        corrections = _editor_document_list_corrections (EDITOR_DOCUMENT (buffer), word);
+      if (!_editor_document_check_spelling (EDITOR_DOCUMENT (buffer), &begin, word))
+        {
+          EditorSpellChecker *spell_checker = _editor_document_get_spell_checker_at (EDITOR_DOCUMENT (buffer), &begin);
+
+          /* Suggesting can take a long time, so let the menu fill in
+           * once the corrections are ready unless they were prefetched.
+           */
+          if (!editor_spell_checker_lookup_corrections (spell_checker, word, &corrections))
+            {
+              self->corrections_cancellable = g_cancellable_new ();
+              editor_spell_checker_list_corrections_async (spell_checker,
+                                                           word,
+                                                           self->corrections_cancellable,
+                                                           editor_source_view_list_corrections_cb,
+                                                           g_object_ref (self));
+            }
+        }
       else
         g_clear_pointer (&word, g_free);
     }
@@ -239,8 +587,26 @@ on_notify_buffer_cb (EditorSourceView *self,
 
   buffer = gtk_text_view_get_buffer (GTK_TEXT_VIEW (self));
 
+  if (self->document != NULL)
+    {
+      g_signal_handlers_disconnect_by_func (self->document,
+                                            G_CALLBACK (on_cursor_changed_cb),
+                                            self);
+      g_clear_weak_pointer (&self->document);
+    }
+
+  editor_source_view_cancel_prefetch (self);
+
   if (EDITOR_IS_DOCUMENT (buffer))
-    _editor_document_attach_actions (EDITOR_DOCUMENT (buffer), GTK_WIDGET (self));
+    {
+      g_set_weak_pointer (&self->document, EDITOR_DOCUMENT (buffer));
+      _editor_document_attach_actions (EDITOR_DOCUMENT (buffer), GTK_WIDGET (self));
+      g_signal_connect_object (buffer,
+                               "cursor-changed",
+                               G_CALLBACK (on_cursor_changed_cb),
+                               self,
+                               G_CONNECT_SWAPPED);
+    }
 }
 
 static void
@@ -257,8 +623,13 @@ editor_source_view_action_spelling_add (GtkWidget  *widget,
 
   if (EDITOR_IS_DOCUMENT (buffer))
     {
+      GtkTextIter iter;
+
+      /* The context menu moved the cursor to the word */
+      gtk_text_buffer_get_iter_at_mark (buffer, &iter, gtk_text_buffer_get_insert (buffer));
+
       g_debug ("Adding “%s” to dictionary\n", self->spelling_word);
-      _editor_document_add_spelling (EDITOR_DOCUMENT (buffer), self->spelling_word);
+      _editor_document_add_spelling (EDITOR_DOCUMENT (buffer), &iter, self->spelling_word);
     }
 }
 
@@ -276,8 +647,13 @@ editor_source_view_action_spelling_ignore (GtkWidget  *widget,
 
   if (EDITOR_IS_DOCUMENT (buffer))
     {
+      GtkTextIter iter;
+
+      /* The context menu moved the cursor to the word */
+      gtk_text_buffer_get_iter_at_mark (buffer, &iter, gtk_text_buffer_get_insert (buffer));
+
       g_debug ("Ignoring “%s”\n", self->spelling_word);
-      _editor_document_ignore_spelling (EDITOR_DOCUMENT (buffer), self->spelling_word);
+      _editor_document_ignore_spelling (EDITOR_DOCUMENT (buffer), &iter, self->spelling_word);
     }
 }
 
@@ -336,15 +712,13 @@ editor_source_view_action_zoom (GtkWidget  *widget,
   g_assert (EDITOR_IS_SOURCE_VIEW (self));
 
   if (g_strcmp0 (action_name, "page.zoom-in") == 0)
-    self->font_scale++;
+    editor_source_view_set_font_scale (self, self->font_scale + 1);
   else if (g_strcmp0 (action_name, "page.zoom-out") == 0)
-    self->font_scale--;
+    editor_source_view_set_font_scale (self, self->font_scale - 1);
   else if (g_strcmp0 (action_name, "page.zoom-one") == 0)
-    self->font_scale = 0;
+    editor_source_view_set_font_scale (self, 0);
   else
     g_assert_not_reached ();
-
-  editor_source_view_update_css (self);
 }
 
 static void
@@ -440,6 +814,31 @@ editor_source_view_dispose (GObject *object)
 {
   EditorSourceView *self = (EditorSourceView *)object;
 
+  if (self->update_css_tick_id != 0)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (self), self->update_css_tick_id);
+      self->update_css_tick_id = 0;
+    }
+
+  if (self->prefetch_source != NULL)
+    {
+      g_source_destroy (self->prefetch_source);
+      g_clear_pointer (&self->prefetch_source, g_source_unref);
+    }
+
+  g_cancellable_cancel (self->corrections_cancellable);
+  g_clear_object (&self->corrections_cancellable);
+
+  editor_source_view_cancel_prefetch (self);
+
+  if (self->document != NULL)
+    {
+      g_signal_handlers_disconnect_by_func (self->document,
+                                            G_CALLBACK (on_cursor_changed_cb),
+                                            self);
+      g_clear_weak_pointer (&self->document);
+    }
+
   g_clear_object (&self->css_provider);
   g_clear_object (&self->spelling_menu);
   g_clear_pointer (&self->spelling_word, g_free);
@@ -489,9 +888,7 @@ editor_source_view_set_property (GObject      *object,
       break;
 
     case PROP_FONT_SCALE:
-      self->font_scale = g_value_get_int (value);
-      editor_source_view_update_css (self);
-      g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_ZOOM_LEVEL]);
+      editor_source_view_set_font_scale (self, g_value_get_int (value));
       break;
 
     default:
@@ -558,18 +955,11 @@ editor_source_view_init (EditorSourceView *self)
   g_autoptr(GMenu) gsv_section = NULL;
   g_autoptr(GMenu) spell_section = NULL;
   GtkEventController *controller;
-  GtkStyleContext *style_context;
   GMenuModel *extra_menu;
 
   gtk_widget_action_set_enabled (GTK_WIDGET (self), "spelling.add", FALSE);
   gtk_widget_action_set_enabled (GTK_WIDGET (self), "spelling.ignore", FALSE);
 
-  self->css_provider = gtk_css_provider_new ();
-  style_context = gtk_widget_get_style_context (GTK_WIDGET (self));
-  gtk_style_context_add_provider (style_context,
-                                  GTK_STYLE_PROVIDER (self->css_provider),
-                                  GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
-
   g_signal_connect (self,
                     "notify::buffer",
                     G_CALLBACK (on_notify_buffer_cb),
@@ -582,6 +972,17 @@ editor_source_view_init (EditorSourceView *self)
                     self);
   gtk_widget_add_controller (GTK_WIDGET (self), controller);
 
+  controller = gtk_event_controller_motion_new ();
+  g_signal_connect (controller,
+                    "motion",
+                    G_CALLBACK (on_motion_cb),
+                    self);
+  g_signal_connect (controller,
+                    "leave",
+                    G_CALLBACK (on_leave_cb),
+                    self);
+  gtk_widget_add_controller (GTK_WIDGET (self), controller);
+
   controller = GTK_EVENT_CONTROLLER (gtk_gesture_click_new ());
   gtk_gesture_single_set_button (GTK_GESTURE_SINGLE (controller), 0);
   g_signal_connect (controller,
@@ -644,14 +1045,11 @@ double
 editor_source_view_get_zoom_level (EditorSourceView *self)
 {
   int alt_size;
-  int size = 11; /* 11pt */
+  int size;
 
   g_return_val_if_fail (EDITOR_IS_SOURCE_VIEW (self), 0);
 
-  if (self->font_desc != NULL &&
-      pango_font_description_get_set_fields (self->font_desc) & PANGO_FONT_MASK_SIZE)
-    size = pango_font_description_get_size (self->font_desc) / PANGO_SCALE;
-
+  size = editor_source_view_get_font_size (self);
   alt_size = MAX (1, size + self->font_scale);
 
   return (double)alt_size / (double)size;
@@ -0,0 +1,285 @@
+/* editor-spell-cache.c
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "editor-spell-cache"
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include "editor-spell-cache-private.h"
+
+/*
+ * Misspelled ranges found by a complete spellcheck pass are stored in
+ * the user cache directory so that reopening an unchanged document can
+ * restore them without checking every word again.
+ *
+ * Entries are named after a checksum of the language code and the
+ * document contents, so any change to either simply misses the cache.
+ * Enchant does not tell us when a dictionary changes, so callers are
+ * expected to verify the (few) restored words against the checker.
+ */
+
+#define CACHE_VERSION 1
+#define CACHE_FORMAT  "(uua(uu))"
+#define CACHE_MAX_AGE (G_TIME_SPAN_DAY * 30)
+
+typedef struct
+{
+  char   *language;
+  char   *text;
+  GArray *ranges;
+} CacheOp;
+
+static void
+cache_op_free (CacheOp *op)
+{
+  g_clear_pointer (&op->language, g_free);
+  g_clear_pointer (&op->text, g_free);
+  g_clear_pointer (&op->ranges, g_array_unref);
+  g_slice_free (CacheOp, op);
+}
+
+static CacheOp *
+cache_op_new (const char *language,
+              char       *text,
+              GArray     *ranges)
+{
+  CacheOp *op = g_slice_new0 (CacheOp);
+
+  op->language = g_strdup (language);
+  op->text = text;
+  op->ranges = ranges ? g_array_ref (ranges) : NULL;
+
+  return op;
+}
+
+static char *
+get_cache_dir (void)
+{
+  return g_build_filename (g_get_user_cache_dir (), APP_ID, "spelling", NULL);
+}
+
+static char *
+get_cache_path (const CacheOp *op)
+{
+  g_autoptr(GChecksum) checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  g_autofree char *dir = get_cache_dir ();
+
+  /* Include the trailing \0 so the language cannot run into the text */
+  g_checksum_update (checksum, (const guchar *)op->language, strlen (op->language) + 1);
+  g_checksum_update (checksum, (const guchar *)op->text, strlen (op->text));
+
+  return g_build_filename (dir, g_checksum_get_string (checksum), NULL);
+}
+
+static void
+editor_spell_cache_prune (const char *dir)
+{
+  g_autoptr(GDir) entries = NULL;
+  const char *name;
+  gint64 now;
+
+  if (!(entries = g_dir_open (dir, 0, NULL)))
+    return;
+
+  now = g_get_real_time () / G_USEC_PER_SEC;
+
+  while ((name = g_dir_read_name (entries)))
+    {
+      g_autofree char *path = g_build_filename (dir, name, NULL);
+      GStatBuf st;
+
+      if (g_stat (path, &st) == 0 &&
+          now - (gint64)st.st_mtime > CACHE_MAX_AGE / G_USEC_PER_SEC)
+        g_unlink (path);
+    }
+}
+
+static void
+editor_spell_cache_load_worker (GTask        *task,
+                                gpointer      source_object,
+                                gpointer      task_data,
+                                GCancellable *cancellable)
+{
+  CacheOp *op = task_data;
+  g_autofree char *path = NULL;
+  g_autoptr(GVariant) variant = NULL;
+  g_autoptr(GVariant) ranges = NULL;
+  g_autoptr(GError) error = NULL;
+  const EditorSpellCacheRange *data;
+  GArray *ret;
+  char *contents;
+  gsize len;
+  gsize n_ranges;
+  guint version;
+  guint n_chars;
+  guint text_n_chars;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (op != NULL);
+
+  path = get_cache_path (op);
+
+  if (!g_file_get_contents (path, &contents, &len, &error))
+    {
+      g_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
+
+  variant = g_variant_ref_sink (g_variant_new_from_data (G_VARIANT_TYPE (CACHE_FORMAT),
+                                                         contents, len, FALSE,
+                                                         g_free, contents));
+  g_variant_get (variant, "(uu@a(uu))", &version, &n_chars, &ranges);
+
+  text_n_chars = g_utf8_strlen (op->text, -1);
+
+  if (version != CACHE_VERSION || n_chars != text_n_chars)
+    {
+      g_task_return_new_error (task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_INVALID_DATA,
+                               "Spelling cache entry is out of date");
+      return;
+    }
+
+  data = g_variant_get_fixed_array (ranges, &n_ranges, sizeof *data);
+  ret = g_array_sized_new (FALSE, FALSE, sizeof *data, n_ranges);
+
+  for (gsize i = 0; i < n_ranges; i++)
+    {
+      if (data[i].offset <= n_chars && data[i].length <= n_chars - data[i].offset)
+        g_array_append_val (ret, data[i]);
+    }
+
+  g_task_return_pointer (task, ret, (GDestroyNotify)g_array_unref);
+}
+
+/**
+ * _editor_spell_cache_load_async:
+ * @language: the language code used to check @text
+ * @text: (transfer full): the contents of the document
+ * @cancellable: (nullable): a #GCancellable or %NULL
+ * @callback: a #GAsyncReadyCallback
+ * @user_data: closure data for @callback
+ *
+ * Looks for misspelled ranges of @text stored by a previous call to
+ * _editor_spell_cache_save(). Checksumming @text happens on a thread.
+ */
+void
+_editor_spell_cache_load_async (const char          *language,
+                                char                *text,
+                                GCancellable        *cancellable,
+                                GAsyncReadyCallback  callback,
+                                gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+
+  g_return_if_fail (language != NULL);
+  g_return_if_fail (text != NULL);
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, _editor_spell_cache_load_async);
+  g_task_set_task_data (task, cache_op_new (language, text, NULL), (GDestroyNotify)cache_op_free);
+  g_task_run_in_thread (task, editor_spell_cache_load_worker);
+}
+
+/**
+ * _editor_spell_cache_load_finish:
+ * @result: a #GAsyncResult provided to callback
+ * @error: a location for a #GError, or %NULL
+ *
+ * Returns: (transfer full): a #GArray of #EditorSpellCacheRange, sorted
+ *   by offset, or %NULL if nothing was cached.
+ */
+GArray *
+_editor_spell_cache_load_finish (GAsyncResult  *result,
+                                 GError       **error)
+{
+  g_return_val_if_fail (G_IS_TASK (result), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+static void
+editor_spell_cache_save_worker (GTask        *task,
+                                gpointer      source_object,
+                                gpointer      task_data,
+                                GCancellable *cancellable)
+{
+  CacheOp *op = task_data;
+  g_autofree char *dir = get_cache_dir ();
+  g_autofree char *path = NULL;
+  g_autoptr(GVariant) variant = NULL;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (op != NULL);
+
+  path = get_cache_path (op);
+  variant = g_variant_ref_sink (g_variant_new ("(uu@a(uu))",
+                                               CACHE_VERSION,
+                                               (guint)g_utf8_strlen (op->text, -1),
+                                               g_variant_new_fixed_array (G_VARIANT_TYPE ("(uu)"),
+                                                                          op->ranges->data,
+                                                                          op->ranges->len,
+                                                                          sizeof (EditorSpellCacheRange))));
+
+  if (g_mkdir_with_parents (dir, 0700) != 0 ||
+      !g_file_set_contents (path,
+                            g_variant_get_data (variant),
+                            g_variant_get_size (variant),
+                            &error))
+    g_debug ("Failed to save spelling cache: %s",
+             error ? error->message : g_strerror (errno));
+
+  editor_spell_cache_prune (dir);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+/**
+ * _editor_spell_cache_save:
+ * @language: the language code used to check @text
+ * @text: (transfer full): the contents of the document
+ * @ranges: a #GArray of #EditorSpellCacheRange
+ *
+ * Stores the misspelled @ranges of @text in the background, replacing
+ * anything previously stored for the same contents and language.
+ */
+void
+_editor_spell_cache_save (const char *language,
+                          char       *text,
+                          GArray     *ranges)
+{
+  g_autoptr(GTask) task = NULL;
+
+  g_return_if_fail (language != NULL);
+  g_return_if_fail (text != NULL);
+  g_return_if_fail (ranges != NULL);
+
+  task = g_task_new (NULL, NULL, NULL, NULL);
+  g_task_set_source_tag (task, _editor_spell_cache_save);
+  g_task_set_task_data (task, cache_op_new (language, text, ranges), (GDestroyNotify)cache_op_free);
+  g_task_run_in_thread (task, editor_spell_cache_save_worker);
+}
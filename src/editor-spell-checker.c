@@ -22,17 +22,52 @@
 
 #include <string.h>
 
-#include "editor-spell-checker.h"
-#include "editor-spell-language.h"
+#include "editor-spell-checker-private.h"
+#include "editor-spell-language-private.h"
+#include "editor-spell-metrics-private.h"
 #include "editor-spell-provider.h"
 
+#define MAX_CACHED_CORRECTIONS 128
+
 struct _EditorSpellChecker
 {
   GObject              parent_instance;
   EditorSpellProvider *provider;
   EditorSpellLanguage *language;
+
+  /* Languages are loaded on a worker thread. Until then, @language is
+   * still the previous language and @loading_code the requested one.
+   */
+  GCancellable        *loading;
+  char                *loading_code;
+
+  /* Suggestions computed on a worker thread, keyed by word. Words without
+   * suggestions map to an empty array. Requests in flight are tracked in
+   * @pending so that prefetching and the context menu share one lookup.
+   */
+  GHashTable          *corrections;
+  GHashTable          *pending;
+
+  /* The prefetch in flight, cancelled by the next one and by requests
+   * for corrections so that those do not wait behind it.
+   */
+  GCancellable        *prefetching;
 };
 
+typedef struct
+{
+  EditorSpellLanguage *language;
+  char                *word;
+  GPtrArray           *waiters;
+} ListCorrections;
+
+typedef struct
+{
+  EditorSpellLanguage *language;
+  GPtrArray           *words;
+  GPtrArray           *corrections;
+} PrefetchCorrections;
+
 G_DEFINE_TYPE (EditorSpellChecker, editor_spell_checker, G_TYPE_OBJECT)
 
 enum {
@@ -60,15 +95,63 @@ editor_spell_checker_new (EditorSpellProvider *provider,
   if (provider == NULL)
     provider = editor_spell_provider_get_default ();
 
-  if (language == NULL)
-    language = editor_spell_provider_get_default_code (provider);
-
   return g_object_new (EDITOR_TYPE_SPELL_CHECKER,
                        "provider", provider,
                        "language", language,
                        NULL);
 }
 
+static void
+editor_spell_checker_load_language_cb (GObject      *object,
+                                       GAsyncResult *result,
+                                       gpointer      user_data)
+{
+  EditorSpellProvider *provider = (EditorSpellProvider *)object;
+  g_autoptr(EditorSpellChecker) self = user_data;
+  g_autoptr(EditorSpellLanguage) language = NULL;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (EDITOR_IS_SPELL_PROVIDER (provider));
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (EDITOR_IS_SPELL_CHECKER (self));
+
+  language = editor_spell_provider_load_language_finish (provider, result, &error);
+
+  /* Superseded by another language request */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  g_clear_object (&self->loading);
+  g_clear_pointer (&self->loading_code, g_free);
+  g_set_object (&self->language, language);
+
+  g_hash_table_remove_all (self->corrections);
+  g_hash_table_remove_all (self->pending);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_LANGUAGE]);
+}
+
+static void
+editor_spell_checker_load_language (EditorSpellChecker *self,
+                                    const char         *code)
+{
+  g_assert (EDITOR_IS_SPELL_CHECKER (self));
+  g_assert (EDITOR_IS_SPELL_PROVIDER (self->provider));
+
+  g_cancellable_cancel (self->loading);
+  g_clear_object (&self->loading);
+
+  g_free (self->loading_code);
+  self->loading_code = g_strdup (code);
+  self->loading = g_cancellable_new ();
+
+  editor_spell_provider_load_language_async (self->provider,
+                                             code,
+                                             self->loading,
+                                             editor_spell_checker_load_language_cb,
+                                             g_object_ref (self));
+}
+
 static void
 editor_spell_checker_constructed (GObject *object)
 {
@@ -79,7 +162,11 @@ editor_spell_checker_constructed (GObject *object)
   G_OBJECT_CLASS (editor_spell_checker_parent_class)->constructed (object);
 
   if (self->provider == NULL)
-    self->provider = editor_spell_provider_get_default ();
+    self->provider = g_object_ref (editor_spell_provider_get_default ());
+
+  /* Resolving the default language may load dictionaries too */
+  if (self->language == NULL && self->loading == NULL)
+    editor_spell_checker_load_language (self, NULL);
 }
 
 static void
@@ -87,8 +174,15 @@ editor_spell_checker_finalize (GObject *object)
 {
   EditorSpellChecker *self = (EditorSpellChecker *)object;
 
+  g_cancellable_cancel (self->loading);
+  g_clear_object (&self->loading);
+  g_clear_pointer (&self->loading_code, g_free);
+  g_cancellable_cancel (self->prefetching);
+  g_clear_object (&self->prefetching);
   g_clear_object (&self->provider);
   g_clear_object (&self->language);
+  g_clear_pointer (&self->corrections, g_hash_table_unref);
+  g_clear_pointer (&self->pending, g_hash_table_unref);
 
   G_OBJECT_CLASS (editor_spell_checker_parent_class)->finalize (object);
 }
@@ -185,6 +279,8 @@ editor_spell_checker_class_init (EditorSpellCheckerClass *klass)
 static void
 editor_spell_checker_init (EditorSpellChecker *self)
 {
+  self->corrections = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_strfreev);
+  self->pending = g_hash_table_new (g_str_hash, g_str_equal);
 }
 
 /**
@@ -199,9 +295,28 @@ editor_spell_checker_get_language (EditorSpellChecker *self)
 {
   g_return_val_if_fail (EDITOR_IS_SPELL_CHECKER (self), NULL);
 
+  if (self->loading != NULL)
+    return self->loading_code;
+
   return self->language ? editor_spell_language_get_code (self->language) : NULL;
 }
 
+/**
+ * editor_spell_checker_get_busy:
+ *
+ * Checks if the dictionary for #EditorSpellChecker:language is still
+ * being loaded, in which case every word is considered correct.
+ *
+ * Returns: %TRUE if a dictionary is loading
+ */
+gboolean
+editor_spell_checker_get_busy (EditorSpellChecker *self)
+{
+  g_return_val_if_fail (EDITOR_IS_SPELL_CHECKER (self), FALSE);
+
+  return self->loading != NULL;
+}
+
 /**
  * editor_spell_checker_set_language:
  * @self: an #EditorSpellChecker
@@ -209,6 +324,10 @@ editor_spell_checker_get_language (EditorSpellChecker *self)
  *
  * Sets the language code to use when communicating with the provider,
  * such as `en_US`.
+ *
+ * The dictionary is loaded on a worker thread. Words are checked with
+ * the previous language until #EditorSpellChecker:language is notified
+ * again once it has loaded.
  */
 void
 editor_spell_checker_set_language (EditorSpellChecker *self,
@@ -218,7 +337,23 @@ editor_spell_checker_set_language (EditorSpellChecker *self,
 
   if (g_strcmp0 (language, editor_spell_checker_get_language (self)) != 0)
     {
-      self->language = editor_spell_provider_get_language (self->provider, language);
+      if (language != NULL)
+        {
+          editor_spell_checker_load_language (self, language);
+        }
+      else
+        {
+          g_cancellable_cancel (self->loading);
+          g_clear_object (&self->loading);
+          g_clear_object (&self->language);
+
+          /* Requests in flight finish, but their results are not cached */
+          g_cancellable_cancel (self->prefetching);
+          g_clear_object (&self->prefetching);
+          g_hash_table_remove_all (self->corrections);
+          g_hash_table_remove_all (self->pending);
+        }
+
       g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_LANGUAGE]);
     }
 }
@@ -260,11 +395,16 @@ editor_spell_checker_check_word (EditorSpellChecker *self,
                                  const char         *word,
                                  gssize              word_len)
 {
+  gboolean cached;
+  gboolean ret;
+
   g_return_val_if_fail (EDITOR_IS_SPELL_CHECKER (self), FALSE);
 
   if (word == NULL || word_len == 0)
     return FALSE;
 
+  _editor_spell_metrics.n_words++;
+
   if (self->language == NULL)
     return TRUE;
 
@@ -274,7 +414,14 @@ editor_spell_checker_check_word (EditorSpellChecker *self,
   if (word_is_number (word, word_len))
     return TRUE;
 
-  return editor_spell_language_contains_word (self->language, word, word_len);
+  ret = _editor_spell_language_contains_word (self->language, word, word_len, &cached);
+
+  if (cached)
+    _editor_spell_metrics.n_cache_hits++;
+  else
+    _editor_spell_metrics.n_cache_misses++;
+
+  return ret;
 }
 
 char **
@@ -290,6 +437,333 @@ editor_spell_checker_list_corrections (EditorSpellChecker *self,
   return editor_spell_language_list_corrections (self->language, word, -1);
 }
 
+static void
+list_corrections_free (ListCorrections *state)
+{
+  g_clear_object (&state->language);
+  g_clear_pointer (&state->word, g_free);
+  g_clear_pointer (&state->waiters, g_ptr_array_unref);
+  g_slice_free (ListCorrections, state);
+}
+
+static void
+editor_spell_checker_list_corrections_worker (GTask        *task,
+                                              gpointer      source_object,
+                                              gpointer      task_data,
+                                              GCancellable *cancellable)
+{
+  ListCorrections *state = task_data;
+  char **corrections;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (state != NULL);
+  g_assert (EDITOR_IS_SPELL_LANGUAGE (state->language));
+
+  if (!(corrections = editor_spell_language_list_corrections (state->language, state->word, -1)))
+    corrections = g_new0 (char *, 1);
+
+  g_task_return_pointer (task, corrections, (GDestroyNotify)g_strfreev);
+}
+
+static void
+editor_spell_checker_list_corrections_cb (GObject      *object,
+                                          GAsyncResult *result,
+                                          gpointer      user_data)
+{
+  EditorSpellChecker *self = (EditorSpellChecker *)object;
+  g_auto(GStrv) corrections = NULL;
+  ListCorrections *state;
+
+  g_assert (EDITOR_IS_SPELL_CHECKER (self));
+  g_assert (G_IS_TASK (result));
+
+  state = g_task_get_task_data (G_TASK (result));
+  corrections = g_task_propagate_pointer (G_TASK (result), NULL);
+
+  if (g_hash_table_lookup (self->pending, state->word) == state)
+    g_hash_table_remove (self->pending, state->word);
+
+  if (corrections != NULL && state->language == self->language)
+    {
+      if (g_hash_table_size (self->corrections) >= MAX_CACHED_CORRECTIONS)
+        g_hash_table_remove_all (self->corrections);
+
+      g_hash_table_insert (self->corrections,
+                           g_strdup (state->word),
+                           g_strdupv (corrections));
+    }
+
+  for (guint i = 0; i < state->waiters->len; i++)
+    {
+      GTask *waiter = g_ptr_array_index (state->waiters, i);
+
+      g_task_return_pointer (waiter,
+                             corrections && corrections[0] ? g_strdupv (corrections) : NULL,
+                             (GDestroyNotify)g_strfreev);
+    }
+}
+
+static void
+editor_spell_checker_request_corrections (EditorSpellChecker *self,
+                                          const char         *word,
+                                          GTask              *waiter)
+{
+  g_autoptr(GTask) task = NULL;
+  ListCorrections *state;
+
+  g_assert (EDITOR_IS_SPELL_CHECKER (self));
+  g_assert (word != NULL);
+  g_assert (self->language != NULL);
+
+  if ((state = g_hash_table_lookup (self->pending, word)))
+    {
+      if (waiter != NULL)
+        g_ptr_array_add (state->waiters, g_object_ref (waiter));
+      return;
+    }
+
+  state = g_slice_new0 (ListCorrections);
+  state->language = g_object_ref (self->language);
+  state->word = g_strdup (word);
+  state->waiters = g_ptr_array_new_with_free_func (g_object_unref);
+
+  if (waiter != NULL)
+    g_ptr_array_add (state->waiters, g_object_ref (waiter));
+
+  g_hash_table_insert (self->pending, state->word, state);
+
+  task = g_task_new (self, NULL, editor_spell_checker_list_corrections_cb, NULL);
+  g_task_set_source_tag (task, editor_spell_checker_request_corrections);
+  g_task_set_task_data (task, state, (GDestroyNotify)list_corrections_free);
+  g_task_run_in_thread (task, editor_spell_checker_list_corrections_worker);
+}
+
+/**
+ * editor_spell_checker_lookup_corrections:
+ * @self: an #EditorSpellChecker
+ * @word: the misspelled word
+ * @corrections: (out) (transfer full) (nullable): location for corrections
+ *
+ * Looks for corrections to @word that were already computed, such as by
+ * editor_spell_checker_prefetch_corrections(). This never blocks.
+ *
+ * Returns: %TRUE if the corrections were known and @corrections was set
+ */
+gboolean
+editor_spell_checker_lookup_corrections (EditorSpellChecker   *self,
+                                         const char           *word,
+                                         char               ***corrections)
+{
+  const char * const *cached;
+
+  g_return_val_if_fail (EDITOR_IS_SPELL_CHECKER (self), FALSE);
+  g_return_val_if_fail (word != NULL, FALSE);
+  g_return_val_if_fail (corrections != NULL, FALSE);
+
+  *corrections = NULL;
+
+  if (self->language == NULL)
+    return TRUE;
+
+  if (!(cached = g_hash_table_lookup (self->corrections, word)))
+    return FALSE;
+
+  if (cached[0] != NULL)
+    *corrections = g_strdupv ((char **)cached);
+
+  return TRUE;
+}
+
+static void
+prefetch_corrections_free (PrefetchCorrections *state)
+{
+  g_clear_object (&state->language);
+  g_clear_pointer (&state->words, g_ptr_array_unref);
+  g_clear_pointer (&state->corrections, g_ptr_array_unref);
+  g_slice_free (PrefetchCorrections, state);
+}
+
+static void
+editor_spell_checker_prefetch_worker (GTask        *task,
+                                      gpointer      source_object,
+                                      gpointer      task_data,
+                                      GCancellable *cancellable)
+{
+  PrefetchCorrections *state = task_data;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (state != NULL);
+  g_assert (EDITOR_IS_SPELL_LANGUAGE (state->language));
+
+  /* Stop between words once cancelled, keeping what was computed */
+  for (guint i = 0; i < state->words->len; i++)
+    {
+      const char *word = g_ptr_array_index (state->words, i);
+      char **corrections;
+
+      if (g_cancellable_is_cancelled (cancellable))
+        break;
+
+      if (!(corrections = editor_spell_language_list_corrections (state->language, word, -1)))
+        corrections = g_new0 (char *, 1);
+
+      g_ptr_array_add (state->corrections, corrections);
+    }
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+editor_spell_checker_prefetch_cb (GObject      *object,
+                                  GAsyncResult *result,
+                                  gpointer      user_data)
+{
+  EditorSpellChecker *self = (EditorSpellChecker *)object;
+  PrefetchCorrections *state;
+
+  g_assert (EDITOR_IS_SPELL_CHECKER (self));
+  g_assert (G_IS_TASK (result));
+
+  state = g_task_get_task_data (G_TASK (result));
+
+  if (state->language != self->language)
+    return;
+
+  for (guint i = 0; i < state->corrections->len; i++)
+    {
+      const char *word = g_ptr_array_index (state->words, i);
+
+      if (g_hash_table_size (self->corrections) >= MAX_CACHED_CORRECTIONS)
+        g_hash_table_remove_all (self->corrections);
+
+      g_hash_table_insert (self->corrections,
+                           g_strdup (word),
+                           g_steal_pointer (&g_ptr_array_index (state->corrections, i)));
+    }
+}
+
+/**
+ * editor_spell_checker_prefetch_corrections:
+ * @self: an #EditorSpellChecker
+ * @words: a %NULL-terminated array of misspelled words
+ * @cancellable: (nullable): a #GCancellable
+ *
+ * Computes corrections for @words on a worker thread, one after the
+ * other, and caches them so that they are available immediately when
+ * requested later.
+ *
+ * This cancels any previous prefetch, and is itself cancelled by
+ * requests for corrections, so only one is in flight at a time. Words
+ * whose corrections were computed by then are still cached.
+ */
+void
+editor_spell_checker_prefetch_corrections (EditorSpellChecker *self,
+                                           const char * const *words,
+                                           GCancellable       *cancellable)
+{
+  g_autoptr(GTask) task = NULL;
+  PrefetchCorrections *state;
+
+  g_return_if_fail (EDITOR_IS_SPELL_CHECKER (self));
+  g_return_if_fail (words != NULL);
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  g_cancellable_cancel (self->prefetching);
+  g_clear_object (&self->prefetching);
+
+  if (self->language == NULL)
+    return;
+
+  state = g_slice_new0 (PrefetchCorrections);
+  state->language = g_object_ref (self->language);
+  state->words = g_ptr_array_new_with_free_func (g_free);
+  state->corrections = g_ptr_array_new_with_free_func ((GDestroyNotify)g_strfreev);
+
+  for (guint i = 0; words[i]; i++)
+    {
+      if (!g_hash_table_contains (self->corrections, words[i]) &&
+          !g_hash_table_contains (self->pending, words[i]))
+        g_ptr_array_add (state->words, g_strdup (words[i]));
+    }
+
+  if (state->words->len == 0)
+    {
+      prefetch_corrections_free (state);
+      return;
+    }
+
+  self->prefetching = cancellable ? g_object_ref (cancellable) : g_cancellable_new ();
+
+  task = g_task_new (self, self->prefetching, editor_spell_checker_prefetch_cb, NULL);
+  g_task_set_source_tag (task, editor_spell_checker_prefetch_corrections);
+  g_task_set_check_cancellable (task, FALSE);
+  g_task_set_task_data (task, state, (GDestroyNotify)prefetch_corrections_free);
+  g_task_run_in_thread (task, editor_spell_checker_prefetch_worker);
+}
+
+/**
+ * editor_spell_checker_list_corrections_async:
+ * @self: an #EditorSpellChecker
+ * @word: the misspelled word
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: a #GAsyncReadyCallback
+ * @user_data: closure data for @callback
+ *
+ * Asynchronously lists corrections for @word. Providers may take a long
+ * time to suggest words, so this is done on a worker thread unless the
+ * corrections were already prefetched.
+ */
+void
+editor_spell_checker_list_corrections_async (EditorSpellChecker  *self,
+                                             const char          *word,
+                                             GCancellable        *cancellable,
+                                             GAsyncReadyCallback  callback,
+                                             gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  char **corrections = NULL;
+
+  g_return_if_fail (EDITOR_IS_SPELL_CHECKER (self));
+  g_return_if_fail (word != NULL);
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, editor_spell_checker_list_corrections_async);
+
+  if (editor_spell_checker_lookup_corrections (self, word, &corrections))
+    {
+      g_task_return_pointer (task, corrections, (GDestroyNotify)g_strfreev);
+      return;
+    }
+
+  /* Takes priority over prefetching, which stops after the current word */
+  g_cancellable_cancel (self->prefetching);
+  g_clear_object (&self->prefetching);
+
+  editor_spell_checker_request_corrections (self, word, task);
+}
+
+/**
+ * editor_spell_checker_list_corrections_finish:
+ * @self: an #EditorSpellChecker
+ * @result: a #GAsyncResult
+ * @error: a location for a #GError
+ *
+ * Completes a request to editor_spell_checker_list_corrections_async().
+ *
+ * Returns: (transfer full) (nullable): the corrections or %NULL
+ */
+char **
+editor_spell_checker_list_corrections_finish (EditorSpellChecker  *self,
+                                              GAsyncResult        *result,
+                                              GError             **error)
+{
+  g_return_val_if_fail (EDITOR_IS_SPELL_CHECKER (self), NULL);
+  g_return_val_if_fail (G_IS_TASK (result), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
 void
 editor_spell_checker_add_word (EditorSpellChecker *self,
                                const char         *word)
@@ -298,7 +772,10 @@ editor_spell_checker_add_word (EditorSpellChecker *self,
   g_return_if_fail (word != NULL);
 
   if (self->language != NULL)
-    editor_spell_language_add_word (self->language, word);
+    {
+      editor_spell_language_add_word (self->language, word);
+      g_hash_table_remove (self->corrections, word);
+    }
 }
 
 void
@@ -309,7 +786,27 @@ editor_spell_checker_ignore_word (EditorSpellChecker *self,
   g_return_if_fail (word != NULL);
 
   if (self->language != NULL)
-    editor_spell_language_ignore_word (self->language, word);
+    {
+      editor_spell_language_ignore_word (self->language, word);
+      g_hash_table_remove (self->corrections, word);
+    }
+}
+
+/**
+ * _editor_spell_checker_get_spell_language:
+ * @self: an #EditorSpellChecker
+ *
+ * Gets the dictionary used to check words, which is %NULL until the
+ * first language has loaded.
+ *
+ * Returns: (transfer none) (nullable): an #EditorSpellLanguage
+ */
+EditorSpellLanguage *
+_editor_spell_checker_get_spell_language (EditorSpellChecker *self)
+{
+  g_return_val_if_fail (EDITOR_IS_SPELL_CHECKER (self), NULL);
+
+  return self->language;
 }
 
 const char *
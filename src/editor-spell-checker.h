@@ -28,21 +28,36 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (EditorSpellChecker, editor_spell_checker, EDITOR, SPELL_CHECKER, GObject)
 
-EditorSpellChecker   *editor_spell_checker_new                  (EditorSpellProvider *provider,
-                                                                 const char          *language);
-EditorSpellProvider  *editor_spell_checker_get_provider         (EditorSpellChecker  *self);
-const char           *editor_spell_checker_get_language         (EditorSpellChecker  *self);
-void                  editor_spell_checker_set_language         (EditorSpellChecker  *self,
-                                                                 const char          *language);
-gboolean              editor_spell_checker_check_word           (EditorSpellChecker  *self,
-                                                                 const char          *word,
-                                                                 gssize               word_len);
-char                **editor_spell_checker_list_corrections     (EditorSpellChecker  *self,
-                                                                 const char          *word);
-void                  editor_spell_checker_add_word             (EditorSpellChecker  *self,
-                                                                 const char          *word);
-void                  editor_spell_checker_ignore_word          (EditorSpellChecker  *self,
-                                                                 const char          *word);
-const char           *editor_spell_checker_get_extra_word_chars (EditorSpellChecker  *self);
+EditorSpellChecker   *editor_spell_checker_new                     (EditorSpellProvider   *provider,
+                                                                    const char            *language);
+EditorSpellProvider  *editor_spell_checker_get_provider            (EditorSpellChecker    *self);
+const char           *editor_spell_checker_get_language            (EditorSpellChecker    *self);
+gboolean              editor_spell_checker_get_busy                (EditorSpellChecker    *self);
+void                  editor_spell_checker_set_language            (EditorSpellChecker    *self,
+                                                                    const char            *language);
+gboolean              editor_spell_checker_check_word              (EditorSpellChecker    *self,
+                                                                    const char            *word,
+                                                                    gssize                 word_len);
+char                **editor_spell_checker_list_corrections        (EditorSpellChecker    *self,
+                                                                    const char            *word);
+void                  editor_spell_checker_list_corrections_async  (EditorSpellChecker    *self,
+                                                                    const char            *word,
+                                                                    GCancellable          *cancellable,
+                                                                    GAsyncReadyCallback    callback,
+                                                                    gpointer               user_data);
+char                **editor_spell_checker_list_corrections_finish (EditorSpellChecker    *self,
+                                                                    GAsyncResult          *result,
+                                                                    GError               **error);
+gboolean              editor_spell_checker_lookup_corrections      (EditorSpellChecker    *self,
+                                                                    const char            *word,
+                                                                    char                ***corrections);
+void                  editor_spell_checker_prefetch_corrections    (EditorSpellChecker    *self,
+                                                                    const char * const    *words,
+                                                                    GCancellable          *cancellable);
+void                  editor_spell_checker_add_word                (EditorSpellChecker    *self,
+                                                                    const char            *word);
+void                  editor_spell_checker_ignore_word             (EditorSpellChecker    *self,
+                                                                    const char            *word);
+const char           *editor_spell_checker_get_extra_word_chars    (EditorSpellChecker    *self);
 
 G_END_DECLS
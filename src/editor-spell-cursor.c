@@ -20,134 +20,92 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "cjhtextregionprivate.h"
 #include "editor-spell-cursor.h"
 
 #define RUN_UNCHECKED NULL
 
+/* Very long lines are segmented in windows of this many characters so
+ * that we never copy more than we need per pass of the spellchecker.
+ */
+#define SEGMENT_MAX_CHARS 4096
+#define SEGMENT_LOOKBEHIND 64
+
+/* How much of the buffer to intersect with the unchecked region and
+ * the no-spell-check tag at once.
+ */
+#define WINDOW_CHARS 16384
+
+enum {
+  WORD_CHAR_LETTER = 1 << 0,
+  WORD_CHAR_DIGIT  = 1 << 1,
+  WORD_CHAR_EXTRA  = 1 << 2,
+};
+
+#define WORD_CHAR_CLASS (WORD_CHAR_LETTER | WORD_CHAR_DIGIT)
+
 typedef struct
 {
-  CjhTextRegion *region;
-  GtkTextBuffer *buffer;
-  gssize pos;
-} RegionIter;
+  guint begin;
+  guint end;
+} Interval;
 
 typedef struct
 {
-  GtkTextBuffer *buffer;
-  GtkTextTag *tag;
-  GtkTextIter pos;
-} TagIter;
+  guint begin;
+  guint end;
+  /* The text without the no-spell-check tag containing the range */
+  guint span_begin;
+  guint span_end;
+} CheckableRange;
+
+typedef struct
+{
+  /* A copy of (part of) a single line, including the line delimiter
+   * when @at_line_end is set. Only ASCII text is kept so that byte
+   * positions are also character positions. Tags may change while the
+   * cursor is in use, but the text may not.
+   */
+  char *text;
+  int line;
+  int offset;
+  int len;
+  guint is_ascii : 1;
+  guint at_line_end : 1;
+  guint overflow : 1;
+} Segment;
 
 typedef struct
 {
   GtkTextBuffer *buffer;
   GtkTextIter word_begin;
   GtkTextIter word_end;
+  Segment segment;
+  guint8 table[128];
 } WordIter;
 
 struct _EditorSpellCursor
 {
-  RegionIter region;
-  TagIter tag;
-  WordIter word;
+  GtkTextBuffer *buffer;
+  CjhTextRegion *region;
+  GtkTextTag *no_spell_check_tag;
   const char *extra_word_chars;
-};
-
-static void
-region_iter_init (RegionIter    *self,
-                  GtkTextBuffer *buffer,
-                  CjhTextRegion *region)
-{
-  self->region = region;
-  self->buffer = buffer;
-  self->pos = -1;
-}
-
-static gboolean
-region_iter_next_cb (gsize                   position,
-                     const CjhTextRegionRun *run,
-                     gpointer                user_data)
-{
-  if (run->data == RUN_UNCHECKED)
-    {
-      gsize *pos = user_data;
-      *pos = position;
-      return TRUE;
-    }
 
-  return FALSE;
-}
-
-static gboolean
-region_iter_next (RegionIter  *self,
-                  GtkTextIter *iter)
-{
-  gsize pos, new_pos;
-
-  if (self->pos >= (gssize)_cjh_text_region_get_length (self->region))
-    {
-      gtk_text_buffer_get_end_iter (self->buffer, iter);
-      return FALSE;
-    }
-
-  if (self->pos < 0)
-    pos = 0;
-  else
-    pos = self->pos;
-
-  _cjh_text_region_foreach_in_range (self->region,
-                                     pos,
-                                     _cjh_text_region_get_length (self->region),
-                                     region_iter_next_cb,
-                                     &new_pos);
-
-  pos = MAX (pos, new_pos);
-  gtk_text_buffer_get_iter_at_offset (self->buffer, iter, pos);
-  self->pos = pos;
-
-  return TRUE;
-}
-
-static void
-region_iter_seek (RegionIter        *self,
-                  const GtkTextIter *iter)
-{
-  /* Move to position past the word */
-  self->pos = gtk_text_iter_get_offset (iter) + 1;
-}
-
-static void
-tag_iter_init (TagIter       *self,
-               GtkTextBuffer *buffer,
-               GtkTextTag    *tag)
-{
-  self->buffer = buffer;
-  self->tag = tag;
-  gtk_text_buffer_get_start_iter (buffer, &self->pos);
-}
-
-static gboolean
-tag_iter_next (TagIter     *self,
-               GtkTextIter *pos)
-{
-  if (self->tag && gtk_text_iter_has_tag (&self->pos, self->tag))
-    {
-      /* Should always succeed because we are within the tag */
-      gtk_text_iter_forward_to_tag_toggle (&self->pos, self->tag);
-    }
-
-  *pos = self->pos;
+  /* Unchecked text intersected with text that is not tagged as
+   * no-spell-check, for the window of the buffer ending at
+   * @window_end. Words are only looked for within these ranges.
+   */
+  GArray *ranges;
+  guint range_index;
+  guint window_end;
 
-  return TRUE;
-}
+  /* Position to continue looking for words from */
+  guint pos;
 
-static void
-tag_iter_seek (TagIter           *self,
-               const GtkTextIter *iter)
-{
-  self->pos = *iter;
-}
+  WordIter word;
+};
 
 static inline gboolean
 is_extra_word_char (const GtkTextIter *iter,
@@ -179,9 +137,14 @@ editor_spell_iter_forward_word_end (GtkTextIter *iter,
 
   if (gtk_text_iter_forward_word_end (iter))
     {
-      tmp = *iter;
+      GtkTextIter next;
+
+      tmp = next = *iter;
 
-      if (is_extra_word_char (&tmp, extra_word_chars))
+      /* Only join when another word follows the extra char directly */
+      if (is_extra_word_char (&tmp, extra_word_chars) &&
+          gtk_text_iter_forward_char (&next) &&
+          gtk_text_iter_starts_word (&next))
         {
           if (editor_spell_iter_forward_word_end (&tmp, extra_word_chars))
             *iter = tmp;
@@ -209,7 +172,8 @@ editor_spell_iter_backward_word_start (GtkTextIter *iter,
       tmp = *iter;
 
       if (gtk_text_iter_backward_char (&tmp) &&
-          is_extra_word_char (&tmp, extra_word_chars))
+          is_extra_word_char (&tmp, extra_word_chars) &&
+          gtk_text_iter_ends_word (&tmp))
         {
           if (editor_spell_iter_backward_word_start (&tmp, extra_word_chars))
             *iter = tmp;
@@ -228,11 +192,264 @@ editor_spell_iter_backward_word_start (GtkTextIter *iter,
 
 static void
 word_iter_init (WordIter      *self,
-                GtkTextBuffer *buffer)
+                GtkTextBuffer *buffer,
+                const char    *extra_word_chars)
 {
   self->buffer = buffer;
   gtk_text_buffer_get_start_iter (buffer, &self->word_begin);
   self->word_end = self->word_begin;
+  self->segment.line = -1;
+
+  /* This must match what Pango considers part of a word for ASCII along
+   * with is_extra_word_char() so that both paths find the same words.
+   */
+  memset (self->table, 0, sizeof self->table);
+  for (guint i = 'a'; i <= 'z'; i++)
+    self->table[i] = self->table[i - 'a' + 'A'] = WORD_CHAR_LETTER;
+  for (guint i = '0'; i <= '9'; i++)
+    self->table[i] = WORD_CHAR_DIGIT;
+  self->table['\''] |= WORD_CHAR_EXTRA;
+  for (const char *c = extra_word_chars; *c; c++)
+    {
+      if (*c != ' ' && *c != '\n' && *c != '\t' && *c != '\r' && !(*c & 0x80))
+        self->table[(guint)*c] |= WORD_CHAR_EXTRA;
+    }
+}
+
+static void
+word_iter_clear (WordIter *self)
+{
+  g_clear_pointer (&self->segment.text, g_free);
+}
+
+static gboolean
+segment_contains (const Segment *segment,
+                  int            line,
+                  int            offset)
+{
+  return segment->line == line &&
+         offset >= segment->offset &&
+         (offset < segment->offset + segment->len ||
+          (segment->at_line_end && offset == segment->offset + segment->len));
+}
+
+/* Loads the segment containing @pos and returns %TRUE if it can be
+ * handled by the ASCII fast path. Non-ASCII segments are remembered
+ * (without their text) so that we only look at them once.
+ */
+static gboolean
+word_iter_load_segment (WordIter          *self,
+                        const GtkTextIter *pos)
+{
+  Segment *segment = &self->segment;
+  GtkTextIter begin, end;
+  int line = gtk_text_iter_get_line (pos);
+  int offset = gtk_text_iter_get_line_offset (pos);
+  int n_chars;
+  int begin_offset;
+  int end_offset;
+
+  if (segment_contains (segment, line, offset))
+    return segment->is_ascii;
+
+  g_clear_pointer (&segment->text, g_free);
+
+  n_chars = gtk_text_iter_get_chars_in_line (pos);
+
+  if (n_chars <= SEGMENT_MAX_CHARS)
+    {
+      begin_offset = 0;
+      end_offset = n_chars;
+    }
+  else
+    {
+      begin_offset = MAX (0, offset - SEGMENT_LOOKBEHIND);
+      end_offset = MIN (n_chars, begin_offset + SEGMENT_MAX_CHARS);
+    }
+
+  begin = end = *pos;
+  gtk_text_iter_set_line_offset (&begin, begin_offset);
+  if (end_offset == n_chars)
+    {
+      if (!gtk_text_iter_forward_line (&end))
+        gtk_text_iter_forward_to_end (&end);
+    }
+  else
+    gtk_text_iter_set_line_offset (&end, end_offset);
+
+  segment->line = line;
+  segment->offset = begin_offset;
+  segment->len = end_offset - begin_offset;
+  segment->at_line_end = end_offset == n_chars;
+  segment->text = gtk_text_iter_get_slice (&begin, &end);
+
+  /* Any multi-byte character (including U+FFFC for child anchors and
+   * paintables) makes the slice longer in bytes than in characters.
+   */
+  segment->is_ascii = strlen (segment->text) == (gsize)segment->len;
+
+  if (!segment->is_ascii)
+    g_clear_pointer (&segment->text, g_free);
+
+  return segment->is_ascii;
+}
+
+/* Positions past either end of the segment are line delimiters (or the
+ * edges of the buffer) which are never part of a word. If the segment
+ * is a window into a longer line we cannot know, so @overflow is set
+ * and the caller must use the slow path instead.
+ */
+static inline guint8
+segment_get (WordIter *self,
+             int       i)
+{
+  Segment *segment = &self->segment;
+
+  if (i >= 0 && i < segment->len)
+    return self->table[(guint8)segment->text[i]];
+
+  if ((i < 0 && segment->offset > 0) || (i >= segment->len && !segment->at_line_end))
+    segment->overflow = TRUE;
+
+  return 0;
+}
+
+static inline gboolean
+segment_starts_word (WordIter *self,
+                     int       i)
+{
+  guint8 class = segment_get (self, i) & WORD_CHAR_CLASS;
+
+  return class != 0 && (segment_get (self, i - 1) & WORD_CHAR_CLASS) != class;
+}
+
+static inline gboolean
+segment_ends_word (WordIter *self,
+                   int       i)
+{
+  guint8 class = segment_get (self, i - 1) & WORD_CHAR_CLASS;
+
+  return class != 0 && (segment_get (self, i) & WORD_CHAR_CLASS) != class;
+}
+
+static inline gboolean
+segment_is_extra (WordIter *self,
+                  int       i)
+{
+  return (segment_get (self, i) & WORD_CHAR_EXTRA) != 0;
+}
+
+static int
+segment_forward_word_end (WordIter *self,
+                          int       i)
+{
+  for (int e = i + 1; e <= self->segment.len; e++)
+    {
+      if (segment_ends_word (self, e))
+        {
+          /* Join words separated by a single extra word char */
+          while (segment_is_extra (self, e) && segment_starts_word (self, e + 1))
+            {
+              for (e = e + 2; !segment_ends_word (self, e); e++)
+                {
+                  if (self->segment.overflow)
+                    return -1;
+                }
+            }
+
+          return e;
+        }
+    }
+
+  if (!self->segment.at_line_end)
+    self->segment.overflow = TRUE;
+
+  return -1;
+}
+
+static int
+segment_backward_word_start (WordIter *self,
+                             int       i)
+{
+  for (int b = i - 1; b >= 0; b--)
+    {
+      if (segment_starts_word (self, b))
+        {
+          while (segment_is_extra (self, b - 1) && segment_ends_word (self, b - 1))
+            {
+              for (b = b - 2; !segment_starts_word (self, b); b--)
+                {
+                  if (self->segment.overflow)
+                    return -1;
+                }
+            }
+
+          return b;
+        }
+    }
+
+  if (self->segment.offset > 0)
+    self->segment.overflow = TRUE;
+
+  return -1;
+}
+
+/* Segments pure ASCII lines with a lookup table instead of asking Pango
+ * for log attributes, which is the dominant cost of a spellcheck pass.
+ * Returns %FALSE if the caller must continue from @self->word_end using
+ * the Pango based iter functions.
+ */
+static gboolean
+word_iter_next_ascii (WordIter *self,
+                      gboolean *found)
+{
+  GtkTextIter pos = self->word_end;
+
+  for (;;)
+    {
+      int begin, end;
+
+      self->segment.overflow = FALSE;
+
+      if (!word_iter_load_segment (self, &pos))
+        break;
+
+      end = segment_forward_word_end (self, gtk_text_iter_get_line_offset (&pos) - self->segment.offset);
+      if (self->segment.overflow)
+        break;
+
+      if (end < 0)
+        {
+          /* Nothing left on this line, try the next */
+          if (!gtk_text_iter_forward_line (&pos))
+            {
+              self->word_begin = self->word_end = pos;
+              *found = FALSE;
+              return TRUE;
+            }
+
+          continue;
+        }
+
+      begin = segment_backward_word_start (self, end);
+      if (self->segment.overflow)
+        break;
+
+      g_assert (begin >= 0);
+      g_assert (begin < end);
+
+      self->word_begin = self->word_end = pos;
+      gtk_text_iter_set_line_offset (&self->word_begin, self->segment.offset + begin);
+      gtk_text_iter_set_line_offset (&self->word_end, self->segment.offset + end);
+      *found = TRUE;
+
+      return TRUE;
+    }
+
+  /* Anything we skipped had no words, so Pango can start from here */
+  self->word_end = pos;
+
+  return FALSE;
 }
 
 static gboolean
@@ -241,6 +458,15 @@ word_iter_next (WordIter    *self,
                 GtkTextIter *word_end,
                 const char  *extra_word_chars)
 {
+  gboolean found;
+
+  if (word_iter_next_ascii (self, &found))
+    {
+      *word_begin = found ? self->word_begin : self->word_end;
+      *word_end = self->word_end;
+      return found;
+    }
+
   if (!editor_spell_iter_forward_word_end (&self->word_end, extra_word_chars))
     {
       *word_begin = self->word_end;
@@ -284,82 +510,246 @@ editor_spell_cursor_new (GtkTextBuffer *buffer,
   g_return_val_if_fail (!no_spell_check_tag || GTK_IS_TEXT_TAG (no_spell_check_tag), NULL);
 
   self = g_rc_box_new0 (EditorSpellCursor);
-  region_iter_init (&self->region, buffer, region);
-  tag_iter_init (&self->tag, buffer, no_spell_check_tag);
-  word_iter_init (&self->word, buffer);
+  self->buffer = buffer;
+  self->region = region;
+  self->no_spell_check_tag = no_spell_check_tag;
   self->extra_word_chars = extra_word_chars ? g_intern_string (extra_word_chars) : "";
+  self->ranges = g_array_new (FALSE, FALSE, sizeof (CheckableRange));
+  word_iter_init (&self->word, buffer, self->extra_word_chars);
 
   return self;
 }
 
+static void
+editor_spell_cursor_finalize (gpointer data)
+{
+  EditorSpellCursor *self = data;
+
+  word_iter_clear (&self->word);
+  g_clear_pointer (&self->ranges, g_array_unref);
+}
+
 void
 editor_spell_cursor_free (EditorSpellCursor *self)
 {
-  g_rc_box_release (self);
+  g_rc_box_release_full (self, editor_spell_cursor_finalize);
 }
 
 static gboolean
-contains_tag (const GtkTextIter *word_begin,
-              const GtkTextIter *word_end,
-              GtkTextTag        *tag)
+find_unchecked_cb (gsize                   position,
+                   const CjhTextRegionRun *run,
+                   gpointer                user_data)
 {
-  GtkTextIter toggle_iter;
+  if (run->data == RUN_UNCHECKED)
+    {
+      gsize *pos = user_data;
+      *pos = position;
+      return TRUE;
+    }
 
-  if (tag == NULL)
-    return FALSE;
+  return FALSE;
+}
 
-  if (gtk_text_iter_has_tag (word_begin, tag))
-    return TRUE;
+static gboolean
+collect_unchecked_cb (gsize                   position,
+                      const CjhTextRegionRun *run,
+                      gpointer                user_data)
+{
+  GArray *unchecked = user_data;
 
-  toggle_iter = *word_begin;
-  if (!gtk_text_iter_forward_to_tag_toggle (&toggle_iter, tag))
-    return FALSE;
+  if (run->data == RUN_UNCHECKED)
+    {
+      Interval *last = unchecked->len ? &g_array_index (unchecked, Interval, unchecked->len - 1) : NULL;
+
+      if (last != NULL && last->end == position)
+        {
+          last->end += run->length;
+        }
+      else
+        {
+          Interval interval = { position, position + run->length };
+          g_array_append_val (unchecked, interval);
+        }
+    }
 
-  return gtk_text_iter_compare (word_end, &toggle_iter) > 0;
+  return FALSE;
 }
 
-gboolean
-editor_spell_cursor_next (EditorSpellCursor *self,
-                          GtkTextIter       *word_begin,
-                          GtkTextIter       *word_end)
+static void
+editor_spell_cursor_add_ranges (EditorSpellCursor *self,
+                                const GArray      *unchecked,
+                                guint             *first,
+                                guint              span_begin,
+                                guint              span_end)
 {
-  /* Try to advance skipping any checked region in the buffer */
-  if (!region_iter_next (&self->region, word_end))
+  while (*first < unchecked->len &&
+         g_array_index (unchecked, Interval, *first).end <= span_begin)
+    (*first)++;
+
+  /* The last interval may continue into the next span */
+  for (guint i = *first; i < unchecked->len; i++)
     {
-      *word_begin = *word_end;
-      return FALSE;
+      const Interval *interval = &g_array_index (unchecked, Interval, i);
+      CheckableRange range;
+
+      if (interval->begin >= span_end)
+        break;
+
+      range.begin = MAX (interval->begin, span_begin);
+      range.end = MIN (interval->end, span_end);
+      range.span_begin = span_begin;
+      range.span_end = span_end;
+
+      g_array_append_val (self->ranges, range);
     }
+}
 
-  /* Pass that position to the next iter, so it can skip
-   * past anything that is already checked. Then try to move
-   * forward so that we can skip past regions in the text
-   * buffer that are to be ignored by spellcheck.
-   */
-  tag_iter_seek (&self->tag, word_end);
-  if (!tag_iter_next (&self->tag, word_end))
+/* Loads the ranges for the next window of the buffer containing
+ * unchecked text. Returns %FALSE if there is none left.
+ */
+static gboolean
+editor_spell_cursor_load_window (EditorSpellCursor *self)
+{
+  g_autoptr(GArray) unchecked = NULL;
+  GtkTextTag *tag = self->no_spell_check_tag;
+  GtkTextIter iter;
+  gsize length;
+  gsize begin;
+  gsize end;
+  guint first = 0;
+  guint span_begin;
+
+  g_array_set_size (self->ranges, 0);
+  self->range_index = 0;
+
+  length = _cjh_text_region_get_length (self->region);
+  begin = MAX (self->window_end, self->pos);
+  if (begin >= length)
+    return FALSE;
+
+  end = G_MAXSIZE;
+  _cjh_text_region_foreach_in_range (self->region, begin, length, find_unchecked_cb, &end);
+  if (end == G_MAXSIZE)
+    return FALSE;
+
+  begin = MAX (begin, end);
+  end = MIN (length, begin + WINDOW_CHARS);
+  self->window_end = end;
+
+  unchecked = g_array_new (FALSE, FALSE, sizeof (Interval));
+  _cjh_text_region_foreach_in_range (self->region, begin, end, collect_unchecked_cb, unchecked);
+  g_assert (unchecked->len > 0);
+  g_array_index (unchecked, Interval, 0).begin = begin;
+  g_array_index (unchecked, Interval, unchecked->len - 1).end =
+    MIN (g_array_index (unchecked, Interval, unchecked->len - 1).end, end);
+
+  if (tag == NULL)
     {
-      *word_begin = *word_end;
-      return FALSE;
+      editor_spell_cursor_add_ranges (self, unchecked, &first, 0, G_MAXUINT);
+      return TRUE;
     }
 
-  /* Now pass that information to the word iter, so that it can
-   * jump forward to the next word starting from our tag/region
-   * positions.
+  /* Find where the untagged text containing @begin starts so that
+   * words crossing the window edge are not mistaken for tagged ones.
    */
-  word_iter_seek (&self->word, word_end);
-  if (!word_iter_next (&self->word, word_begin, word_end, self->extra_word_chars))
-    return FALSE;
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &iter, begin);
+  if (gtk_text_iter_has_tag (&iter, tag))
+    {
+      gtk_text_iter_forward_to_tag_toggle (&iter, tag);
+      span_begin = gtk_text_iter_get_offset (&iter);
+    }
+  else if (gtk_text_iter_ends_tag (&iter, tag))
+    {
+      span_begin = begin;
+    }
+  else
+    {
+      GtkTextIter toggle = iter;
 
-  /* Now pass our new position to the region so that it will
-   * skip past the word when advancing.
-   */
-  region_iter_seek (&self->region, word_end);
+      if (gtk_text_iter_backward_to_tag_toggle (&toggle, tag))
+        span_begin = gtk_text_iter_get_offset (&toggle);
+      else
+        span_begin = 0;
+    }
 
-  /* If this word contains the no-spell-check tag, then try
-   * again to skip past even more content.
+  /* Now walk the toggles once, intersecting each untagged span with
+   * the unchecked intervals as we go.
    */
-  if (contains_tag (word_begin, word_end, self->tag.tag))
-    return editor_spell_cursor_next (self, word_begin, word_end);
+  while (gtk_text_iter_get_offset (&iter) < end)
+    {
+      guint span_end;
+
+      gtk_text_iter_forward_to_tag_toggle (&iter, tag);
+      span_end = gtk_text_iter_get_offset (&iter);
+
+      editor_spell_cursor_add_ranges (self, unchecked, &first, span_begin, span_end);
+
+      /* Skip past the tagged text */
+      gtk_text_iter_forward_to_tag_toggle (&iter, tag);
+      span_begin = gtk_text_iter_get_offset (&iter);
+    }
 
   return TRUE;
 }
+
+gboolean
+editor_spell_cursor_next (EditorSpellCursor *self,
+                          GtkTextIter       *word_begin,
+                          GtkTextIter       *word_end)
+{
+  for (;;)
+    {
+      const CheckableRange *range;
+      guint begin;
+      guint end;
+      guint pos;
+
+      if (self->range_index >= self->ranges->len)
+        {
+          if (!editor_spell_cursor_load_window (self))
+            break;
+          continue;
+        }
+
+      range = &g_array_index (self->ranges, CheckableRange, self->range_index);
+      pos = MAX (self->pos, range->begin);
+
+      if (pos >= range->end)
+        {
+          self->range_index++;
+          continue;
+        }
+
+      gtk_text_buffer_get_iter_at_offset (self->buffer, word_end, pos);
+      word_iter_seek (&self->word, word_end);
+      if (!word_iter_next (&self->word, word_begin, word_end, self->extra_word_chars))
+        break;
+
+      begin = gtk_text_iter_get_offset (word_begin);
+      end = gtk_text_iter_get_offset (word_end);
+
+      /* If the word starts after this range, it can only belong to
+       * one of the ranges that follow.
+       */
+      if (begin >= range->end)
+        {
+          self->pos = begin;
+          self->range_index++;
+          continue;
+        }
+
+      /* Skip past the word when advancing */
+      self->pos = end + 1;
+
+      /* Ignore words partially covered by the no-spell-check tag */
+      if (begin < range->span_begin || end > range->span_end)
+        continue;
+
+      return TRUE;
+    }
+
+  gtk_text_buffer_get_end_iter (self->buffer, word_end);
+  *word_begin = *word_end;
+
+  return FALSE;
+}
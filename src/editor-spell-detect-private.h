@@ -0,0 +1,47 @@
+/* editor-spell-detect-private.h
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include "editor-types.h"
+
+G_BEGIN_DECLS
+
+#define EDITOR_SPELL_DETECT_UNKNOWN G_MAXUINT
+
+typedef struct
+{
+  guint offset;
+  guint length;
+  guint language;
+} EditorSpellDetectRun;
+
+guint   _editor_spell_detect         (GPtrArray            *languages,
+                                      const char           *text,
+                                      gssize                text_len);
+void    _editor_spell_detect_async   (GPtrArray            *languages,
+                                      char                 *text,
+                                      GCancellable         *cancellable,
+                                      GAsyncReadyCallback   callback,
+                                      gpointer              user_data);
+GArray *_editor_spell_detect_finish  (GAsyncResult         *result,
+                                      GError              **error);
+
+G_END_DECLS
@@ -0,0 +1,298 @@
+/* editor-spell-detect.c
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "editor-spell-detect"
+
+#include "config.h"
+
+#include <string.h>
+
+#include "editor-spell-detect-private.h"
+#include "editor-spell-language.h"
+
+/*
+ * Documents mixing languages are split into paragraphs, and each one is
+ * assigned the dictionary that recognizes most of a sample of its words.
+ * That is a crude form of language detection, but it only has to choose
+ * between the few dictionaries the user asked for and the lookups are
+ * answered by the per-language verdict tables when checking afterwards.
+ */
+
+#define MAX_SAMPLE_WORDS    64
+#define MIN_SAMPLE_WORDS    3
+#define MAX_PARAGRAPH_CHARS 4096
+
+typedef struct
+{
+  GPtrArray *languages;
+  char      *text;
+} DetectOp;
+
+static void
+detect_op_free (DetectOp *op)
+{
+  g_clear_pointer (&op->languages, g_ptr_array_unref);
+  g_clear_pointer (&op->text, g_free);
+  g_slice_free (DetectOp, op);
+}
+
+static inline gboolean
+is_apostrophe (gunichar ch)
+{
+  return ch == '\'' || ch == 0x2019;
+}
+
+/**
+ * _editor_spell_detect:
+ * @languages: (element-type EditorSpellLanguage): candidate languages,
+ *   the first being the default. Entries may be %NULL while loading.
+ * @text: the text of a paragraph
+ * @text_len: the length of @text in bytes, or -1
+ *
+ * Guesses which of @languages @text is written in. Anything but the
+ * default language must recognize at least half of the sampled words.
+ *
+ * This is safe to call from a thread.
+ *
+ * Returns: an index within @languages, or %EDITOR_SPELL_DETECT_UNKNOWN
+ *   if @text does not have enough words to tell.
+ */
+guint
+_editor_spell_detect (GPtrArray  *languages,
+                      const char *text,
+                      gssize      text_len)
+{
+  const char *end;
+  const char *iter;
+  guint *hits;
+  guint n_words = 0;
+  guint best = 0;
+
+  g_return_val_if_fail (languages != NULL, EDITOR_SPELL_DETECT_UNKNOWN);
+  g_return_val_if_fail (languages->len > 0, EDITOR_SPELL_DETECT_UNKNOWN);
+  g_return_val_if_fail (text != NULL, EDITOR_SPELL_DETECT_UNKNOWN);
+
+  if (text_len < 0)
+    text_len = strlen (text);
+
+  hits = g_newa (guint, languages->len);
+  memset (hits, 0, sizeof *hits * languages->len);
+
+  end = text + text_len;
+  iter = text;
+
+  while (iter < end && n_words < MAX_SAMPLE_WORDS)
+    {
+      const char *word_begin;
+      const char *word_end;
+      guint n_chars = 0;
+
+      if (!g_unichar_isalpha (g_utf8_get_char (iter)))
+        {
+          iter = g_utf8_next_char (iter);
+          continue;
+        }
+
+      word_begin = iter;
+      word_end = iter;
+
+      /* Letters, possibly joined by apostrophes as in "don't" */
+      while (iter < end)
+        {
+          gunichar ch = g_utf8_get_char (iter);
+
+          if (g_unichar_isalpha (ch))
+            {
+              iter = g_utf8_next_char (iter);
+              word_end = iter;
+              n_chars++;
+            }
+          else if (is_apostrophe (ch) && word_end == iter)
+            iter = g_utf8_next_char (iter);
+          else
+            break;
+        }
+
+      if (n_chars < 2)
+        continue;
+
+      n_words++;
+
+      for (guint i = 0; i < languages->len; i++)
+        {
+          EditorSpellLanguage *language = g_ptr_array_index (languages, i);
+
+          if (language != NULL &&
+              editor_spell_language_contains_word (language, word_begin, word_end - word_begin))
+            hits[i]++;
+        }
+    }
+
+  if (n_words < MIN_SAMPLE_WORDS)
+    return EDITOR_SPELL_DETECT_UNKNOWN;
+
+  for (guint i = 1; i < languages->len; i++)
+    {
+      if (hits[i] > hits[best])
+        best = i;
+    }
+
+  /* Mostly unrecognized text, such as code, gains nothing from switching */
+  if (best != 0 && hits[best] * 2 < n_words)
+    return 0;
+
+  return best;
+}
+
+static inline gboolean
+line_is_blank (const char *line,
+               const char *line_end)
+{
+  for (const char *c = line; c < line_end; c++)
+    {
+      if (*c != ' ' && *c != '\t' && *c != '\r')
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+editor_spell_detect_worker (GTask        *task,
+                            gpointer      source_object,
+                            gpointer      task_data,
+                            GCancellable *cancellable)
+{
+  DetectOp *op = task_data;
+  const char *paragraph;
+  const char *line;
+  GArray *ret;
+  guint paragraph_offset = 0;
+  guint paragraph_chars = 0;
+  gboolean has_text = FALSE;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (op != NULL);
+
+  ret = g_array_new (FALSE, FALSE, sizeof (EditorSpellDetectRun));
+  paragraph = op->text;
+  line = op->text;
+
+  /* Paragraphs end after blank lines so that the blank lines themselves
+   * are covered too. Huge paragraphs are split at line ends.
+   */
+  for (;;)
+    {
+      const char *line_end = strchr (line, '\n');
+      const char *next;
+      gboolean blank;
+
+      if (line_end == NULL)
+        line_end = line + strlen (line);
+
+      next = *line_end ? line_end + 1 : line_end;
+      blank = line_is_blank (line, line_end);
+      paragraph_chars += g_utf8_strlen (line, next - line);
+      has_text |= !blank;
+
+      if (*next == 0 ||
+          (blank && has_text) ||
+          paragraph_chars >= MAX_PARAGRAPH_CHARS)
+        {
+          EditorSpellDetectRun run;
+
+          run.offset = paragraph_offset;
+          run.length = paragraph_chars;
+          run.language = _editor_spell_detect (op->languages, paragraph, next - paragraph);
+          g_array_append_val (ret, run);
+
+          paragraph_offset += paragraph_chars;
+          paragraph_chars = 0;
+          paragraph = next;
+          has_text = FALSE;
+
+          if (g_cancellable_is_cancelled (cancellable))
+            break;
+        }
+
+      if (*next == 0)
+        break;
+
+      line = next;
+    }
+
+  if (g_task_return_error_if_cancelled (task))
+    g_array_unref (ret);
+  else
+    g_task_return_pointer (task, ret, (GDestroyNotify)g_array_unref);
+}
+
+/**
+ * _editor_spell_detect_async:
+ * @languages: (element-type EditorSpellLanguage): candidate languages as
+ *   accepted by _editor_spell_detect()
+ * @text: (transfer full): the text to split into paragraphs
+ * @cancellable: (nullable): a #GCancellable or %NULL
+ * @callback: a #GAsyncReadyCallback
+ * @user_data: closure data for @callback
+ *
+ * Splits @text into paragraphs and detects the language of each of
+ * them on a thread.
+ */
+void
+_editor_spell_detect_async (GPtrArray           *languages,
+                            char                *text,
+                            GCancellable        *cancellable,
+                            GAsyncReadyCallback  callback,
+                            gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+  DetectOp *op;
+
+  g_return_if_fail (languages != NULL);
+  g_return_if_fail (text != NULL);
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  op = g_slice_new0 (DetectOp);
+  op->languages = g_ptr_array_ref (languages);
+  op->text = text;
+
+  task = g_task_new (NULL, cancellable, callback, user_data);
+  g_task_set_source_tag (task, _editor_spell_detect_async);
+  g_task_set_task_data (task, op, (GDestroyNotify)detect_op_free);
+  g_task_run_in_thread (task, editor_spell_detect_worker);
+}
+
+/**
+ * _editor_spell_detect_finish:
+ * @result: a #GAsyncResult provided to callback
+ * @error: a location for a #GError, or %NULL
+ *
+ * Returns: (transfer full): a #GArray of #EditorSpellDetectRun covering
+ *   all of the text in order, with character offsets relative to it.
+ */
+GArray *
+_editor_spell_detect_finish (GAsyncResult  *result,
+                             GError       **error)
+{
+  g_return_val_if_fail (G_IS_TASK (result), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
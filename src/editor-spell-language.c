@@ -22,11 +22,33 @@
 
 #include <string.h>
 
-#include "editor-spell-language.h"
+#include "editor-spell-language-private.h"
+
+#define MAX_CACHED_VERDICTS 50000
+
+enum {
+  VERDICT_UNKNOWN,
+  VERDICT_CORRECT,
+  VERDICT_MISSPELLED,
+};
 
 typedef struct
 {
-  const char *code;
+  const char   *code;
+
+  /* Providers share one instance per language with every checker, so
+   * remembering verdicts here means each distinct word is only looked
+   * up in the dictionary once per session. Words are copied into the
+   * @words arena rather than allocated individually.
+   *
+   * Words are added and ignored while lookups may be in flight on other
+   * threads, so those bump @generation and verdicts computed under an
+   * older generation are dropped rather than overwrite theirs.
+   */
+  GMutex        verdicts_mutex;
+  GHashTable   *verdicts;
+  GStringChunk *words;
+  guint         generation;
 } EditorSpellLanguagePrivate;
 
 G_DEFINE_ABSTRACT_TYPE_WITH_PRIVATE (EditorSpellLanguage, editor_spell_language, G_TYPE_OBJECT)
@@ -39,6 +61,19 @@ enum {
 
 static GParamSpec *properties [N_PROPS];
 
+static void
+editor_spell_language_finalize (GObject *object)
+{
+  EditorSpellLanguage *self = (EditorSpellLanguage *)object;
+  EditorSpellLanguagePrivate *priv = editor_spell_language_get_instance_private (self);
+
+  g_clear_pointer (&priv->verdicts, g_hash_table_unref);
+  g_clear_pointer (&priv->words, g_string_chunk_free);
+  g_mutex_clear (&priv->verdicts_mutex);
+
+  G_OBJECT_CLASS (editor_spell_language_parent_class)->finalize (object);
+}
+
 static void
 editor_spell_language_get_property (GObject    *object,
                                     guint       prop_id,
@@ -83,6 +118,7 @@ editor_spell_language_class_init (EditorSpellLanguageClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
+  object_class->finalize = editor_spell_language_finalize;
   object_class->get_property = editor_spell_language_get_property;
   object_class->set_property = editor_spell_language_set_property;
 
@@ -99,6 +135,78 @@ editor_spell_language_class_init (EditorSpellLanguageClass *klass)
 static void
 editor_spell_language_init (EditorSpellLanguage *self)
 {
+  EditorSpellLanguagePrivate *priv = editor_spell_language_get_instance_private (self);
+
+  g_mutex_init (&priv->verdicts_mutex);
+  priv->verdicts = g_hash_table_new (g_str_hash, g_str_equal);
+  priv->words = g_string_chunk_new (4096);
+}
+
+static guint
+editor_spell_language_lookup_verdict (EditorSpellLanguage *self,
+                                      const char          *word,
+                                      guint               *generation)
+{
+  EditorSpellLanguagePrivate *priv = editor_spell_language_get_instance_private (self);
+  guint verdict;
+
+  g_mutex_lock (&priv->verdicts_mutex);
+  verdict = GPOINTER_TO_UINT (g_hash_table_lookup (priv->verdicts, word));
+  *generation = priv->generation;
+  g_mutex_unlock (&priv->verdicts_mutex);
+
+  return verdict;
+}
+
+static void
+editor_spell_language_insert_verdict_locked (EditorSpellLanguage *self,
+                                             const char          *word,
+                                             gsize                word_len,
+                                             guint                verdict)
+{
+  EditorSpellLanguagePrivate *priv = editor_spell_language_get_instance_private (self);
+  gpointer key;
+
+  if (!g_hash_table_lookup_extended (priv->verdicts, word, &key, NULL))
+    {
+      /* Start over rather than grow without bounds on odd input */
+      if (g_hash_table_size (priv->verdicts) >= MAX_CACHED_VERDICTS)
+        {
+          g_hash_table_remove_all (priv->verdicts);
+          g_string_chunk_clear (priv->words);
+        }
+
+      key = g_string_chunk_insert_len (priv->words, word, word_len);
+    }
+
+  g_hash_table_insert (priv->verdicts, key, GUINT_TO_POINTER (verdict));
+}
+
+static void
+editor_spell_language_set_verdict (EditorSpellLanguage *self,
+                                   const char          *word,
+                                   gsize                word_len,
+                                   guint                verdict,
+                                   guint                generation)
+{
+  EditorSpellLanguagePrivate *priv = editor_spell_language_get_instance_private (self);
+
+  g_mutex_lock (&priv->verdicts_mutex);
+  if (generation == priv->generation)
+    editor_spell_language_insert_verdict_locked (self, word, word_len, verdict);
+  g_mutex_unlock (&priv->verdicts_mutex);
+}
+
+static void
+editor_spell_language_set_correct (EditorSpellLanguage *self,
+                                   const char          *word)
+{
+  EditorSpellLanguagePrivate *priv = editor_spell_language_get_instance_private (self);
+
+  g_mutex_lock (&priv->verdicts_mutex);
+  priv->generation++;
+  editor_spell_language_insert_verdict_locked (self, word, strlen (word), VERDICT_CORRECT);
+  g_mutex_unlock (&priv->verdicts_mutex);
 }
 
 const char *
@@ -111,18 +219,63 @@ editor_spell_language_get_code (EditorSpellLanguage *self)
   return priv->code;
 }
 
+/**
+ * _editor_spell_language_contains_word:
+ * @self: an #EditorSpellLanguage
+ * @word: the word to check
+ * @word_len: the length of @word, or -1 if it is terminated
+ * @cached: (out) (optional): whether the verdict table answered
+ *
+ * Like editor_spell_language_contains_word() but also tells whether
+ * the language had to be asked, so that callers on the main thread can
+ * keep track of how useful the verdict table is.
+ *
+ * Returns: %TRUE if @word is spelled correctly
+ */
 gboolean
-editor_spell_language_contains_word (EditorSpellLanguage *self,
-                                     const char          *word,
-                                     gssize               word_len)
+_editor_spell_language_contains_word (EditorSpellLanguage *self,
+                                      const char          *word,
+                                      gssize               word_len,
+                                      gboolean            *cached)
 {
+  g_autofree char *copy = NULL;
+  gboolean ret;
+  guint generation;
+  guint verdict;
+
   g_return_val_if_fail (EDITOR_IS_SPELL_LANGUAGE (self), FALSE);
   g_return_val_if_fail (word != NULL, FALSE);
 
   if (word_len < 0)
     word_len = strlen (word);
+  else if (word[word_len] != 0)
+    word = copy = g_strndup (word, word_len);
+
+  if ((verdict = editor_spell_language_lookup_verdict (self, word, &generation)) != VERDICT_UNKNOWN)
+    {
+      if (cached != NULL)
+        *cached = TRUE;
+      return verdict == VERDICT_CORRECT;
+    }
+
+  if (cached != NULL)
+    *cached = FALSE;
+
+  ret = EDITOR_SPELL_LANGUAGE_GET_CLASS (self)->contains_word (self, word, word_len);
 
-  return EDITOR_SPELL_LANGUAGE_GET_CLASS (self)->contains_word (self, word, word_len);
+  editor_spell_language_set_verdict (self, word, word_len,
+                                     ret ? VERDICT_CORRECT : VERDICT_MISSPELLED,
+                                     generation);
+
+  return ret;
+}
+
+gboolean
+editor_spell_language_contains_word (EditorSpellLanguage *self,
+                                     const char          *word,
+                                     gssize               word_len)
+{
+  return _editor_spell_language_contains_word (self, word, word_len, NULL);
 }
 
 char **
@@ -151,7 +304,10 @@ editor_spell_language_add_word (EditorSpellLanguage *self,
   g_return_if_fail (word != NULL);
 
   if (EDITOR_SPELL_LANGUAGE_GET_CLASS (self)->add_word)
-    EDITOR_SPELL_LANGUAGE_GET_CLASS (self)->add_word (self, word);
+    {
+      EDITOR_SPELL_LANGUAGE_GET_CLASS (self)->add_word (self, word);
+      editor_spell_language_set_correct (self, word);
+    }
 }
 
 void
@@ -162,7 +318,10 @@ editor_spell_language_ignore_word (EditorSpellLanguage *self,
   g_return_if_fail (word != NULL);
 
   if (EDITOR_SPELL_LANGUAGE_GET_CLASS (self)->ignore_word)
-    EDITOR_SPELL_LANGUAGE_GET_CLASS (self)->ignore_word (self, word);
+    {
+      EDITOR_SPELL_LANGUAGE_GET_CLASS (self)->ignore_word (self, word);
+      editor_spell_language_set_correct (self, word);
+    }
 }
 
 const char *
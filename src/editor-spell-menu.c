@@ -139,7 +139,10 @@ editor_spell_corrections_set (EditorSpellCorrections *self,
   if (corrections == (const char * const *)self->corrections)
     return;
 
-  if (g_strcmp0 (word, self->word) == 0)
+  /* Corrections for the same word may arrive after the word itself */
+  if (g_strcmp0 (word, self->word) == 0 &&
+      (corrections == NULL) == (self->corrections == NULL) &&
+      (corrections == NULL || g_strv_equal (corrections, (const char * const *)self->corrections)))
     return;
 
   if (self->corrections != NULL)
@@ -162,12 +165,18 @@ editor_spell_corrections_new (void)
 }
 
 static void
-populate_languages (GMenu *menu)
+populate_languages_cb (GObject      *object,
+                       GAsyncResult *result,
+                       gpointer      user_data)
 {
-  EditorSpellProvider *provider = editor_spell_provider_get_default ();
-  g_autoptr(GPtrArray) infos = editor_spell_provider_list_languages (provider);
+  EditorSpellProvider *provider = (EditorSpellProvider *)object;
+  g_autoptr(GMenu) menu = user_data;
+  g_autoptr(GPtrArray) infos = NULL;
+
+  g_assert (EDITOR_IS_SPELL_PROVIDER (provider));
+  g_assert (G_IS_MENU (menu));
 
-  if (infos == NULL)
+  if (!(infos = editor_spell_provider_list_languages_finish (provider, result, NULL)))
     return;
 
   for (guint i = 0; i < infos->len; i++)
@@ -182,6 +191,16 @@ populate_languages (GMenu *menu)
     }
 }
 
+static void
+populate_languages (GMenu *menu)
+{
+  /* Enumerating dictionaries can be slow the first time */
+  editor_spell_provider_list_languages_async (editor_spell_provider_get_default (),
+                                              NULL,
+                                              populate_languages_cb,
+                                              g_object_ref (menu));
+}
+
 GMenuModel *
 editor_spell_menu_new (void)
 {
@@ -0,0 +1,57 @@
+/* editor-spell-metrics-private.h
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Process-wide spellcheck counters. They are only updated from the main
+ * thread, without locking. Lookups from worker threads, such as those
+ * made to detect the language of a paragraph, are not counted.
+ */
+typedef struct
+{
+  /* Words passed to editor_spell_checker_check_word() */
+  guint64 n_words;
+
+  /* Words from editor_spell_checker_check_word() answered by the
+   * per-language verdict table, or not
+   */
+  guint64 n_cache_hits;
+  guint64 n_cache_misses;
+
+  /* Scheduler slices run by EditorTextBufferSpellAdapter */
+  guint64 n_slices;
+  guint64 n_slices_over_deadline;
+  guint64 n_slice_words;
+  gint64  slice_usec_total;
+  gint64  slice_usec_max;
+
+  /* Unchecked characters across all buffers */
+  gint64  backlog;
+} EditorSpellMetrics;
+
+extern EditorSpellMetrics _editor_spell_metrics;
+
+GVariant *_editor_spell_metrics_to_variant (void);
+
+G_END_DECLS
@@ -0,0 +1,60 @@
+/* editor-spell-metrics.c
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "config.h"
+
+#include "editor-spell-metrics-private.h"
+
+EditorSpellMetrics _editor_spell_metrics;
+
+/**
+ * _editor_spell_metrics_to_variant:
+ *
+ * Creates a snapshot of the spellcheck counters along with the rates
+ * derived from them, suitable for the "spell-metrics" action state.
+ *
+ * Returns: (transfer floating): a #GVariant of type "a{sv}"
+ */
+GVariant *
+_editor_spell_metrics_to_variant (void)
+{
+  const EditorSpellMetrics *m = &_editor_spell_metrics;
+  guint64 n_lookups = m->n_cache_hits + m->n_cache_misses;
+  GVariantDict dict;
+
+  g_variant_dict_init (&dict, NULL);
+
+  g_variant_dict_insert (&dict, "words", "t", m->n_words);
+  g_variant_dict_insert (&dict, "cache-hits", "t", m->n_cache_hits);
+  g_variant_dict_insert (&dict, "cache-misses", "t", m->n_cache_misses);
+  g_variant_dict_insert (&dict, "cache-hit-rate", "d",
+                         n_lookups ? m->n_cache_hits / (double)n_lookups : 0.0);
+  g_variant_dict_insert (&dict, "slices", "t", m->n_slices);
+  g_variant_dict_insert (&dict, "slices-over-deadline", "t", m->n_slices_over_deadline);
+  g_variant_dict_insert (&dict, "slice-usec-total", "x", m->slice_usec_total);
+  g_variant_dict_insert (&dict, "slice-usec-max", "x", m->slice_usec_max);
+  g_variant_dict_insert (&dict, "slice-usec-mean", "d",
+                         m->n_slices ? m->slice_usec_total / (double)m->n_slices : 0.0);
+  g_variant_dict_insert (&dict, "words-per-second", "d",
+                         m->slice_usec_total ? m->n_slice_words * (double)G_USEC_PER_SEC / m->slice_usec_total : 0.0);
+  g_variant_dict_insert (&dict, "backlog", "x", m->backlog);
+
+  return g_variant_dict_end (&dict);
+}
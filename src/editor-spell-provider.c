@@ -22,6 +22,7 @@
 
 #include "editor-spell-provider.h"
 
+#include "dict/editor-dict-spell-provider.h"
 #include "enchant/editor-enchant-spell-provider.h"
 
 typedef struct
@@ -138,7 +139,10 @@ editor_spell_provider_get_default (void)
 
   if (instance == NULL)
     {
-      instance = editor_enchant_spell_provider_new ();
+      g_autoptr(EditorSpellProvider) enchant = editor_enchant_spell_provider_new ();
+
+      /* Enchant remains in charge of corrections and unknown words */
+      instance = editor_dict_spell_provider_new (enchant);
       g_set_weak_pointer (&instance, instance);
     }
 
@@ -239,3 +243,163 @@ editor_spell_provider_get_default_code (EditorSpellProvider *self)
 
   return NULL;
 }
+
+static void
+editor_spell_provider_load_language_worker (GTask        *task,
+                                            gpointer      source_object,
+                                            gpointer      task_data,
+                                            GCancellable *cancellable)
+{
+  EditorSpellProvider *self = source_object;
+  const char *code = task_data;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (EDITOR_IS_SPELL_PROVIDER (self));
+
+  if (code == NULL)
+    code = editor_spell_provider_get_default_code (self);
+
+  if (code == NULL)
+    g_task_return_pointer (task, NULL, NULL);
+  else
+    g_task_return_pointer (task,
+                           editor_spell_provider_get_language (self, code),
+                           g_object_unref);
+}
+
+/**
+ * editor_spell_provider_load_language_async:
+ * @self: an #EditorSpellProvider
+ * @language: (nullable): the language to load such as `en_US`, or %NULL
+ *   for the default language
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: (nullable): a #GAsyncReadyCallback
+ * @user_data: closure data for @callback
+ *
+ * Loads @language on a worker thread. Loading a dictionary for the first
+ * time can take a long time, so this should be preferred over
+ * editor_spell_provider_get_language() from the main thread.
+ *
+ * Providers must support #EditorSpellProviderClass.get_language() and
+ * #EditorSpellProviderClass.supports_language() from a worker thread.
+ */
+void
+editor_spell_provider_load_language_async (EditorSpellProvider *self,
+                                           const char          *language,
+                                           GCancellable        *cancellable,
+                                           GAsyncReadyCallback  callback,
+                                           gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+
+  g_return_if_fail (EDITOR_IS_SPELL_PROVIDER (self));
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, editor_spell_provider_load_language_async);
+  g_task_set_task_data (task, g_strdup (language), g_free);
+  g_task_run_in_thread (task, editor_spell_provider_load_language_worker);
+}
+
+/**
+ * editor_spell_provider_load_language_finish:
+ * @self: an #EditorSpellProvider
+ * @result: a #GAsyncResult
+ * @error: a location for a #GError
+ *
+ * Completes a request to editor_spell_provider_load_language_async().
+ *
+ * Returns: (transfer full) (nullable): an #EditorSpellLanguage or %NULL
+ *   if the language is not supported.
+ */
+EditorSpellLanguage *
+editor_spell_provider_load_language_finish (EditorSpellProvider  *self,
+                                            GAsyncResult         *result,
+                                            GError              **error)
+{
+  g_return_val_if_fail (EDITOR_IS_SPELL_PROVIDER (self), NULL);
+  g_return_val_if_fail (G_IS_TASK (result), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+static void
+editor_spell_provider_list_languages_worker (GTask        *task,
+                                             gpointer      source_object,
+                                             gpointer      task_data,
+                                             GCancellable *cancellable)
+{
+  EditorSpellProvider *self = source_object;
+
+  g_assert (G_IS_TASK (task));
+  g_assert (EDITOR_IS_SPELL_PROVIDER (self));
+
+  g_task_return_pointer (task,
+                         editor_spell_provider_list_languages (self),
+                         (GDestroyNotify)g_ptr_array_unref);
+}
+
+/**
+ * editor_spell_provider_list_languages_async:
+ * @self: an #EditorSpellProvider
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: (nullable): a #GAsyncReadyCallback
+ * @user_data: closure data for @callback
+ *
+ * Lists the supported languages on a worker thread, as enumerating the
+ * installed dictionaries may be slow the first time.
+ */
+void
+editor_spell_provider_list_languages_async (EditorSpellProvider *self,
+                                            GCancellable        *cancellable,
+                                            GAsyncReadyCallback  callback,
+                                            gpointer             user_data)
+{
+  g_autoptr(GTask) task = NULL;
+
+  g_return_if_fail (EDITOR_IS_SPELL_PROVIDER (self));
+  g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, editor_spell_provider_list_languages_async);
+  g_task_run_in_thread (task, editor_spell_provider_list_languages_worker);
+}
+
+/**
+ * editor_spell_provider_list_languages_finish:
+ * @self: an #EditorSpellProvider
+ * @result: a #GAsyncResult
+ * @error: a location for a #GError
+ *
+ * Completes a request to editor_spell_provider_list_languages_async().
+ *
+ * Returns: (transfer container) (element-type EditorSpellLanguageInfo): an
+ *   array of #EditorSpellLanguageInfo.
+ */
+GPtrArray *
+editor_spell_provider_list_languages_finish (EditorSpellProvider  *self,
+                                             GAsyncResult         *result,
+                                             GError              **error)
+{
+  g_return_val_if_fail (EDITOR_IS_SPELL_PROVIDER (self), NULL);
+  g_return_val_if_fail (G_IS_TASK (result), NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+/**
+ * editor_spell_provider_preload:
+ * @self: an #EditorSpellProvider
+ *
+ * Loads the default language and the list of languages on worker threads
+ * so that they are ready by the time the first document is checked or
+ * the language menu is first shown.
+ */
+void
+editor_spell_provider_preload (EditorSpellProvider *self)
+{
+  g_return_if_fail (EDITOR_IS_SPELL_PROVIDER (self));
+
+  editor_spell_provider_load_language_async (self, NULL, NULL, NULL, NULL);
+  editor_spell_provider_list_languages_async (self, NULL, NULL, NULL);
+}
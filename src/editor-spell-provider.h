@@ -43,13 +43,29 @@ struct _EditorSpellProviderClass
   gpointer _reserved[8];
 };
 
-EditorSpellProvider *editor_spell_provider_get_default       (void);
-const char          *editor_spell_provider_get_default_code  (EditorSpellProvider *self);
-const char          *editor_spell_provider_get_display_name  (EditorSpellProvider *self);
-gboolean             editor_spell_provider_supports_language (EditorSpellProvider *self,
-                                                              const char          *language);
-GPtrArray           *editor_spell_provider_list_languages    (EditorSpellProvider *self);
-EditorSpellLanguage *editor_spell_provider_get_language      (EditorSpellProvider *self,
-                                                              const char          *language);
+EditorSpellProvider *editor_spell_provider_get_default           (void);
+const char          *editor_spell_provider_get_default_code      (EditorSpellProvider  *self);
+const char          *editor_spell_provider_get_display_name      (EditorSpellProvider  *self);
+gboolean             editor_spell_provider_supports_language     (EditorSpellProvider  *self,
+                                                                  const char           *language);
+GPtrArray           *editor_spell_provider_list_languages        (EditorSpellProvider  *self);
+EditorSpellLanguage *editor_spell_provider_get_language          (EditorSpellProvider  *self,
+                                                                  const char           *language);
+void                 editor_spell_provider_load_language_async   (EditorSpellProvider  *self,
+                                                                  const char           *language,
+                                                                  GCancellable         *cancellable,
+                                                                  GAsyncReadyCallback   callback,
+                                                                  gpointer              user_data);
+EditorSpellLanguage *editor_spell_provider_load_language_finish  (EditorSpellProvider  *self,
+                                                                  GAsyncResult         *result,
+                                                                  GError              **error);
+void                 editor_spell_provider_list_languages_async  (EditorSpellProvider  *self,
+                                                                  GCancellable         *cancellable,
+                                                                  GAsyncReadyCallback   callback,
+                                                                  gpointer              user_data);
+GPtrArray           *editor_spell_provider_list_languages_finish (EditorSpellProvider  *self,
+                                                                  GAsyncResult         *result,
+                                                                  GError              **error);
+void                 editor_spell_provider_preload               (EditorSpellProvider  *self);
 
 G_END_DECLS
@@ -23,10 +23,15 @@
 #include "cjhtextregionprivate.h"
 
 #include "editor-document.h"
-#include "editor-spell-checker.h"
+#include "editor-spell-cache-private.h"
+#include "editor-spell-checker-private.h"
 #include "editor-spell-cursor.h"
+#include "editor-spell-detect-private.h"
 #include "editor-spell-language.h"
+#include "editor-spell-metrics-private.h"
 #include "editor-text-buffer-spell-adapter.h"
+#include "editor-trace-private.h"
+#include "editor-utils-private.h"
 
 #define RUN_UNCHECKED      GSIZE_TO_POINTER(0)
 #define RUN_CHECKED        GSIZE_TO_POINTER(1)
@@ -38,6 +43,17 @@
  * to get removed/re-added on each repeat movement.
  */
 #define INVALIDATE_DELAY_MSECS 100
+/* Runs of the languages region are LANGUAGE_UNKNOWN until the paragraph
+ * has been detected. Then they hold the index of the checker, where zero
+ * is the document language, along with a bit set once the paragraph has
+ * changed and should be detected again.
+ */
+#define LANGUAGE_UNKNOWN           GSIZE_TO_POINTER(0)
+#define LANGUAGE_DATA(index,stale) GSIZE_TO_POINTER((((gsize)(index)+1)<<1)|((stale)?1:0))
+#define LANGUAGE_INDEX(data)       ((GPOINTER_TO_SIZE(data)>>1)-1)
+#define LANGUAGE_IS_STALE(data)    ((GPOINTER_TO_SIZE(data)&1)!=0)
+#define DETECT_WINDOW_CHARS        16384
+#define DETECT_LOOKBEHIND_LINES    32
 
 typedef struct
 {
@@ -51,6 +67,44 @@ typedef struct
   guint found : 1;
 } ScanForUnchecked;
 
+typedef struct
+{
+  guint begin;
+  guint end;
+} OffsetRange;
+
+/* Tag changes found during a slice. They are applied together once the
+ * slice is done so that words whose underline is already right cause no
+ * tag table changes or redraws at all.
+ */
+typedef struct
+{
+  GArray *unchecked;
+  GArray *apply;
+  GArray *remove;
+} TagUpdate;
+
+typedef struct
+{
+  GArray *ranges;
+  guint   begin;
+  guint   end;
+} CollectUnchecked;
+
+typedef struct
+{
+  gsize begin;
+  gsize end;
+  gsize count;
+} CountUnchecked;
+
+typedef struct
+{
+  guint    begin;
+  guint    end;
+  gpointer data;
+} LanguageRun;
+
 struct _EditorTextBufferSpellAdapter
 {
   GObject             parent_instance;
@@ -63,11 +117,44 @@ struct _EditorTextBufferSpellAdapter
 
   guint               cursor_position;
   guint               incoming_cursor_position;
-  guint               queued_cursor_moved;
+  GSource            *cursor_moved_source;
 
   gsize               update_source;
 
+  /* Slices since the backlog was last drained, traced as one mark */
+  gint64              pass_begin_time;
+  guint               pass_n_slices;
+  guint               pass_n_checked;
+
+  /* Paragraphs written in one of @extra_languages are checked with the
+   * matching entry of @extra_checkers. The language of each paragraph is
+   * detected on a thread and tracked in @languages, see LANGUAGE_DATA().
+   */
+  char              **extra_languages;
+  GPtrArray          *extra_checkers;
+  CjhTextRegion      *languages;
+  GCancellable       *detect_cancellable;
+  guint               detect_generation;
+  guint               detect_offset;
+
+  /* Unchecked characters in @region, kept up to date as it changes so
+   * that reporting it does not need to walk the region. See
+   * EditorSpellMetrics.
+   */
+  gsize               backlog;
+
+  /* Results of complete passes over unmodified buffers are cached so
+   * that reopening a document restores them instead of checking again.
+   * @generation changes with the buffer text so that a restore racing
+   * with an edit can be discarded.
+   */
+  GCancellable       *restore_cancellable;
+  guint               generation;
+  guint               restore_generation;
+  guint               saved_generation;
+
   guint               enabled : 1;
+  guint               restoring : 1;
 };
 
 G_DEFINE_TYPE (EditorTextBufferSpellAdapter, editor_text_buffer_spell_adapter, G_TYPE_OBJECT)
@@ -77,12 +164,15 @@ enum {
   PROP_BUFFER,
   PROP_CHECKER,
   PROP_ENABLED,
+  PROP_EXTRA_LANGUAGES,
   PROP_LANGUAGE,
   N_PROPS
 };
 
 static GParamSpec *properties [N_PROPS];
 
+static void editor_text_buffer_spell_adapter_queue_update (EditorTextBufferSpellAdapter *self);
+
 static inline gboolean
 forward_word_end (EditorTextBufferSpellAdapter *self,
                   GtkTextIter                  *iter)
@@ -99,6 +189,157 @@ backward_word_start (EditorTextBufferSpellAdapter *self,
                                                 editor_spell_checker_get_extra_word_chars (self->checker));
 }
 
+static inline gboolean
+has_extra_languages (EditorTextBufferSpellAdapter *self)
+{
+  return self->extra_checkers != NULL && self->extra_checkers->len > 0;
+}
+
+static gboolean
+join_language_cb (gsize                   offset,
+                  const CjhTextRegionRun *left,
+                  const CjhTextRegionRun *right)
+{
+  return left->data == right->data;
+}
+
+static gboolean
+get_language_run_cb (gsize                   offset,
+                     const CjhTextRegionRun *run,
+                     gpointer                user_data)
+{
+  LanguageRun *language_run = user_data;
+
+  language_run->begin = offset;
+  language_run->end = offset + run->length;
+  language_run->data = run->data;
+
+  return TRUE;
+}
+
+static void
+get_language_run (EditorTextBufferSpellAdapter *self,
+                  guint                         offset,
+                  LanguageRun                  *run)
+{
+  guint length = _cjh_text_region_get_length (self->languages);
+
+  run->begin = 0;
+  run->end = 0;
+  run->data = LANGUAGE_UNKNOWN;
+
+  if (length == 0)
+    return;
+
+  if (offset >= length)
+    offset = length - 1;
+
+  _cjh_text_region_foreach_in_range (self->languages, offset, offset + 1, get_language_run_cb, run);
+}
+
+static gboolean
+collect_language_runs_cb (gsize                   offset,
+                          const CjhTextRegionRun *run,
+                          gpointer                user_data)
+{
+  GArray *runs = user_data;
+  LanguageRun language_run = { offset, offset + run->length, run->data };
+
+  g_array_append_val (runs, language_run);
+
+  return FALSE;
+}
+
+static GArray *
+collect_language_runs (EditorTextBufferSpellAdapter *self,
+                       guint                         begin,
+                       guint                         end)
+{
+  GArray *runs = g_array_new (FALSE, FALSE, sizeof (LanguageRun));
+
+  _cjh_text_region_foreach_in_range (self->languages, begin, end, collect_language_runs_cb, runs);
+
+  /* Clamp to the requested range */
+  for (guint i = 0; i < runs->len; i++)
+    {
+      LanguageRun *run = &g_array_index (runs, LanguageRun, i);
+
+      run->begin = MAX (run->begin, begin);
+      run->end = MIN (run->end, end);
+    }
+
+  return runs;
+}
+
+static EditorSpellChecker *
+get_checker_for_language (EditorTextBufferSpellAdapter *self,
+                          gpointer                      data)
+{
+  gsize index;
+
+  if (data == LANGUAGE_UNKNOWN || !has_extra_languages (self))
+    return self->checker;
+
+  index = LANGUAGE_INDEX (data);
+
+  if (index == 0 || index > self->extra_checkers->len)
+    return self->checker;
+
+  return g_ptr_array_index (self->extra_checkers, index - 1);
+}
+
+static void
+editor_text_buffer_spell_adapter_reset_languages (EditorTextBufferSpellAdapter *self)
+{
+  guint length;
+
+  g_assert (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
+
+  g_cancellable_cancel (self->detect_cancellable);
+  g_clear_object (&self->detect_cancellable);
+
+  if ((length = _cjh_text_region_get_length (self->languages)) > 0)
+    _cjh_text_region_replace (self->languages, 0, length, LANGUAGE_UNKNOWN);
+}
+
+/* Lines touched by an edit keep their language while checking, but they
+ * are detected again in case the paragraph switched languages.
+ */
+static void
+editor_text_buffer_spell_adapter_mark_languages_stale (EditorTextBufferSpellAdapter *self,
+                                                       guint                         offset,
+                                                       guint                         length)
+{
+  g_autoptr(GArray) runs = NULL;
+  GtkTextIter begin, end;
+
+  g_assert (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
+
+  if (self->buffer == NULL || !has_extra_languages (self))
+    return;
+
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &begin, offset);
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &end, offset + length);
+  gtk_text_iter_set_line_offset (&begin, 0);
+  if (!gtk_text_iter_ends_line (&end))
+    gtk_text_iter_forward_to_line_end (&end);
+
+  runs = collect_language_runs (self,
+                                gtk_text_iter_get_offset (&begin),
+                                gtk_text_iter_get_offset (&end));
+
+  for (guint i = 0; i < runs->len; i++)
+    {
+      const LanguageRun *run = &g_array_index (runs, LanguageRun, i);
+
+      if (run->data != LANGUAGE_UNKNOWN && !LANGUAGE_IS_STALE (run->data))
+        _cjh_text_region_replace (self->languages,
+                                  run->begin,
+                                  run->end - run->begin,
+                                  LANGUAGE_DATA (LANGUAGE_INDEX (run->data), TRUE));
+    }
+}
+
 static gboolean
 get_current_word (EditorTextBufferSpellAdapter *self,
                   GtkTextIter                  *begin,
@@ -178,6 +419,87 @@ contains_iter (const GtkTextIter *begin,
          gtk_text_iter_compare (iter, end) <= 0;
 }
 
+static gboolean
+count_unchecked_cb (gsize                   offset,
+                    const CjhTextRegionRun *run,
+                    gpointer                user_data)
+{
+  CountUnchecked *count = user_data;
+
+  if (run->data == RUN_UNCHECKED)
+    count->count += MIN (offset + run->length, count->end) - MAX (offset, count->begin);
+
+  return FALSE;
+}
+
+static gsize
+count_unchecked (EditorTextBufferSpellAdapter *self,
+                 gsize                         offset,
+                 gsize                         length)
+{
+  CountUnchecked count = { offset, offset + length, 0 };
+
+  /* The whole region is what the backlog already tracks */
+  if (offset == 0 && length == _cjh_text_region_get_length (self->region))
+    return self->backlog;
+
+  _cjh_text_region_foreach_in_range (self->region, offset, offset + length, count_unchecked_cb, &count);
+
+  return count.count;
+}
+
+static void
+editor_text_buffer_spell_adapter_update_backlog (EditorTextBufferSpellAdapter *self,
+                                                 gsize                         backlog)
+{
+  g_assert (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
+
+  _editor_spell_metrics.backlog += (gint64)backlog - (gint64)self->backlog;
+  self->backlog = backlog;
+}
+
+/* Changes to @region go through these so that the backlog only costs
+ * a walk over the runs being changed.
+ */
+static void
+region_insert (EditorTextBufferSpellAdapter *self,
+               gsize                         offset,
+               gsize                         length,
+               gpointer                      data)
+{
+  _cjh_text_region_insert (self->region, offset, length, data);
+
+  if (data == RUN_UNCHECKED)
+    editor_text_buffer_spell_adapter_update_backlog (self, self->backlog + length);
+}
+
+static void
+region_replace (EditorTextBufferSpellAdapter *self,
+                gsize                         offset,
+                gsize                         length,
+                gpointer                      data)
+{
+  gsize backlog = self->backlog - MIN (self->backlog, count_unchecked (self, offset, length));
+
+  _cjh_text_region_replace (self->region, offset, length, data);
+
+  if (data == RUN_UNCHECKED)
+    backlog += length;
+
+  editor_text_buffer_spell_adapter_update_backlog (self, backlog);
+}
+
+static void
+region_remove (EditorTextBufferSpellAdapter *self,
+               gsize                         offset,
+               gsize                         length)
+{
+  gsize backlog = self->backlog - MIN (self->backlog, count_unchecked (self, offset, length));
+
+  _cjh_text_region_remove (self->region, offset, length);
+  editor_text_buffer_spell_adapter_update_backlog (self, backlog);
+}
+
 static gboolean
 get_unchecked_start_cb (gsize                   offset,
                         const CjhTextRegionRun *run,
@@ -207,13 +529,183 @@ get_unchecked_start (CjhTextRegion *region,
   return TRUE;
 }
 
+static void
+push_range (GArray *ranges,
+            guint   begin,
+            guint   end)
+{
+  OffsetRange range = { begin, end };
+
+  if (ranges->len > 0)
+    {
+      OffsetRange *last = &g_array_index (ranges, OffsetRange, ranges->len - 1);
+
+      /* Ranges mostly arrive in order, but the current word may come
+       * last while lying before the others. Only merge forward.
+       */
+      if (begin >= last->begin && begin <= last->end)
+        {
+          last->end = MAX (last->end, end);
+          return;
+        }
+    }
+
+  g_array_append_val (ranges, range);
+}
+
+static gboolean
+collect_unchecked_cb (gsize                   offset,
+                      const CjhTextRegionRun *run,
+                      gpointer                user_data)
+{
+  CollectUnchecked *collect = user_data;
+
+  if (run->data == RUN_UNCHECKED)
+    push_range (collect->ranges,
+                MAX (offset, collect->begin),
+                MIN (offset + run->length, collect->end));
+
+  return FALSE;
+}
+
+static void
+tag_update_init (TagUpdate *update)
+{
+  update->unchecked = g_array_new (FALSE, FALSE, sizeof (OffsetRange));
+  update->apply = g_array_new (FALSE, FALSE, sizeof (OffsetRange));
+  update->remove = g_array_new (FALSE, FALSE, sizeof (OffsetRange));
+}
+
+static void
+tag_update_clear (TagUpdate *update)
+{
+  g_clear_pointer (&update->unchecked, g_array_unref);
+  g_clear_pointer (&update->apply, g_array_unref);
+  g_clear_pointer (&update->remove, g_array_unref);
+}
+
+static gboolean
+range_has_tag (GtkTextTag        *tag,
+               const GtkTextIter *begin,
+               const GtkTextIter *end)
+{
+  GtkTextIter iter = *begin;
+
+  if (gtk_text_iter_has_tag (&iter, tag))
+    return TRUE;
+
+  return gtk_text_iter_forward_to_tag_toggle (&iter, tag) &&
+         gtk_text_iter_compare (&iter, end) < 0;
+}
+
+static gboolean
+range_is_tagged (GtkTextTag        *tag,
+                 const GtkTextIter *begin,
+                 const GtkTextIter *end)
+{
+  GtkTextIter iter = *begin;
+
+  if (!gtk_text_iter_has_tag (&iter, tag))
+    return FALSE;
+
+  return !gtk_text_iter_forward_to_tag_toggle (&iter, tag) ||
+         gtk_text_iter_compare (&iter, end) >= 0;
+}
+
+/* Text between words that was unchecked must not be underlined. That
+ * happens after splitting a misspelled word, for example.
+ */
+static void
+editor_text_buffer_spell_adapter_update_gap (EditorTextBufferSpellAdapter *self,
+                                             TagUpdate                    *update,
+                                             const GtkTextIter            *begin,
+                                             const GtkTextIter            *end)
+{
+  guint begin_offset = gtk_text_iter_get_offset (begin);
+  guint end_offset = gtk_text_iter_get_offset (end);
+  CollectUnchecked collect = { update->unchecked, begin_offset, end_offset };
+
+  /* Only look at the part of the region covered by the gap */
+  g_array_set_size (update->unchecked, 0);
+  _cjh_text_region_foreach_in_range (self->region, begin_offset, end_offset, collect_unchecked_cb, &collect);
+
+  for (guint i = 0; i < update->unchecked->len; i++)
+    {
+      const OffsetRange *range = &g_array_index (update->unchecked, OffsetRange, i);
+      GtkTextIter piece_begin = *begin;
+      GtkTextIter piece_end = *end;
+
+      if (range->begin > begin_offset)
+        gtk_text_buffer_get_iter_at_offset (self->buffer, &piece_begin, range->begin);
+
+      if (range->end < end_offset)
+        gtk_text_buffer_get_iter_at_offset (self->buffer, &piece_end, range->end);
+
+      if (range_has_tag (self->tag, &piece_begin, &piece_end))
+        push_range (update->remove,
+                    gtk_text_iter_get_offset (&piece_begin),
+                    gtk_text_iter_get_offset (&piece_end));
+    }
+}
+
+static void
+editor_text_buffer_spell_adapter_update_word (EditorTextBufferSpellAdapter *self,
+                                              TagUpdate                    *update,
+                                              const GtkTextIter            *begin,
+                                              const GtkTextIter            *end,
+                                              gboolean                      underline)
+{
+  if (underline)
+    {
+      if (!range_is_tagged (self->tag, begin, end))
+        push_range (update->apply, gtk_text_iter_get_offset (begin), gtk_text_iter_get_offset (end));
+    }
+  else
+    {
+      if (range_has_tag (self->tag, begin, end))
+        push_range (update->remove, gtk_text_iter_get_offset (begin), gtk_text_iter_get_offset (end));
+    }
+}
+
+static void
+editor_text_buffer_spell_adapter_flush (EditorTextBufferSpellAdapter *self,
+                                        TagUpdate                    *update)
+{
+  GtkTextIter begin, end;
+
+  for (guint i = 0; i < update->remove->len; i++)
+    {
+      const OffsetRange *range = &g_array_index (update->remove, OffsetRange, i);
+
+      gtk_text_buffer_get_iter_at_offset (self->buffer, &begin, range->begin);
+      gtk_text_buffer_get_iter_at_offset (self->buffer, &end, range->end);
+      gtk_text_buffer_remove_tag (self->buffer, self->tag, &begin, &end);
+    }
+
+  for (guint i = 0; i < update->apply->len; i++)
+    {
+      const OffsetRange *range = &g_array_index (update->apply, OffsetRange, i);
+
+      gtk_text_buffer_get_iter_at_offset (self->buffer, &begin, range->begin);
+      gtk_text_buffer_get_iter_at_offset (self->buffer, &end, range->end);
+      gtk_text_buffer_apply_tag (self->buffer, self->tag, &begin, &end);
+    }
+}
+
 static gboolean
 editor_text_buffer_spell_adapter_update_range (EditorTextBufferSpellAdapter *self,
-                                               gint64                        deadline)
+                                               gint64                        deadline,
+                                               guint                        *n_checked)
 {
   g_autoptr(EditorSpellCursor) cursor = NULL;
-  GtkTextIter word_begin, word_end, begin;
+  GtkTextIter word_begin, word_end, begin, last_end;
+  GtkTextIter current_begin, current_end;
+  EditorSpellChecker *checker;
   const char *extra_word_chars;
+  LanguageRun language = { 0 };
+  TagUpdate update;
+  gboolean has_current;
+  gboolean has_extra;
   gboolean ret = FALSE;
   guint checked = 0;
 
@@ -231,21 +723,63 @@ editor_text_buffer_spell_adapter_update_range (EditorTextBufferSpellAdapter *sel
    */
   if (!get_unchecked_start (self->region, self->buffer, &begin))
     {
-      _cjh_text_region_replace (self->region,
-                                0,
-                                _cjh_text_region_get_length (self->region),
-                                RUN_CHECKED);
+      region_replace (self,
+                      0,
+                      _cjh_text_region_get_length (self->region),
+                      RUN_CHECKED);
       return FALSE;
     }
 
+  /* Don't underline the word being typed to be less annoying */
+  has_current = get_current_word (self, &current_begin, &current_end);
+
+  tag_update_init (&update);
+  last_end = begin;
+  checker = self->checker;
+  has_extra = has_extra_languages (self);
+
+  /* Nothing touches the buffer until the flush below, so the iters
+   * from the cursor remain valid while we compare them to the tags.
+   */
   while (editor_spell_cursor_next (cursor, &word_begin, &word_end))
     {
-      g_autofree char *word = gtk_text_iter_get_slice (&word_begin, &word_end);
+      g_autofree char *word = NULL;
+      gboolean underline;
+
+      if (has_extra)
+        {
+          guint offset = gtk_text_iter_get_offset (&word_begin);
+
+          if (offset < language.begin || offset >= language.end)
+            {
+              get_language_run (self, offset, &language);
+              checker = get_checker_for_language (self, language.data);
+            }
+
+          /* Wait for the paragraph to be detected rather than underline
+           * every word with the wrong dictionary in the meantime.
+           */
+          if (language.data == LANGUAGE_UNKNOWN)
+            {
+              word_end = word_begin;
+              break;
+            }
+        }
 
+      word = gtk_text_iter_get_slice (&word_begin, &word_end);
       checked++;
+      (*n_checked)++;
 
-      if (!editor_spell_checker_check_word (self->checker, word, -1))
-        gtk_text_buffer_apply_tag (self->buffer, self->tag, &word_begin, &word_end);
+      if (gtk_text_iter_compare (&last_end, &word_begin) < 0)
+        editor_text_buffer_spell_adapter_update_gap (self, &update, &last_end, &word_begin);
+
+      underline = !editor_spell_checker_check_word (checker, word, -1) &&
+                  !(has_current &&
+                    gtk_text_iter_equal (&word_begin, &current_begin) &&
+                    gtk_text_iter_equal (&word_end, &current_end));
+      editor_text_buffer_spell_adapter_update_word (self, &update, &word_begin, &word_end, underline);
+
+      last_end = word_end;
 
       /* Check deadline every five words */
       if (checked % 5 == 0 && deadline < g_get_monotonic_time ())
@@ -255,29 +789,340 @@ editor_text_buffer_spell_adapter_update_range (EditorTextBufferSpellAdapter *sel
         }
     }
 
-  _cjh_text_region_replace (self->region,
-                            gtk_text_iter_get_offset (&begin),
-                            gtk_text_iter_get_offset (&word_end) - gtk_text_iter_get_offset (&begin),
-                            RUN_CHECKED);
+  /* The cursor stops at the end of the buffer once there are no more
+   * words, so this also covers any trailing text without words.
+   */
+  if (gtk_text_iter_compare (&last_end, &word_end) < 0)
+    editor_text_buffer_spell_adapter_update_gap (self, &update, &last_end, &word_end);
+
+  /* The current word may not have been part of this slice */
+  if (has_current)
+    editor_text_buffer_spell_adapter_update_word (self, &update, &current_begin, &current_end, FALSE);
+
+  region_replace (self,
+                  gtk_text_iter_get_offset (&begin),
+                  gtk_text_iter_get_offset (&word_end) - gtk_text_iter_get_offset (&begin),
+                  RUN_CHECKED);
 
-  /* Now remove any tag for the current word to be less annoying */
-  if (get_current_word (self, &word_begin, &word_end))
-    gtk_text_buffer_remove_tag (self->buffer, self->tag, &word_begin, &word_end);
+  editor_text_buffer_spell_adapter_flush (self, &update);
+  tag_update_clear (&update);
 
   return ret;
 }
 
+static int
+compare_cache_range (gconstpointer a,
+                     gconstpointer b)
+{
+  const EditorSpellCacheRange *ra = a;
+  const EditorSpellCacheRange *rb = b;
+
+  if (ra->offset < rb->offset)
+    return -1;
+  else if (ra->offset > rb->offset)
+    return 1;
+  else
+    return 0;
+}
+
+static GArray *
+editor_text_buffer_spell_adapter_collect_misspelled (EditorTextBufferSpellAdapter *self)
+{
+  GArray *ranges = g_array_new (FALSE, FALSE, sizeof (EditorSpellCacheRange));
+  GtkTextIter iter, end;
+
+  g_assert (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
+
+  gtk_text_buffer_get_start_iter (self->buffer, &iter);
+  if (!gtk_text_iter_starts_tag (&iter, self->tag))
+    gtk_text_iter_forward_to_tag_toggle (&iter, self->tag);
+
+  while (gtk_text_iter_starts_tag (&iter, self->tag))
+    {
+      EditorSpellCacheRange range;
+
+      end = iter;
+      gtk_text_iter_forward_to_tag_toggle (&end, self->tag);
+
+      range.offset = gtk_text_iter_get_offset (&iter);
+      range.length = gtk_text_iter_get_offset (&end) - range.offset;
+      g_array_append_val (ranges, range);
+
+      iter = end;
+      gtk_text_iter_forward_to_tag_toggle (&iter, self->tag);
+    }
+
+  /* The current word is checked but not underlined */
+  if (get_current_word (self, &iter, &end))
+    {
+      g_autofree char *word = gtk_text_iter_get_slice (&iter, &end);
+
+      if (!editor_spell_checker_check_word (self->checker, word, -1))
+        {
+          EditorSpellCacheRange range;
+
+          range.offset = gtk_text_iter_get_offset (&iter);
+          range.length = gtk_text_iter_get_offset (&end) - range.offset;
+          g_array_append_val (ranges, range);
+          g_array_sort (ranges, compare_cache_range);
+        }
+    }
+
+  return ranges;
+}
+
+static void
+editor_text_buffer_spell_adapter_save_cache (EditorTextBufferSpellAdapter *self)
+{
+  g_autoptr(GArray) ranges = NULL;
+  GtkTextIter begin, end;
+  const char *language;
+
+  g_assert (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
+
+  if (!self->enabled ||
+      self->restoring ||
+      self->buffer == NULL ||
+      self->checker == NULL ||
+      self->saved_generation == self->generation)
+    return;
+
+  /* Entries are keyed by a single language */
+  if (has_extra_languages (self))
+    return;
+
+  /* Only keep results for contents that are saved somewhere, otherwise
+   * we would write a new entry for every pause while typing.
+   */
+  if (gtk_text_buffer_get_modified (self->buffer) ||
+      gtk_text_buffer_get_char_count (self->buffer) == 0 ||
+      get_unchecked_start (self->region, self->buffer, &begin))
+    return;
+
+  if (editor_spell_checker_get_busy (self->checker) ||
+      !(language = editor_spell_checker_get_language (self->checker)))
+    return;
+
+  self->saved_generation = self->generation;
+
+  ranges = editor_text_buffer_spell_adapter_collect_misspelled (self);
+  gtk_text_buffer_get_bounds (self->buffer, &begin, &end);
+  _editor_spell_cache_save (language,
+                            gtk_text_buffer_get_text (self->buffer, &begin, &end, TRUE),
+                            ranges);
+}
+
+
+static void
+language_unref (gpointer data)
+{
+  if (data != NULL)
+    g_object_unref (data);
+}
+
+static void
+add_spell_language (GPtrArray          *languages,
+                    EditorSpellChecker *checker)
+{
+  EditorSpellLanguage *language = _editor_spell_checker_get_spell_language (checker);
+
+  /* Dictionaries still loading are skipped by the detection */
+  g_ptr_array_add (languages, language ? g_object_ref (language) : NULL);
+}
+
+static void
+editor_text_buffer_spell_adapter_apply_language (EditorTextBufferSpellAdapter *self,
+                                                 guint                         begin,
+                                                 guint                         end,
+                                                 guint                         index)
+{
+  g_autoptr(GArray) runs = NULL;
+
+  g_assert (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
+
+  runs = collect_language_runs (self, begin, end);
+
+  for (guint i = 0; i < runs->len; i++)
+    {
+      const LanguageRun *run = &g_array_index (runs, LanguageRun, i);
+      guint run_index = index;
+
+      if (run->begin >= run->end)
+        continue;
+
+      /* Too few words to tell, keep what we had */
+      if (run_index == EDITOR_SPELL_DETECT_UNKNOWN)
+        run_index = run->data == LANGUAGE_UNKNOWN ? 0 : LANGUAGE_INDEX (run->data);
+
+      _cjh_text_region_replace (self->languages,
+                                run->begin,
+                                run->end - run->begin,
+                                LANGUAGE_DATA (run_index, FALSE));
+
+      /* Words checked with another dictionary must be checked again */
+      if (self->enabled &&
+          run->data != LANGUAGE_UNKNOWN &&
+          LANGUAGE_INDEX (run->data) != run_index)
+        region_replace (self, run->begin, run->end - run->begin, RUN_UNCHECKED);
+    }
+}
+
+static void
+editor_text_buffer_spell_adapter_detect_cb (GObject      *object,
+                                            GAsyncResult *result,
+                                            gpointer      user_data)
+{
+  g_autoptr(EditorTextBufferSpellAdapter) self = user_data;
+  g_autoptr(GArray) runs = NULL;
+  g_autoptr(GError) error = NULL;
+
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
+
+  runs = _editor_spell_detect_finish (result, &error);
+
+  /* Superseded by a language change */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  g_clear_object (&self->detect_cancellable);
+
+  if (runs == NULL || self->buffer == NULL)
+    return;
+
+  /* Offsets are only meaningful if the text did not change meanwhile,
+   * otherwise the next update detects the paragraphs again.
+   */
+  if (self->detect_generation == self->generation)
+    {
+      for (guint i = 0; i < runs->len; i++)
+        {
+          const EditorSpellDetectRun *run = &g_array_index (runs, EditorSpellDetectRun, i);
+          guint begin = self->detect_offset + run->offset;
+
+          editor_text_buffer_spell_adapter_apply_language (self, begin, begin + run->length, run->language);
+        }
+    }
+
+  editor_text_buffer_spell_adapter_queue_update (self);
+}
+
+static gboolean
+find_undetected_cb (gsize                   offset,
+                    const CjhTextRegionRun *run,
+                    gpointer                user_data)
+{
+  gsize *pos = user_data;
+
+  if (run->data == LANGUAGE_UNKNOWN || LANGUAGE_IS_STALE (run->data))
+    {
+      *pos = offset;
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+editor_text_buffer_spell_adapter_queue_detect (EditorTextBufferSpellAdapter *self)
+{
+  g_autoptr(GPtrArray) languages = NULL;
+  GtkTextIter begin, end;
+  gsize pos = G_MAXSIZE;
+
+  g_assert (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
+
+  if (self->detect_cancellable != NULL ||
+      self->buffer == NULL ||
+      self->checker == NULL ||
+      !self->enabled ||
+      !has_extra_languages (self))
+    return;
+
+  _cjh_text_region_foreach (self->languages, find_undetected_cb, &pos);
+
+  if (pos == G_MAXSIZE)
+    return;
+
+  /* Start from the beginning of the paragraph so that all of its
+   * words count towards the detected language.
+   */
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &begin, pos);
+  gtk_text_iter_set_line_offset (&begin, 0);
+
+  for (guint i = 0; i < DETECT_LOOKBEHIND_LINES; i++)
+    {
+      GtkTextIter prev = begin;
+
+      if (!gtk_text_iter_backward_line (&prev) || gtk_text_iter_ends_line (&prev))
+        break;
+
+      begin = prev;
+    }
+
+  gtk_text_buffer_get_iter_at_offset (self->buffer, &end, pos + DETECT_WINDOW_CHARS);
+  if (!gtk_text_iter_starts_line (&end))
+    gtk_text_iter_forward_line (&end);
+
+  languages = g_ptr_array_new_with_free_func (language_unref);
+  add_spell_language (languages, self->checker);
+  for (guint i = 0; i < self->extra_checkers->len; i++)
+    add_spell_language (languages, g_ptr_array_index (self->extra_checkers, i));
+
+  self->detect_cancellable = g_cancellable_new ();
+  self->detect_generation = self->generation;
+  self->detect_offset = gtk_text_iter_get_offset (&begin);
+
+  _editor_spell_detect_async (languages,
+                              gtk_text_buffer_get_text (self->buffer, &begin, &end, TRUE),
+                              self->detect_cancellable,
+                              editor_text_buffer_spell_adapter_detect_cb,
+                              g_object_ref (self));
+}
+
 static gboolean
 editor_text_buffer_spell_adapter_run (gint64   deadline,
                                       gpointer user_data)
 {
   EditorTextBufferSpellAdapter *self = user_data;
+  gint64 begin_time = g_get_monotonic_time ();
+  gint64 end_time;
+  guint n_checked = 0;
+  gboolean ret;
 
   g_assert (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
 
-  if (!editor_text_buffer_spell_adapter_update_range (self, deadline))
+  editor_text_buffer_spell_adapter_queue_detect (self);
+
+  ret = editor_text_buffer_spell_adapter_update_range (self, deadline, &n_checked);
+
+  end_time = g_get_monotonic_time ();
+
+  _editor_spell_metrics.n_slices++;
+  _editor_spell_metrics.n_slice_words += n_checked;
+  _editor_spell_metrics.slice_usec_total += end_time - begin_time;
+  _editor_spell_metrics.slice_usec_max = MAX (_editor_spell_metrics.slice_usec_max, end_time - begin_time);
+  if (end_time > deadline)
+    _editor_spell_metrics.n_slices_over_deadline++;
+
+  if (self->pass_n_slices++ == 0)
+    self->pass_begin_time = begin_time;
+  self->pass_n_checked += n_checked;
+
+  if (!ret)
     {
+      if (_editor_trace_is_enabled ())
+        {
+          g_autofree char *detail = g_strdup_printf ("words=%u slices=%u",
+                                                     self->pass_n_checked,
+                                                     self->pass_n_slices);
+          _editor_trace_mark ("spellcheck", "Check spelling", self->pass_begin_time, end_time, detail);
+        }
+
+      self->pass_n_slices = 0;
+      self->pass_n_checked = 0;
       self->update_source = 0;
+      editor_text_buffer_spell_adapter_save_cache (self);
       return G_SOURCE_REMOVE;
     }
 
@@ -289,7 +1134,7 @@ editor_text_buffer_spell_adapter_queue_update (EditorTextBufferSpellAdapter *sel
 {
   g_assert (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
 
-  if (self->checker == NULL || self->buffer == NULL || !self->enabled)
+  if (self->checker == NULL || self->buffer == NULL || !self->enabled || self->restoring)
     {
       gtk_source_scheduler_clear (&self->update_source);
       return;
@@ -299,6 +1144,110 @@ editor_text_buffer_spell_adapter_queue_update (EditorTextBufferSpellAdapter *sel
     self->update_source = gtk_source_scheduler_add (editor_text_buffer_spell_adapter_run, self);
 }
 
+static void
+editor_text_buffer_spell_adapter_restore_cb (GObject      *object,
+                                             GAsyncResult *result,
+                                             gpointer      user_data)
+{
+  g_autoptr(EditorTextBufferSpellAdapter) self = user_data;
+  g_autoptr(GArray) ranges = NULL;
+  g_autoptr(GError) error = NULL;
+  GtkTextIter begin, end;
+  gsize length;
+
+  g_assert (G_IS_ASYNC_RESULT (result));
+  g_assert (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
+
+  ranges = _editor_spell_cache_load_finish (result, &error);
+
+  /* Superseded by another restore */
+  if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  g_clear_object (&self->restore_cancellable);
+  self->restoring = FALSE;
+
+  if (ranges == NULL ||
+      self->buffer == NULL ||
+      self->checker == NULL ||
+      !self->enabled ||
+      self->generation != self->restore_generation)
+    {
+      editor_text_buffer_spell_adapter_queue_update (self);
+      return;
+    }
+
+  gtk_text_buffer_get_bounds (self->buffer, &begin, &end);
+  gtk_text_buffer_remove_tag (self->buffer, self->tag, &begin, &end);
+
+  for (guint i = 0; i < ranges->len; i++)
+    {
+      const EditorSpellCacheRange *range = &g_array_index (ranges, EditorSpellCacheRange, i);
+      g_autofree char *word = NULL;
+
+      gtk_text_buffer_get_iter_at_offset (self->buffer, &begin, range->offset);
+      gtk_text_buffer_get_iter_at_offset (self->buffer, &end, range->offset + range->length);
+      word = gtk_text_iter_get_slice (&begin, &end);
+
+      /* Words may have been added to the dictionary since */
+      if (!editor_spell_checker_check_word (self->checker, word, -1))
+        gtk_text_buffer_apply_tag (self->buffer, self->tag, &begin, &end);
+    }
+
+  if ((length = _cjh_text_region_get_length (self->region)) > 0)
+    region_replace (self, 0, length, RUN_CHECKED);
+
+  if (get_current_word (self, &begin, &end))
+    gtk_text_buffer_remove_tag (self->buffer, self->tag, &begin, &end);
+
+  self->saved_generation = self->generation;
+}
+
+static void
+editor_text_buffer_spell_adapter_restore (EditorTextBufferSpellAdapter *self)
+{
+  GtkTextIter begin, end;
+  const char *language;
+
+  g_assert (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
+
+  g_cancellable_cancel (self->restore_cancellable);
+  g_clear_object (&self->restore_cancellable);
+  self->restoring = FALSE;
+
+  if (self->buffer == NULL ||
+      self->checker == NULL ||
+      gtk_text_buffer_get_modified (self->buffer) ||
+      gtk_text_buffer_get_char_count (self->buffer) == 0 ||
+      has_extra_languages (self) ||
+      editor_spell_checker_get_busy (self->checker) ||
+      !(language = editor_spell_checker_get_language (self->checker)))
+    return;
+
+  self->restoring = TRUE;
+  self->restore_generation = self->generation;
+  self->restore_cancellable = g_cancellable_new ();
+
+  gtk_text_buffer_get_bounds (self->buffer, &begin, &end);
+  _editor_spell_cache_load_async (language,
+                                  gtk_text_buffer_get_text (self->buffer, &begin, &end, TRUE),
+                                  self->restore_cancellable,
+                                  editor_text_buffer_spell_adapter_restore_cb,
+                                  g_object_ref (self));
+}
+
+static void
+editor_text_buffer_spell_adapter_modified_changed_cb (EditorTextBufferSpellAdapter *self,
+                                                      GtkTextBuffer                *buffer)
+{
+  g_assert (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
+  g_assert (GTK_IS_TEXT_BUFFER (buffer));
+
+  /* Results from before saving can be used for the new contents */
+  if (self->update_source == 0)
+    editor_text_buffer_spell_adapter_save_cache (self);
+}
+
 void
 editor_text_buffer_spell_adapter_invalidate_all (EditorTextBufferSpellAdapter *self)
 {
@@ -310,10 +1259,15 @@ editor_text_buffer_spell_adapter_invalidate_all (EditorTextBufferSpellAdapter *s
   if (!self->enabled)
     return;
 
+  self->saved_generation = 0;
+
+  /* Hold off checking while we look for previous results */
+  editor_text_buffer_spell_adapter_restore (self);
+
   /* We remove using the known length from the region */
   if ((length = _cjh_text_region_get_length (self->region)) > 0)
     {
-      _cjh_text_region_remove (self->region, 0, length - 1);
+      region_remove (self, 0, length - 1);
       editor_text_buffer_spell_adapter_queue_update (self);
     }
 
@@ -324,8 +1278,7 @@ editor_text_buffer_spell_adapter_invalidate_all (EditorTextBufferSpellAdapter *s
   if (!gtk_text_iter_equal (&begin, &end))
     {
       length = gtk_text_iter_get_offset (&end) - gtk_text_iter_get_offset (&begin);
-      _cjh_text_region_insert (self->region, 0, length, RUN_UNCHECKED);
-      gtk_text_buffer_remove_tag (self->buffer, self->tag, &begin, &end);
+      region_insert (self, 0, length, RUN_UNCHECKED);
     }
 }
 
@@ -383,7 +1336,7 @@ invalidate_tag_region_cb (EditorTextBufferSpellAdapter *self,
       gsize begin_offset = gtk_text_iter_get_offset (begin);
       gsize end_offset = gtk_text_iter_get_offset (end);
 
-      _cjh_text_region_replace (self->region, begin_offset, end_offset - begin_offset, RUN_UNCHECKED);
+      region_replace (self, begin_offset, end_offset - begin_offset, RUN_UNCHECKED);
       editor_text_buffer_spell_adapter_queue_update (self);
     }
 }
@@ -407,7 +1360,8 @@ editor_text_buffer_spell_adapter_set_buffer (EditorTextBufferSpellAdapter *self,
       offset = gtk_text_iter_get_offset (&begin);
       length = gtk_text_iter_get_offset (&end) - offset;
 
-      _cjh_text_region_insert (self->region, offset, length, RUN_UNCHECKED);
+      region_insert (self, offset, length, RUN_UNCHECKED);
+      _cjh_text_region_insert (self->languages, offset, length, LANGUAGE_UNKNOWN);
 
       self->tag = gtk_text_buffer_create_tag (buffer, NULL,
                                               "underline", PANGO_UNDERLINE_ERROR,
@@ -438,6 +1392,11 @@ editor_text_buffer_spell_adapter_set_buffer (EditorTextBufferSpellAdapter *self,
                                G_CALLBACK (invalidate_tag_region_cb),
                                self,
                                G_CONNECT_SWAPPED);
+      g_signal_connect_object (buffer,
+                               "modified-changed",
+                               G_CALLBACK (editor_text_buffer_spell_adapter_modified_changed_cb),
+                               self,
+                               G_CONNECT_SWAPPED);
 
       editor_text_buffer_spell_adapter_queue_update (self);
     }
@@ -478,6 +1437,9 @@ editor_text_buffer_spell_adapter_finalize (GObject *object)
   g_clear_object (&self->checker);
   g_clear_object (&self->no_spell_check_tag);
   g_clear_pointer (&self->region, _cjh_text_region_free);
+  g_clear_pointer (&self->languages, _cjh_text_region_free);
+  g_clear_pointer (&self->extra_checkers, g_ptr_array_unref);
+  g_clear_pointer (&self->extra_languages, g_strfreev);
 
   G_OBJECT_CLASS (editor_text_buffer_spell_adapter_parent_class)->finalize (object);
 }
@@ -489,6 +1451,20 @@ editor_text_buffer_spell_adapter_dispose (GObject *object)
 
   g_clear_weak_pointer (&self->buffer);
   gtk_source_scheduler_clear (&self->update_source);
+  editor_text_buffer_spell_adapter_update_backlog (self, 0);
+
+  g_cancellable_cancel (self->restore_cancellable);
+  g_clear_object (&self->restore_cancellable);
+  self->restoring = FALSE;
+
+  g_cancellable_cancel (self->detect_cancellable);
+  g_clear_object (&self->detect_cancellable);
+
+  if (self->cursor_moved_source != NULL)
+    {
+      g_source_destroy (self->cursor_moved_source);
+      g_clear_pointer (&self->cursor_moved_source, g_source_unref);
+    }
 
   G_OBJECT_CLASS (editor_text_buffer_spell_adapter_parent_class)->dispose (object);
 }
@@ -515,6 +1491,10 @@ editor_text_buffer_spell_adapter_get_property (GObject    *object,
       g_value_set_boolean (value, self->enabled);
       break;
 
+    case PROP_EXTRA_LANGUAGES:
+      g_value_set_boxed (value, self->extra_languages);
+      break;
+
     case PROP_LANGUAGE:
       g_value_set_string (value, editor_text_buffer_spell_adapter_get_language (self));
       break;
@@ -546,6 +1526,10 @@ editor_text_buffer_spell_adapter_set_property (GObject      *object,
       editor_text_buffer_spell_adapter_set_enabled (self, g_value_get_boolean (value));
       break;
 
+    case PROP_EXTRA_LANGUAGES:
+      editor_text_buffer_spell_adapter_set_extra_languages (self, g_value_get_boxed (value));
+      break;
+
     case PROP_LANGUAGE:
       editor_text_buffer_spell_adapter_set_language (self, g_value_get_string (value));
       break;
@@ -586,6 +1570,13 @@ editor_text_buffer_spell_adapter_class_init (EditorTextBufferSpellAdapterClass *
                           TRUE,
                           (G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS));
 
+  properties [PROP_EXTRA_LANGUAGES] =
+    g_param_spec_boxed ("extra-languages",
+                        "Extra Languages",
+                        "Additional language codes detected per paragraph",
+                        G_TYPE_STRV,
+                        (G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS));
+
   properties [PROP_LANGUAGE] =
     g_param_spec_string ("language",
                          "Language",
@@ -600,6 +1591,8 @@ static void
 editor_text_buffer_spell_adapter_init (EditorTextBufferSpellAdapter *self)
 {
   self->region = _cjh_text_region_new (NULL, NULL);
+  self->languages = _cjh_text_region_new (join_language_cb, NULL);
+  self->generation = 1;
 }
 
 EditorSpellChecker *
@@ -610,6 +1603,33 @@ editor_text_buffer_spell_adapter_get_checker (EditorTextBufferSpellAdapter *self
   return self->checker;
 }
 
+static void
+editor_text_buffer_spell_adapter_checker_notify_language_cb (EditorTextBufferSpellAdapter *self,
+                                                             GParamSpec                   *pspec,
+                                                             EditorSpellChecker           *checker)
+{
+  g_assert (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
+  g_assert (EDITOR_IS_SPELL_CHECKER (checker));
+
+  /* Dictionaries load in the background, recheck once they are ready */
+  editor_text_buffer_spell_adapter_reset_languages (self);
+  editor_text_buffer_spell_adapter_invalidate_all (self);
+  g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_LANGUAGE]);
+}
+
+static void
+editor_text_buffer_spell_adapter_extra_checker_notify_language_cb (EditorTextBufferSpellAdapter *self,
+                                                                   GParamSpec                   *pspec,
+                                                                   EditorSpellChecker           *checker)
+{
+  g_assert (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
+  g_assert (EDITOR_IS_SPELL_CHECKER (checker));
+
+  /* Paragraphs were detected without this dictionary */
+  editor_text_buffer_spell_adapter_reset_languages (self);
+  editor_text_buffer_spell_adapter_invalidate_all (self);
+}
+
 void
 editor_text_buffer_spell_adapter_set_checker (EditorTextBufferSpellAdapter *self,
                                               EditorSpellChecker           *checker)
@@ -617,16 +1637,31 @@ editor_text_buffer_spell_adapter_set_checker (EditorTextBufferSpellAdapter *self
   g_return_if_fail (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
   g_return_if_fail (!checker || EDITOR_IS_SPELL_CHECKER (checker));
 
+  if (self->checker == checker)
+    return;
+
+  if (self->checker != NULL)
+    g_signal_handlers_disconnect_by_func (self->checker,
+                                          G_CALLBACK (editor_text_buffer_spell_adapter_checker_notify_language_cb),
+                                          self);
+
   if (g_set_object (&self->checker, checker))
     {
       gsize length = _cjh_text_region_get_length (self->region);
 
+      if (checker != NULL)
+        g_signal_connect_object (checker,
+                                 "notify::language",
+                                 G_CALLBACK (editor_text_buffer_spell_adapter_checker_notify_language_cb),
+                                 self,
+                                 G_CONNECT_SWAPPED);
+
       gtk_source_scheduler_clear (&self->update_source);
 
       if (length > 0)
         {
-          _cjh_text_region_remove (self->region, 0, length - 1);
-          _cjh_text_region_insert (self->region, 0, length, RUN_UNCHECKED);
+          region_remove (self, 0, length - 1);
+          region_insert (self, 0, length, RUN_UNCHECKED);
           g_assert_cmpint (length, ==, _cjh_text_region_get_length (self->region));
         }
 
@@ -665,13 +1700,14 @@ mark_unchecked (EditorTextBufferSpellAdapter *self,
   if (!gtk_text_iter_ends_word (&end))
     forward_word_end (self, &end);
 
-  _cjh_text_region_replace (self->region,
-                            gtk_text_iter_get_offset (&begin),
-                            gtk_text_iter_get_offset (&end) - gtk_text_iter_get_offset (&begin),
-                            RUN_UNCHECKED);
-
-  gtk_text_buffer_remove_tag (self->buffer, self->tag, &begin, &end);
+  region_replace (self,
+                  gtk_text_iter_get_offset (&begin),
+                  gtk_text_iter_get_offset (&end) - gtk_text_iter_get_offset (&begin),
+                  RUN_UNCHECKED);
 
+  /* Leave the underline in place, the next pass only changes the tags
+   * of words whose verdict actually changed.
+   */
   editor_text_buffer_spell_adapter_queue_update (self);
 }
 
@@ -680,8 +1716,20 @@ editor_text_buffer_spell_adapter_before_insert_text (EditorTextBufferSpellAdapte
                                                      guint                         offset,
                                                      guint                         length)
 {
+  LanguageRun run;
+
+  self->generation++;
+
   if (self->enabled)
-    _cjh_text_region_insert (self->region, offset, length, RUN_UNCHECKED);
+    region_insert (self, offset, length, RUN_UNCHECKED);
+
+  /* Text typed into a paragraph most likely shares its language */
+  get_language_run (self, offset > 0 ? offset - 1 : offset, &run);
+  _cjh_text_region_insert (self->languages,
+                           offset,
+                           length,
+                           run.data == LANGUAGE_UNKNOWN ? LANGUAGE_UNKNOWN
+                                                        : LANGUAGE_DATA (LANGUAGE_INDEX (run.data), TRUE));
 }
 
 
@@ -690,6 +1738,8 @@ editor_text_buffer_spell_adapter_after_insert_text (EditorTextBufferSpellAdapter
                                                     guint                         offset,
                                                     guint                         length)
 {
+  editor_text_buffer_spell_adapter_mark_languages_stale (self, offset, length);
+
   if (self->enabled)
     mark_unchecked (self, offset, length);
 }
@@ -699,8 +1749,12 @@ editor_text_buffer_spell_adapter_before_delete_range (EditorTextBufferSpellAdapt
                                                       guint                         offset,
                                                       guint                         length)
 {
+  self->generation++;
+
   if (self->enabled)
-    _cjh_text_region_remove (self->region, offset, length);
+    region_remove (self, offset, length);
+
+  _cjh_text_region_remove (self->languages, offset, length);
 }
 
 void
@@ -708,10 +1762,39 @@ editor_text_buffer_spell_adapter_after_delete_range (EditorTextBufferSpellAdapte
                                                      guint                         offset,
                                                      guint                         length)
 {
+  editor_text_buffer_spell_adapter_mark_languages_stale (self, offset, 0);
+
   if (self->enabled)
     mark_unchecked (self, offset, 0);
 }
 
+/**
+ * editor_text_buffer_spell_adapter_invalidate_range:
+ * @self: an #EditorTextBufferSpellAdapter
+ * @offset: the offset of the range
+ * @length: the number of characters in the range
+ *
+ * Marks the words within the range as needing to be checked again, along
+ * with the language of the paragraphs containing it.
+ *
+ * This is used after a series of edits for which only the before insert
+ * and delete hooks were called, so that the range is queued once rather
+ * than per edit.
+ */
+void
+editor_text_buffer_spell_adapter_invalidate_range (EditorTextBufferSpellAdapter *self,
+                                                   guint                         offset,
+                                                   guint                         length)
+{
+  g_return_if_fail (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
+  g_return_if_fail (self->buffer != NULL);
+
+  editor_text_buffer_spell_adapter_mark_languages_stale (self, offset, length);
+
+  if (self->enabled)
+    mark_unchecked (self, offset, length);
+}
+
 static gboolean
 editor_text_buffer_spell_adapter_cursor_moved_cb (gpointer data)
 {
@@ -720,8 +1803,6 @@ editor_text_buffer_spell_adapter_cursor_moved_cb (gpointer data)
 
   g_assert (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
 
-  self->queued_cursor_moved = 0;
-
   /* Invalidate the old position */
   if (self->enabled && get_word_at_position (self, self->cursor_position, &begin, &end))
     mark_unchecked (self,
@@ -736,7 +1817,7 @@ editor_text_buffer_spell_adapter_cursor_moved_cb (gpointer data)
                     gtk_text_iter_get_offset (&begin),
                     gtk_text_iter_get_offset (&end) - gtk_text_iter_get_offset (&begin));
 
-  return G_SOURCE_REMOVE;
+  return G_SOURCE_CONTINUE;
 }
 
 void
@@ -750,12 +1831,17 @@ editor_text_buffer_spell_adapter_cursor_moved (EditorTextBufferSpellAdapter *sel
     return;
 
   self->incoming_cursor_position = position;
-  g_clear_handle_id (&self->queued_cursor_moved, g_source_remove);
-  self->queued_cursor_moved = g_timeout_add_full (G_PRIORITY_LOW,
-                                                  INVALIDATE_DELAY_MSECS,
-                                                  editor_text_buffer_spell_adapter_cursor_moved_cb,
-                                                  g_object_ref (self),
-                                                  g_object_unref);
+
+  /* Push back the same source on every move rather than replacing it */
+  if (self->cursor_moved_source == NULL)
+    self->cursor_moved_source =
+      _editor_ready_time_source_new ("[editor] spell cursor moved",
+                                     G_PRIORITY_LOW,
+                                     editor_text_buffer_spell_adapter_cursor_moved_cb,
+                                     self);
+
+  g_source_set_ready_time (self->cursor_moved_source,
+                           g_get_monotonic_time () + INVALIDATE_DELAY_MSECS * 1000L);
 }
 
 const char *
@@ -777,9 +1863,8 @@ editor_text_buffer_spell_adapter_set_language (EditorTextBufferSpellAdapter *sel
 
   if (self->checker == NULL)
     {
-      self->checker = editor_spell_checker_new (NULL, language);
-      g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_CHECKER]);
-      g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_LANGUAGE]);
+      g_autoptr(EditorSpellChecker) checker = editor_spell_checker_new (NULL, language);
+      editor_text_buffer_spell_adapter_set_checker (self, checker);
     }
   else if (g_strcmp0 (language, editor_text_buffer_spell_adapter_get_language (self)) != 0)
     {
@@ -790,6 +1875,109 @@ editor_text_buffer_spell_adapter_set_language (EditorTextBufferSpellAdapter *sel
   editor_text_buffer_spell_adapter_invalidate_all (self);
 }
 
+const char * const *
+editor_text_buffer_spell_adapter_get_extra_languages (EditorTextBufferSpellAdapter *self)
+{
+  g_return_val_if_fail (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self), NULL);
+
+  return (const char * const *)self->extra_languages;
+}
+
+/**
+ * editor_text_buffer_spell_adapter_set_extra_languages:
+ * @self: an #EditorTextBufferSpellAdapter
+ * @languages: (nullable) (array zero-terminated=1): language codes
+ *
+ * Sets languages which may be used in the document besides
+ * #EditorTextBufferSpellAdapter:language.
+ *
+ * The language of each paragraph is detected in the background, and its
+ * words are checked with the dictionary that recognizes most of them.
+ */
+void
+editor_text_buffer_spell_adapter_set_extra_languages (EditorTextBufferSpellAdapter *self,
+                                                      const char * const           *languages)
+{
+  EditorSpellProvider *provider = NULL;
+
+  g_return_if_fail (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self));
+
+  if (languages != NULL && languages[0] == NULL)
+    languages = NULL;
+
+  if (self->extra_languages == NULL && languages == NULL)
+    return;
+
+  if (self->extra_languages != NULL &&
+      languages != NULL &&
+      g_strv_equal ((const char * const *)self->extra_languages, languages))
+    return;
+
+  if (self->extra_checkers != NULL)
+    {
+      for (guint i = 0; i < self->extra_checkers->len; i++)
+        g_signal_handlers_disconnect_by_func (g_ptr_array_index (self->extra_checkers, i),
+                                              G_CALLBACK (editor_text_buffer_spell_adapter_extra_checker_notify_language_cb),
+                                              self);
+      g_clear_pointer (&self->extra_checkers, g_ptr_array_unref);
+    }
+
+  g_strfreev (self->extra_languages);
+  self->extra_languages = g_strdupv ((char **)languages);
+
+  if (self->checker != NULL)
+    provider = editor_spell_checker_get_provider (self->checker);
+
+  if (languages != NULL)
+    {
+      self->extra_checkers = g_ptr_array_new_with_free_func (g_object_unref);
+
+      for (guint i = 0; languages[i]; i++)
+        {
+          EditorSpellChecker *checker = editor_spell_checker_new (provider, languages[i]);
+
+          g_signal_connect_object (checker,
+                                   "notify::language",
+                                   G_CALLBACK (editor_text_buffer_spell_adapter_extra_checker_notify_language_cb),
+                                   self,
+                                   G_CONNECT_SWAPPED);
+          g_ptr_array_add (self->extra_checkers, checker);
+        }
+    }
+
+  editor_text_buffer_spell_adapter_reset_languages (self);
+  editor_text_buffer_spell_adapter_invalidate_all (self);
+
+  g_object_notify_by_pspec (G_OBJECT (self), properties [PROP_EXTRA_LANGUAGES]);
+}
+
+/**
+ * editor_text_buffer_spell_adapter_get_checker_at:
+ * @self: an #EditorTextBufferSpellAdapter
+ * @offset: a character offset within the buffer
+ *
+ * Gets the checker for the paragraph containing @offset, which is
+ * #EditorTextBufferSpellAdapter:checker unless another language was
+ * detected for it. Use this for corrections to a misspelled word.
+ *
+ * Returns: (transfer none) (nullable): an #EditorSpellChecker
+ */
+EditorSpellChecker *
+editor_text_buffer_spell_adapter_get_checker_at (EditorTextBufferSpellAdapter *self,
+                                                 guint                         offset)
+{
+  LanguageRun run;
+
+  g_return_val_if_fail (EDITOR_IS_TEXT_BUFFER_SPELL_ADAPTER (self), NULL);
+
+  if (!has_extra_languages (self))
+    return self->checker;
+
+  get_language_run (self, offset, &run);
+
+  return get_checker_for_language (self, run.data);
+}
+
 GtkTextTag *
 editor_text_buffer_spell_adapter_get_tag (EditorTextBufferSpellAdapter *self)
 {
@@ -57,6 +57,14 @@ const char         *editor_text_buffer_spell_adapter_get_language        (Editor
 void                editor_text_buffer_spell_adapter_set_language        (EditorTextBufferSpellAdapter *self,
                                                                           const char                   *language);
 void                editor_text_buffer_spell_adapter_invalidate_all      (EditorTextBufferSpellAdapter *self);
+void                editor_text_buffer_spell_adapter_invalidate_range    (EditorTextBufferSpellAdapter *self,
+                                                                          guint                         offset,
+                                                                          guint                         len);
 GtkTextTag         *editor_text_buffer_spell_adapter_get_tag             (EditorTextBufferSpellAdapter *self);
+const char * const *editor_text_buffer_spell_adapter_get_extra_languages (EditorTextBufferSpellAdapter *self);
+void                editor_text_buffer_spell_adapter_set_extra_languages (EditorTextBufferSpellAdapter *self,
+                                                                          const char * const           *languages);
+EditorSpellChecker *editor_text_buffer_spell_adapter_get_checker_at      (EditorTextBufferSpellAdapter *self,
+                                                                          guint                         offset);
 
 G_END_DECLS
@@ -0,0 +1,39 @@
+/* editor-trace-private.h
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+void     _editor_trace_init         (void);
+void     _editor_trace_set_filename (const char *filename);
+gboolean _editor_trace_is_enabled   (void);
+void     _editor_trace_mark         (const char *category,
+                                     const char *name,
+                                     gint64      begin_time,
+                                     gint64      end_time,
+                                     const char *detail);
+void     _editor_trace_instant      (const char *category,
+                                     const char *name);
+void     _editor_trace_write        (void);
+
+G_END_DECLS
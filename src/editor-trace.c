@@ -0,0 +1,263 @@
+/* editor-trace.c
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "editor-trace"
+
+#include "config.h"
+
+#include <unistd.h>
+
+#include "editor-trace-private.h"
+
+/*
+ * Tracing is enabled with the EDITOR_TRACE environment variable or the
+ * --trace command line option, both of which take the filename to write
+ * to when the application shuts down.
+ *
+ * Marks are recorded with monotonic timestamps and written using the
+ * Chrome trace event format so that the result can be opened with
+ * chrome://tracing or Perfetto. Tracing is only used from the main
+ * thread, so no locking is performed.
+ *
+ * Marks are kept in memory until then, so at most MAX_TRACE_MARKS are
+ * recorded and the rest are only counted.
+ */
+
+#define MAX_TRACE_MARKS 100000
+
+typedef struct
+{
+  const char *category;
+  const char *name;
+  char       *detail;
+  gint64      begin_time;
+  gint64      end_time;
+  guint       instant : 1;
+} Mark;
+
+static char   *trace_filename;
+static GArray *trace_marks;
+static guint   n_dropped_marks;
+static gint64  process_begin_time;
+
+static void
+clear_mark (Mark *mark)
+{
+  g_clear_pointer (&mark->detail, g_free);
+}
+
+static void
+editor_trace_add (const char *category,
+                  const char *name,
+                  gint64      begin_time,
+                  gint64      end_time,
+                  const char *detail,
+                  gboolean    instant)
+{
+  Mark mark;
+
+  g_assert (category != NULL);
+  g_assert (name != NULL);
+
+  if (trace_marks == NULL)
+    {
+      trace_marks = g_array_new (FALSE, FALSE, sizeof (Mark));
+      g_array_set_clear_func (trace_marks, (GDestroyNotify) clear_mark);
+    }
+
+  if (trace_marks->len >= MAX_TRACE_MARKS)
+    {
+      n_dropped_marks++;
+      return;
+    }
+
+  mark.category = g_intern_string (category);
+  mark.name = g_intern_string (name);
+  mark.detail = g_strdup (detail);
+  mark.begin_time = begin_time;
+  mark.end_time = MAX (begin_time, end_time);
+  mark.instant = !!instant;
+
+  g_array_append_val (trace_marks, mark);
+}
+
+/**
+ * _editor_trace_init:
+ *
+ * Records the time at which the process started. This should be called
+ * as early as possible from main().
+ */
+void
+_editor_trace_init (void)
+{
+  const char *filename;
+
+  process_begin_time = g_get_monotonic_time ();
+
+  if ((filename = g_getenv ("EDITOR_TRACE")) && filename[0])
+    _editor_trace_set_filename (filename);
+}
+
+/**
+ * _editor_trace_set_filename:
+ * @filename: the file to write the trace to
+ *
+ * Enables tracing. Everything that happened since _editor_trace_init()
+ * is recorded as a single mark as it was not traced in detail.
+ */
+void
+_editor_trace_set_filename (const char *filename)
+{
+  g_return_if_fail (filename != NULL);
+
+  if (trace_filename == NULL && process_begin_time != 0)
+    editor_trace_add ("startup", "Process started", process_begin_time, g_get_monotonic_time (), NULL, FALSE);
+
+  g_free (trace_filename);
+  trace_filename = g_strdup (filename);
+}
+
+gboolean
+_editor_trace_is_enabled (void)
+{
+  return trace_filename != NULL;
+}
+
+/**
+ * _editor_trace_mark:
+ * @category: the category of the mark such as "startup"
+ * @name: the name of the mark
+ * @begin_time: the monotonic time at which the operation began
+ * @end_time: the monotonic time at which the operation completed
+ * @detail: (nullable): additional information such as a URI
+ *
+ * Records a mark if tracing is enabled.
+ */
+void
+_editor_trace_mark (const char *category,
+                    const char *name,
+                    gint64      begin_time,
+                    gint64      end_time,
+                    const char *detail)
+{
+  if (trace_filename != NULL)
+    editor_trace_add (category, name, begin_time, end_time, detail, FALSE);
+}
+
+/**
+ * _editor_trace_instant:
+ * @category: the category of the milestone
+ * @name: the name of the milestone
+ *
+ * Records that a milestone, such as the first frame, was reached now.
+ */
+void
+_editor_trace_instant (const char *category,
+                       const char *name)
+{
+  if (trace_filename != NULL)
+    {
+      gint64 now = g_get_monotonic_time ();
+      editor_trace_add (category, name, now, now, NULL, TRUE);
+    }
+}
+
+static void
+append_json_string (GString    *str,
+                    const char *value)
+{
+  g_string_append_c (str, '"');
+
+  for (const char *c = value; *c; c++)
+    {
+      if (*c == '"' || *c == '\\')
+        g_string_append_printf (str, "\\%c", *c);
+      else if ((guchar)*c < 0x20)
+        g_string_append_printf (str, "\\u%04x", (guchar)*c);
+      else
+        g_string_append_c (str, *c);
+    }
+
+  g_string_append_c (str, '"');
+}
+
+/**
+ * _editor_trace_write:
+ *
+ * Writes the recorded marks to the trace file, if tracing is enabled.
+ */
+void
+_editor_trace_write (void)
+{
+  g_autoptr(GString) str = NULL;
+  g_autoptr(GError) error = NULL;
+  int pid;
+
+  if (trace_filename == NULL)
+    return;
+
+  pid = getpid ();
+  str = g_string_new ("{\"traceEvents\":[\n");
+
+  for (guint i = 0; trace_marks != NULL && i < trace_marks->len; i++)
+    {
+      const Mark *mark = &g_array_index (trace_marks, Mark, i);
+
+      if (i > 0)
+        g_string_append (str, ",\n");
+
+      g_string_append (str, "{\"name\":");
+      append_json_string (str, mark->name);
+      g_string_append (str, ",\"cat\":");
+      append_json_string (str, mark->category);
+
+      if (mark->instant)
+        g_string_append_printf (str,
+                                ",\"ph\":\"i\",\"s\":\"p\",\"ts\":%"G_GINT64_FORMAT,
+                                mark->begin_time);
+      else
+        g_string_append_printf (str,
+                                ",\"ph\":\"X\",\"ts\":%"G_GINT64_FORMAT",\"dur\":%"G_GINT64_FORMAT,
+                                mark->begin_time,
+                                mark->end_time - mark->begin_time);
+
+      g_string_append_printf (str, ",\"pid\":%d,\"tid\":%d", pid, pid);
+
+      if (mark->detail != NULL)
+        {
+          g_string_append (str, ",\"args\":{\"detail\":");
+          append_json_string (str, mark->detail);
+          g_string_append_c (str, '}');
+        }
+
+      g_string_append_c (str, '}');
+    }
+
+  g_string_append (str, "\n]}\n");
+
+  if (n_dropped_marks > 0)
+    g_warning ("Trace was truncated, %u marks were dropped", n_dropped_marks);
+
+  if (!g_file_set_contents (trace_filename, str->str, str->len, &error))
+    g_warning ("Failed to write trace to \"%s\": %s", trace_filename, error->message);
+
+  g_clear_pointer (&trace_marks, g_array_unref);
+  n_dropped_marks = 0;
+}
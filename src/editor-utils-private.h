@@ -49,11 +49,20 @@ gboolean                 _editor_gchararray_to_style_scheme     (GBinding
                                                                  GValue                     *to_value,
                                                                  gpointer                    user_data);
 char                    *_editor_date_time_format               (GDateTime                  *self);
+guint                    _editor_date_time_get_bucket           (GDateTime                  *self,
+                                                                 GDateTime                  *now);
+char                    *_editor_date_time_format_bucket        (GDateTime                  *self,
+                                                                 guint                       bucket);
 void                     _editor_file_chooser_add_encodings     (GtkFileChooser             *chooser);
 void                     _editor_file_chooser_add_line_endings  (GtkFileChooser             *chooser,
                                                                  GtkSourceNewlineType        selected);
 const GtkSourceEncoding *_editor_file_chooser_get_encoding      (GtkFileChooser             *chooser);
 GtkSourceNewlineType     _editor_file_chooser_get_line_ending   (GtkFileChooser             *chooser);
 void                     _editor_revealer_auto_hide             (GtkRevealer                *revealer);
+guint64                  _editor_fuzzy_mask                     (const char                 *str);
+GSource                 *_editor_ready_time_source_new          (const char                 *name,
+                                                                 gint                        priority,
+                                                                 GSourceFunc                 callback,
+                                                                 gpointer                    user_data);
 
 G_END_DECLS
@@ -321,12 +321,57 @@ _editor_gboolean_to_wrap_mode (GBinding     *binding,
   return TRUE;
 }
 
-gchar *
-_editor_date_time_format (GDateTime *self)
+/*
+ * Buckets used by _editor_date_time_format(). A bucket, together with the
+ * GDateTime it was computed for, fully determines the formatted string so
+ * callers may cache the result until the bucket changes.
+ */
+enum {
+  BUCKET_FUTURE,
+  BUCKET_JUST_NOW,
+  BUCKET_AN_HOUR_AGO,
+  BUCKET_YESTERDAY,
+  BUCKET_WEEKDAY,
+  BUCKET_MONTH,
+  BUCKET_ABOUT_A_YEAR_AGO,
+  BUCKET_YEARS,
+};
+
+guint
+_editor_date_time_get_bucket (GDateTime *self,
+                              GDateTime *now)
 {
-  g_autoptr(GDateTime) now = NULL;
   GTimeSpan diff;
-  gint years;
+
+  g_return_val_if_fail (self != NULL, BUCKET_FUTURE);
+  g_return_val_if_fail (now != NULL, BUCKET_FUTURE);
+
+  diff = g_date_time_difference (now, self) / G_USEC_PER_SEC;
+
+  if (diff < 0)
+    return BUCKET_FUTURE;
+  else if (diff < (60 * 45))
+    return BUCKET_JUST_NOW;
+  else if (diff < (60 * 90))
+    return BUCKET_AN_HOUR_AGO;
+  else if (diff < (60 * 60 * 24 * 2))
+    return BUCKET_YESTERDAY;
+  else if (diff < (60 * 60 * 24 * 7))
+    return BUCKET_WEEKDAY;
+  else if (diff < (60 * 60 * 24 * 365))
+    return BUCKET_MONTH;
+  else if (diff < (60 * 60 * 24 * 365 * 1.5))
+    return BUCKET_ABOUT_A_YEAR_AGO;
+
+  /* Encode the number of years so that the bucket changes with the label */
+  return BUCKET_YEARS + MAX (2, diff / (60 * 60 * 24 * 365));
+}
+
+gchar *
+_editor_date_time_format_bucket (GDateTime *self,
+                                 guint      bucket)
+{
+  guint years;
 
   /*
    * TODO:
@@ -337,27 +382,80 @@ _editor_date_time_format (GDateTime *self)
 
   g_return_val_if_fail (self != NULL, NULL);
 
+  switch (bucket)
+    {
+    case BUCKET_FUTURE:
+      return g_strdup ("");
+
+    case BUCKET_JUST_NOW:
+      return g_strdup (_("Just now"));
+
+    case BUCKET_AN_HOUR_AGO:
+      return g_strdup (_("An hour ago"));
+
+    case BUCKET_YESTERDAY:
+      return g_strdup (_("Yesterday"));
+
+    case BUCKET_WEEKDAY:
+      return g_date_time_format (self, "%A");
+
+    case BUCKET_MONTH:
+      return g_date_time_format (self, "%OB");
+
+    case BUCKET_ABOUT_A_YEAR_AGO:
+      return g_strdup (_("About a year ago"));
+
+    default:
+      g_assert (bucket > BUCKET_YEARS);
+      years = bucket - BUCKET_YEARS;
+      return g_strdup_printf (ngettext ("About %u year ago", "About %u years ago", years), years);
+    }
+}
+
+gchar *
+_editor_date_time_format (GDateTime *self)
+{
+  g_autoptr(GDateTime) now = NULL;
+
+  g_return_val_if_fail (self != NULL, NULL);
+
   now = g_date_time_new_now_utc ();
-  diff = g_date_time_difference (now, self) / G_USEC_PER_SEC;
 
-  if (diff < 0)
-    return g_strdup ("");
-  else if (diff < (60 * 45))
-    return g_strdup (_("Just now"));
-  else if (diff < (60 * 90))
-    return g_strdup (_("An hour ago"));
-  else if (diff < (60 * 60 * 24 * 2))
-    return g_strdup (_("Yesterday"));
-  else if (diff < (60 * 60 * 24 * 7))
-    return g_date_time_format (self, "%A");
-  else if (diff < (60 * 60 * 24 * 365))
-    return g_date_time_format (self, "%OB");
-  else if (diff < (60 * 60 * 24 * 365 * 1.5))
-    return g_strdup (_("About a year ago"));
+  return _editor_date_time_format_bucket (self, _editor_date_time_get_bucket (self, now));
+}
 
-  years = MAX (2, diff / (60 * 60 * 24 * 365));
+/**
+ * _editor_fuzzy_mask:
+ * @str: a casefolded UTF-8 string
+ *
+ * Creates a bitmap of the characters found in @str. If the mask of a
+ * needle is not a subset of the mask of a haystack, the needle cannot
+ * fuzzy match the haystack, which makes this a cheap prefilter before
+ * calling gtk_source_completion_fuzzy_match().
+ *
+ * Returns: a bitmap of characters within @str
+ */
+guint64
+_editor_fuzzy_mask (const char *str)
+{
+  guint64 mask = 0;
+
+  if (str == NULL)
+    return 0;
+
+  for (const char *iter = str; *iter; iter = g_utf8_next_char (iter))
+    {
+      gunichar ch = g_utf8_get_char (iter);
+
+      if (ch >= 'a' && ch <= 'z')
+        mask |= G_GUINT64_CONSTANT (1) << (ch - 'a');
+      else if (ch >= '0' && ch <= '9')
+        mask |= G_GUINT64_CONSTANT (1) << (26 + ch - '0');
+      else
+        mask |= G_GUINT64_CONSTANT (1) << (36 + ch % 28);
+    }
 
-  return g_strdup_printf (ngettext ("About %u year ago", "About %u years ago", years), years);
+  return mask;
 }
 
 static const struct {
@@ -560,3 +658,57 @@ _editor_revealer_auto_hide (GtkRevealer *revealer)
                     NULL);
   revealer_queue_autohide (revealer);
 }
+
+static gboolean
+ready_time_source_dispatch (GSource     *source,
+                            GSourceFunc  callback,
+                            gpointer     user_data)
+{
+  /* Disarm before calling back so the callback may re-arm */
+  g_source_set_ready_time (source, -1);
+
+  if (callback != NULL)
+    callback (user_data);
+
+  return G_SOURCE_CONTINUE;
+}
+
+static GSourceFuncs ready_time_source_funcs = {
+  .dispatch = ready_time_source_dispatch,
+};
+
+/**
+ * _editor_ready_time_source_new:
+ * @name: a name for the source
+ * @priority: the priority for the source
+ * @callback: the callback to run when the source is ready
+ * @user_data: closure data for @callback
+ *
+ * Creates a source attached to the default main context which only runs
+ * @callback after it has been armed with g_source_set_ready_time(). It
+ * is disarmed again before each dispatch.
+ *
+ * This is useful to debounce frequent events without creating a new
+ * #GSource for each one. Destroy the source with g_source_destroy() and
+ * release it with g_source_unref() once done.
+ *
+ * Returns: (transfer full): a #GSource
+ */
+GSource *
+_editor_ready_time_source_new (const char  *name,
+                               gint         priority,
+                               GSourceFunc  callback,
+                               gpointer     user_data)
+{
+  GSource *source;
+
+  g_return_val_if_fail (callback != NULL, NULL);
+
+  source = g_source_new (&ready_time_source_funcs, sizeof (GSource));
+  g_source_set_name (source, name);
+  g_source_set_priority (source, priority);
+  g_source_set_callback (source, callback, user_data, NULL);
+  g_source_attach (source, NULL);
+
+  return source;
+}
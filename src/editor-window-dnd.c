@@ -22,7 +22,7 @@
 
 #include "config.h"
 
-#include "editor-session.h"
+#include "editor-session-private.h"
 #include "editor-window-private.h"
 
 static gboolean
@@ -39,13 +39,16 @@ editor_window_drop_target_drop (EditorWindow  *self,
     {
       EditorSession *session = editor_application_get_session (EDITOR_APPLICATION_DEFAULT);
       GSList *list = g_value_get_boxed (value);
+      g_autoptr(GPtrArray) files = g_ptr_array_new ();
 
       for (const GSList *iter = list; iter; iter = iter->next)
         {
           GFile *file = iter->data;
           g_assert (G_IS_FILE (file));
-          editor_session_open (session, self, file, NULL);
+          g_ptr_array_add (files, file);
         }
+
+      _editor_session_open_files (session, self, (GFile **)files->pdata, files->len);
     }
 
   return FALSE;
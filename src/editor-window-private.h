@@ -77,7 +77,8 @@ void          _editor_window_dnd_init             (EditorWindow      *self);
 EditorWindow *_editor_window_new                  (void);
 GList        *_editor_window_get_pages            (EditorWindow      *self);
 void          _editor_window_add_page             (EditorWindow      *self,
-                                                   EditorPage        *page);
+                                                   EditorPage        *page,
+                                                   gboolean           select);
 void          _editor_window_remove_page          (EditorWindow      *self,
                                                    EditorPage        *page);
 void          _editor_window_focus_search         (EditorWindow      *self);
@@ -34,6 +34,7 @@
 #include "editor-save-changes-dialog-private.h"
 #include "editor-session-private.h"
 #include "editor-theme-selector-private.h"
+#include "editor-trace-private.h"
 #include "editor-utils-private.h"
 #include "editor-window-private.h"
 
@@ -98,16 +99,17 @@ update_language_name_cb (EditorWindow *self)
 }
 
 static void
-editor_window_cursor_moved_cb (EditorWindow   *self,
-                               EditorDocument *document)
+editor_window_cursor_changed_cb (EditorWindow               *self,
+                                 const EditorDocumentCursor *cursor,
+                                 EditorDocument             *document)
 {
   EditorPage *page;
-  guint line;
   guint column;
 
   g_assert (EDITOR_IS_WINDOW (self));
   g_assert (self->position_label != NULL);
   g_assert (EDITOR_IS_POSITION_LABEL (self->position_label));
+  g_assert (cursor != NULL);
   g_assert (EDITOR_IS_DOCUMENT (document));
 
   if (!(page = editor_window_get_visible_page (self)))
@@ -119,6 +121,23 @@ editor_window_cursor_moved_cb (EditorWindow   *self,
   if (editor_page_get_document (page) != document)
     return;
 
+  editor_page_get_visual_position (page, NULL, &column);
+  _editor_position_label_set_position (self->position_label, cursor->line + 1, column + 1);
+}
+
+static void
+editor_window_update_position (EditorWindow *self)
+{
+  EditorPage *page;
+  guint line;
+  guint column;
+
+  g_assert (EDITOR_IS_WINDOW (self));
+
+  if (!(page = editor_window_get_visible_page (self)) ||
+      editor_document_get_busy (editor_page_get_document (page)))
+    return;
+
   editor_page_get_visual_position (page, &line, &column);
   _editor_position_label_set_position (self->position_label, line + 1, column + 1);
 }
@@ -137,7 +156,7 @@ editor_window_page_bind_cb (EditorWindow      *self,
   document = editor_page_get_document (page);
 
   editor_signal_group_set_target (self->document_signals, document);
-  editor_window_cursor_moved_cb (self, document);
+  editor_window_update_position (self);
 
   _editor_window_actions_update (self, page);
 
@@ -705,6 +724,41 @@ editor_window_set_property (GObject      *object,
     }
 }
 
+static void
+editor_window_after_paint_cb (EditorWindow  *self,
+                              GdkFrameClock *frame_clock)
+{
+  g_assert (EDITOR_IS_WINDOW (self));
+  g_assert (GDK_IS_FRAME_CLOCK (frame_clock));
+
+  _editor_trace_instant ("startup", "First frame");
+
+  g_signal_handlers_disconnect_by_func (frame_clock,
+                                        G_CALLBACK (editor_window_after_paint_cb),
+                                        self);
+}
+
+static void
+editor_window_map (GtkWidget *widget)
+{
+  static gboolean traced_first_frame;
+
+  g_assert (EDITOR_IS_WINDOW (widget));
+
+  GTK_WIDGET_CLASS (editor_window_parent_class)->map (widget);
+
+  if (!traced_first_frame && _editor_trace_is_enabled ())
+    {
+      traced_first_frame = TRUE;
+      _editor_trace_instant ("startup", "First window mapped");
+      g_signal_connect_object (gtk_widget_get_frame_clock (widget),
+                               "after-paint",
+                               G_CALLBACK (editor_window_after_paint_cb),
+                               widget,
+                               G_CONNECT_SWAPPED);
+    }
+}
+
 static void
 editor_window_class_init (EditorWindowClass *klass)
 {
@@ -718,6 +772,8 @@ editor_window_class_init (EditorWindowClass *klass)
   object_class->get_property = editor_window_get_property;
   object_class->set_property = editor_window_set_property;
 
+  widget_class->map = editor_window_map;
+
   window_class->close_request = editor_window_close_request;
 
   properties [PROP_VISIBLE_PAGE] =
@@ -859,8 +915,8 @@ editor_window_init (EditorWindow *self)
   self->document_signals = editor_signal_group_new (EDITOR_TYPE_DOCUMENT);
 
   editor_signal_group_connect_object (self->document_signals,
-                                      "cursor-moved",
-                                      G_CALLBACK (editor_window_cursor_moved_cb),
+                                      "cursor-changed",
+                                      G_CALLBACK (editor_window_cursor_changed_cb),
                                       self,
                                       G_CONNECT_SWAPPED);
 
@@ -928,7 +984,8 @@ modified_to_icon (GBinding     *binding,
 
 void
 _editor_window_add_page (EditorWindow *self,
-                         EditorPage   *page)
+                         EditorPage   *page,
+                         gboolean      select)
 {
   AdwTabPage *tab_page;
 
@@ -945,7 +1002,8 @@ _editor_window_add_page (EditorWindow *self,
                                modified_to_icon, NULL,
                                NULL, NULL);
 
-  adw_tab_view_set_selected_page (self->tab_view, tab_page);
+  if (select)
+    adw_tab_view_set_selected_page (self->tab_view, tab_page);
 }
 
 void
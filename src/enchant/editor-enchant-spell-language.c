@@ -30,6 +30,13 @@ struct _EditorEnchantSpellLanguage
   PangoLanguage *language;
   EnchantDict *native;
   char *extra_word_chars;
+
+  /* Dictionaries are not thread-safe and words are checked and
+   * corrected from worker threads too, so all access to @native goes
+   * through this lock. Suggestions share the dictionary used to check
+   * words so that they include words added or ignored by the user.
+   */
+  GMutex mutex;
 };
 
 G_DEFINE_TYPE (EditorEnchantSpellLanguage, editor_enchant_spell_language, EDITOR_TYPE_SPELL_LANGUAGE)
@@ -65,12 +72,17 @@ editor_enchant_spell_language_contains_word (EditorSpellLanguage *language,
                                              gssize               word_len)
 {
   EditorEnchantSpellLanguage *self = (EditorEnchantSpellLanguage *)language;
+  gboolean ret;
 
   g_assert (EDITOR_IS_ENCHANT_SPELL_LANGUAGE (self));
   g_assert (word != NULL);
   g_assert (word_len > 0);
 
-  return enchant_dict_check (self->native, word, word_len) == 0;
+  g_mutex_lock (&self->mutex);
+  ret = enchant_dict_check (self->native, word, word_len) == 0;
+  g_mutex_unlock (&self->mutex);
+
+  return ret;
 }
 
 static char **
@@ -87,11 +99,13 @@ editor_enchant_spell_language_list_corrections (EditorSpellLanguage *language,
   g_assert (word != NULL);
   g_assert (word_len > 0);
 
+  g_mutex_lock (&self->mutex);
   if ((tmp = enchant_dict_suggest (self->native, word, word_len, &count)) && count > 0)
     {
       ret = g_strdupv (tmp);
       enchant_dict_free_string_list (self->native, tmp);
     }
+  g_mutex_unlock (&self->mutex);
 
   return g_steal_pointer (&ret);
 }
@@ -147,8 +161,10 @@ editor_enchant_spell_language_add_all_to_session (EditorEnchantSpellLanguage *se
   if (words == NULL || words[0] == NULL)
     return;
 
+  g_mutex_lock (&self->mutex);
   for (guint i = 0; words[i]; i++)
     enchant_dict_add_to_session (self->native, words[i], -1);
+  g_mutex_unlock (&self->mutex);
 }
 
 static void
@@ -160,7 +176,9 @@ editor_enchant_spell_language_add_word (EditorSpellLanguage *language,
   g_assert (EDITOR_IS_SPELL_LANGUAGE (language));
   g_assert (word != NULL);
 
+  g_mutex_lock (&self->mutex);
   enchant_dict_add (self->native, word, -1);
+  g_mutex_unlock (&self->mutex);
 }
 
 static void
@@ -172,7 +190,9 @@ editor_enchant_spell_language_ignore_word (EditorSpellLanguage *language,
   g_assert (EDITOR_IS_SPELL_LANGUAGE (language));
   g_assert (word != NULL);
 
+  g_mutex_lock (&self->mutex);
   enchant_dict_add_to_session (self->native, word, -1);
+  g_mutex_unlock (&self->mutex);
 }
 
 static const char *
@@ -225,6 +245,8 @@ editor_enchant_spell_language_finalize (GObject *object)
   /* Owned by provider */
   self->native = NULL;
 
+  g_mutex_clear (&self->mutex);
+
   G_OBJECT_CLASS (editor_enchant_spell_language_parent_class)->finalize (object);
 }
 
@@ -295,6 +317,7 @@ editor_enchant_spell_language_class_init (EditorEnchantSpellLanguageClass *klass
 static void
 editor_enchant_spell_language_init (EditorEnchantSpellLanguage *self)
 {
+  g_mutex_init (&self->mutex);
 }
 
 gpointer
@@ -37,7 +37,13 @@ struct _EditorEnchantSpellProvider
 
 G_DEFINE_TYPE (EditorEnchantSpellProvider, editor_enchant_spell_provider, EDITOR_TYPE_SPELL_PROVIDER)
 
+/* Languages are loaded from worker threads while the main thread checks
+ * words, so the broker and everything cached below is protected by @lock.
+ */
+G_LOCK_DEFINE_STATIC (lock);
 static GHashTable *languages;
+static GHashTable *supported;
+static GPtrArray *language_infos;
 
 static EnchantBroker *
 get_broker (void)
@@ -97,10 +103,30 @@ static gboolean
 editor_enchant_spell_provider_supports_language (EditorSpellProvider *provider,
                                                  const char          *language)
 {
+  gpointer value;
+  gboolean ret;
+
   g_assert (EDITOR_IS_ENCHANT_SPELL_PROVIDER (provider));
   g_assert (language != NULL);
 
-  return enchant_broker_dict_exists (get_broker (), language);
+  G_LOCK (lock);
+
+  if (supported == NULL)
+    supported = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  if (g_hash_table_lookup_extended (supported, language, NULL, &value))
+    {
+      ret = GPOINTER_TO_INT (value);
+    }
+  else
+    {
+      ret = enchant_broker_dict_exists (get_broker (), language);
+      g_hash_table_insert (supported, g_strdup (language), GINT_TO_POINTER (ret));
+    }
+
+  G_UNLOCK (lock);
+
+  return ret;
 }
 
 static void
@@ -119,9 +145,22 @@ list_languages_cb (const char * const  lang_tag,
 static GPtrArray *
 editor_enchant_spell_provider_list_languages (EditorSpellProvider *provider)
 {
-  EnchantBroker *broker = get_broker ();
-  GPtrArray *ar = g_ptr_array_new_with_free_func (g_object_unref);
-  enchant_broker_list_dicts (broker, list_languages_cb, ar);
+  GPtrArray *ar;
+
+  G_LOCK (lock);
+
+  if (language_infos == NULL)
+    {
+      language_infos = g_ptr_array_new_with_free_func (g_object_unref);
+      enchant_broker_list_dicts (get_broker (), list_languages_cb, language_infos);
+    }
+
+  ar = g_ptr_array_new_full (language_infos->len, g_object_unref);
+  for (guint i = 0; i < language_infos->len; i++)
+    g_ptr_array_add (ar, g_object_ref (g_ptr_array_index (language_infos, i)));
+
+  G_UNLOCK (lock);
+
   return ar;
 }
 
@@ -134,6 +173,8 @@ editor_enchant_spell_provider_get_language (EditorSpellProvider *provider,
   g_assert (EDITOR_IS_ENCHANT_SPELL_PROVIDER (provider));
   g_assert (language != NULL);
 
+  G_LOCK (lock);
+
   if (languages == NULL)
     languages = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
 
@@ -141,14 +182,19 @@ editor_enchant_spell_provider_get_language (EditorSpellProvider *provider,
     {
       EnchantDict *dict = enchant_broker_request_dict (get_broker (), language);
 
-      if (dict == NULL)
-        return NULL;
-
-      ret = editor_enchant_spell_language_new (language, dict);
-      g_hash_table_insert (languages, (char *)g_intern_string (language), ret);
+      if (dict != NULL)
+        {
+          ret = editor_enchant_spell_language_new (language, dict);
+          g_hash_table_insert (languages, (char *)g_intern_string (language), ret);
+        }
     }
 
-  return ret ? g_object_ref (ret) : NULL;
+  if (ret != NULL)
+    g_object_ref (ret);
+
+  G_UNLOCK (lock);
+
+  return ret;
 }
 
 static void
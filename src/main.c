@@ -23,21 +23,41 @@
 #include <glib/gi18n.h>
 
 #include "editor-application-private.h"
+#include "editor-export-private.h"
+#include "editor-trace-private.h"
 
 int
 main (int   argc,
       char *argv[])
 {
   g_autoptr(EditorApplication) app = NULL;
+  gint64 begin_time;
   int ret;
 
+  _editor_trace_init ();
+  begin_time = g_get_monotonic_time ();
+
   bindtextdomain (GETTEXT_PACKAGE, LOCALEDIR);
   bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
   textdomain (GETTEXT_PACKAGE);
 
+  /* Exporting does not create any windows and may be used from scripts
+   * without a display, so skip the application entirely.
+   */
+  if (_editor_export_requested (argc, argv))
+    {
+      gtk_init_check ();
+      gtk_source_init ();
+      ret = _editor_export_main (argc, argv);
+      gtk_source_finalize ();
+      return ret;
+    }
+
   gtk_init ();
   gtk_source_init ();
 
+  _editor_trace_mark ("startup", "Toolkit initialization", begin_time, g_get_monotonic_time (), NULL);
+
   app = _editor_application_new ();
   ret = g_application_run (G_APPLICATION (app), argc, argv);
 
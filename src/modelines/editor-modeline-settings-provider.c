@@ -22,7 +22,7 @@
 
 #include "config.h"
 
-#include "editor-document.h"
+#include "editor-document-private.h"
 #include "editor-modeline-settings-provider-private.h"
 
 #include "modeline-parser.h"
@@ -48,6 +48,7 @@ struct _EditorModelineSettingsProvider
   guint           show_right_margin_set : 1;
   guint           insert_spaces_instead_of_tabs : 1;
   guint           insert_spaces_instead_of_tabs_set : 1;
+  guint           reload_after_bulk_edit : 1;
 };
 
 static gboolean
@@ -171,6 +172,13 @@ editor_modeline_settings_provider_queue_reload (EditorModelineSettingsProvider *
 {
   g_assert (EDITOR_IS_MODELINE_SETTINGS_PROVIDER (self));
 
+  /* Wait for the user action containing the bulk edit to complete */
+  if (self->document != NULL && _editor_document_get_bulk_editing (self->document))
+    {
+      self->reload_after_bulk_edit = TRUE;
+      return;
+    }
+
   /* This will get called a lot, so to avoid churning GSource on the
    * main context, we instead simply change the ready time of the
    * GSource to be the current monotonic time + 1 second.
@@ -197,6 +205,20 @@ editor_modeline_settings_provider_queue_reload (EditorModelineSettingsProvider *
                                 g_object_unref);
 }
 
+static void
+editor_modeline_settings_provider_end_user_action_cb (EditorModelineSettingsProvider *self,
+                                                      EditorDocument                 *document)
+{
+  g_assert (EDITOR_IS_MODELINE_SETTINGS_PROVIDER (self));
+  g_assert (EDITOR_IS_DOCUMENT (document));
+
+  if (self->reload_after_bulk_edit && !_editor_document_get_bulk_editing (document))
+    {
+      self->reload_after_bulk_edit = FALSE;
+      editor_modeline_settings_provider_queue_reload (self);
+    }
+}
+
 static void
 editor_modeline_settings_provider_set_document (EditorPageSettingsProvider *provider,
                                                 EditorDocument             *document)
@@ -213,6 +235,11 @@ editor_modeline_settings_provider_set_document (EditorPageSettingsProvider *prov
                                G_CALLBACK (editor_modeline_settings_provider_queue_reload),
                                self,
                                G_CONNECT_SWAPPED);
+      g_signal_connect_object (document,
+                               "end-user-action",
+                               G_CALLBACK (editor_modeline_settings_provider_end_user_action_cb),
+                               self,
+                               G_CONNECT_SWAPPED);
       g_clear_handle_id (&self->reload_source, g_source_remove);
       editor_modeline_settings_provider_reload (self);
     }
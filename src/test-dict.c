@@ -0,0 +1,125 @@
+/* test-dict.c
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "dict/editor-dict.c"
+
+static GBytes *
+build_dict (const char * const *words)
+{
+  g_autoptr(GPtrArray) ar = g_ptr_array_new ();
+
+  for (guint i = 0; words[i]; i++)
+    g_ptr_array_add (ar, (char *)words[i]);
+
+  return _editor_dict_build (ar);
+}
+
+static gboolean
+contains (const EditorDict *dict,
+          const char       *word)
+{
+  return _editor_dict_contains (dict, word, strlen (word));
+}
+
+static void
+test_lookup (void)
+{
+  static const char *words[] = {
+    "zebra", "apple", "apples", "app", "banana", "apple", "café", NULL
+  };
+  g_autoptr(GBytes) bytes = build_dict (words);
+  EditorDict dict;
+
+  g_assert_true (_editor_dict_init (&dict, g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes)));
+  g_assert_cmpint (dict.n_words, ==, 6);
+
+  for (guint i = 0; words[i]; i++)
+    g_assert_true (contains (&dict, words[i]));
+
+  g_assert_false (contains (&dict, "ap"));
+  g_assert_false (contains (&dict, "appl"));
+  g_assert_false (contains (&dict, "applesauce"));
+  g_assert_false (contains (&dict, "Apple"));
+  g_assert_false (contains (&dict, "aardvark"));
+  g_assert_false (contains (&dict, "zzz"));
+  g_assert_false (contains (&dict, ""));
+
+  /* Words need not be terminated */
+  g_assert_true (_editor_dict_contains (&dict, "apples", 5));
+}
+
+static void
+test_many_blocks (void)
+{
+  g_autoptr(GPtrArray) words = g_ptr_array_new_with_free_func (g_free);
+  g_autoptr(GBytes) bytes = NULL;
+  EditorDict dict;
+
+  for (guint i = 0; i < 1000; i++)
+    g_ptr_array_add (words, g_strdup_printf ("word%u", i * 2));
+
+  bytes = _editor_dict_build (words);
+  g_assert_true (_editor_dict_init (&dict, g_bytes_get_data (bytes, NULL), g_bytes_get_size (bytes)));
+  g_assert_cmpint (dict.n_blocks, >, 1);
+
+  for (guint i = 0; i < 2000; i++)
+    {
+      g_autofree char *word = g_strdup_printf ("word%u", i);
+      g_assert_cmpint (contains (&dict, word), ==, i % 2 == 0);
+    }
+}
+
+static void
+test_invalid (void)
+{
+  static const char *words[] = { "one", "two", "three", NULL };
+  static const char *empty[] = { NULL };
+  g_autoptr(GBytes) bytes = build_dict (words);
+  g_autoptr(GBytes) empty_bytes = build_dict (empty);
+  const guint8 *data = g_bytes_get_data (bytes, NULL);
+  gsize len = g_bytes_get_size (bytes);
+  EditorDict dict;
+
+  g_assert_false (_editor_dict_init (&dict, NULL, 0));
+  g_assert_false (_editor_dict_init (&dict, (const guint8 *)"EDDICT", 6));
+
+  /* Truncated dictionaries are rejected or fail lookups safely */
+  for (gsize i = 0; i < len; i++)
+    {
+      if (_editor_dict_init (&dict, data, i))
+        contains (&dict, "three");
+    }
+
+  g_assert_true (_editor_dict_init (&dict,
+                                    g_bytes_get_data (empty_bytes, NULL),
+                                    g_bytes_get_size (empty_bytes)));
+  g_assert_false (contains (&dict, "one"));
+}
+
+int
+main (int argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_test_add_func ("/Spell/Dict/lookup", test_lookup);
+  g_test_add_func ("/Spell/Dict/many_blocks", test_many_blocks);
+  g_test_add_func ("/Spell/Dict/invalid", test_invalid);
+  return g_test_run ();
+}
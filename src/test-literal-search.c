@@ -0,0 +1,288 @@
+/* test-literal-search.c
+ *
+ * Copyright 2021 Christian Hergert <chergert@redhat.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <locale.h>
+#include <glib/gi18n.h>
+#include <gtksourceview/gtksource.h>
+
+#include "editor-literal-search.c"
+
+#define BENCH_SIZE   (100 * 1024 * 1024)
+#define BENCH_CHUNK  16384
+
+static guint
+count_matches (const char *needle,
+               gboolean    case_sensitive,
+               const char *haystack)
+{
+  EditorLiteralSearch search;
+  const char *end = haystack + strlen (haystack);
+  guint count = 0;
+
+  g_assert_true (_editor_literal_search_init (&search, needle, case_sensitive));
+
+  for (const char *pos = haystack;
+       (pos = _editor_literal_search_find (&search, pos, end - pos));
+       pos++)
+    count++;
+
+  return count;
+}
+
+static void
+test_case_sensitive (void)
+{
+  const char *text = "the quick brown fox jumps over the lazy dog. The end.";
+  EditorLiteralSearch search;
+  const char *pos;
+
+  g_assert_true (_editor_literal_search_init (&search, "the", TRUE));
+  pos = _editor_literal_search_find (&search, text, strlen (text));
+  g_assert_true (pos == text);
+  pos = _editor_literal_search_find (&search, pos + 1, strlen (pos + 1));
+  g_assert_true (pos == strstr (text, "the lazy"));
+
+  g_assert_cmpint (count_matches ("the", TRUE, text), ==, 2);
+  g_assert_cmpint (count_matches ("The", TRUE, text), ==, 1);
+  g_assert_cmpint (count_matches ("dog.", TRUE, text), ==, 1);
+  g_assert_cmpint (count_matches ("cat", TRUE, text), ==, 0);
+  g_assert_cmpint (count_matches ("end.", TRUE, "end."), ==, 1);
+  g_assert_cmpint (count_matches ("long needle", TRUE, "short"), ==, 0);
+
+  /* Overlapping candidates are all reported */
+  g_assert_cmpint (count_matches ("aa", TRUE, "aaaa"), ==, 3);
+}
+
+static void
+test_case_insensitive (void)
+{
+  const char *text = "The quick brown fox jumps over THE lazy dog. the end.";
+
+  g_assert_cmpint (count_matches ("the", FALSE, text), ==, 3);
+  g_assert_cmpint (count_matches ("THE", FALSE, text), ==, 3);
+  g_assert_cmpint (count_matches ("DOG.", FALSE, text), ==, 1);
+
+  /* Folding must not match bytes which only differ by 0x20 */
+  g_assert_cmpint (count_matches ("@", FALSE, "`@`"), ==, 1);
+  g_assert_cmpint (count_matches ("[", FALSE, "{[{"), ==, 1);
+}
+
+static void
+test_utf8 (void)
+{
+  const char *text = "naïve café, naïve Café, CAFÉ";
+  EditorLiteralSearch search;
+
+  g_assert_cmpint (count_matches ("café", TRUE, text), ==, 1);
+  g_assert_cmpint (count_matches ("naïve", TRUE, text), ==, 2);
+  g_assert_cmpint (count_matches ("caf", FALSE, text), ==, 3);
+
+  /* Non-ASCII needles need unicode case folding */
+  g_assert_false (_editor_literal_search_init (&search, "café", FALSE));
+  g_assert_false (_editor_literal_search_init (&search, "", TRUE));
+}
+
+static void
+test_long_haystack (void)
+{
+  GString *str = g_string_new (NULL);
+
+  /* Cross the 16 byte blocks at every possible alignment */
+  for (guint i = 0; i < 100; i++)
+    {
+      for (guint j = 0; j < i; j++)
+        g_string_append_c (str, 'x');
+      g_string_append (str, "needle");
+    }
+
+  g_assert_cmpint (count_matches ("needle", TRUE, str->str), ==, 100);
+  g_assert_cmpint (count_matches ("NEEDLE", FALSE, str->str), ==, 100);
+  g_assert_cmpint (count_matches ("xneedle", TRUE, str->str), ==, 99);
+
+  g_string_free (str, TRUE);
+}
+
+static GtkTextBuffer *
+create_bench_buffer (void)
+{
+  static const char *line = "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod.\n";
+  GtkTextBuffer *buffer = GTK_TEXT_BUFFER (gtk_source_buffer_new (NULL));
+  GString *str = g_string_sized_new (BENCH_SIZE + 1024);
+  guint n = 0;
+
+  while (str->len < BENCH_SIZE)
+    {
+      if (++n % 1000 == 0)
+        g_string_append (str, "The Needle is here.\n");
+      else
+        g_string_append (str, line);
+    }
+
+  gtk_text_buffer_set_text (buffer, str->str, str->len);
+  g_string_free (str, TRUE);
+
+  return buffer;
+}
+
+static guint
+bench_context (GtkTextBuffer *buffer,
+               const char    *needle,
+               gboolean       case_sensitive)
+{
+  g_autoptr(GtkSourceSearchSettings) settings = gtk_source_search_settings_new ();
+  g_autoptr(GtkSourceSearchContext) context = NULL;
+  GtkTextIter iter, match_begin, match_end;
+  gboolean wrapped = FALSE;
+  guint count = 0;
+
+  gtk_source_search_settings_set_search_text (settings, needle);
+  gtk_source_search_settings_set_case_sensitive (settings, case_sensitive);
+  gtk_source_search_settings_set_wrap_around (settings, FALSE);
+
+  context = gtk_source_search_context_new (GTK_SOURCE_BUFFER (buffer), settings);
+  gtk_source_search_context_set_highlight (context, FALSE);
+
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+
+  while (gtk_source_search_context_forward (context, &iter, &match_begin, &match_end, &wrapped) && !wrapped)
+    {
+      count++;
+      iter = match_end;
+    }
+
+  return count;
+}
+
+static guint
+bench_literal (GtkTextBuffer *buffer,
+               const char    *needle,
+               gboolean       case_sensitive)
+{
+  EditorLiteralSearch search;
+  GtkTextIter begin, end;
+  guint char_count;
+  guint count = 0;
+  guint step;
+
+  g_assert_true (_editor_literal_search_init (&search, needle, case_sensitive));
+
+  /* Scan in overlapping chunks like EditorSearchEngine does. The input
+   * is ASCII, so byte positions within a chunk are character offsets.
+   */
+  char_count = gtk_text_buffer_get_char_count (buffer);
+  step = BENCH_CHUNK - (search.needle_len - 1);
+
+  for (guint offset = 0; offset < char_count; offset += step)
+    {
+      g_autofree char *text = NULL;
+      gboolean is_last = offset + BENCH_CHUNK >= char_count;
+      const char *text_end;
+
+      gtk_text_buffer_get_iter_at_offset (buffer, &begin, offset);
+      gtk_text_buffer_get_iter_at_offset (buffer, &end, offset + BENCH_CHUNK);
+
+      text = gtk_text_iter_get_slice (&begin, &end);
+      text_end = text + strlen (text);
+
+      for (const char *pos = text;
+           (pos = _editor_literal_search_find (&search, pos, text_end - pos));
+           pos += search.needle_len)
+        {
+          /* The next chunk will find this one */
+          if (!is_last && pos - text >= step)
+            break;
+
+          count++;
+        }
+
+      if (is_last)
+        break;
+    }
+
+  return count;
+}
+
+static void
+test_bench (void)
+{
+  static const struct {
+    const char *needle;
+    gboolean    case_sensitive;
+  } queries[] = {
+    { "Needle", TRUE },
+    { "needle", FALSE },
+  };
+  g_autoptr(GtkTextBuffer) buffer = NULL;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("Run with -m perf to benchmark");
+      return;
+    }
+
+  buffer = create_bench_buffer ();
+
+  for (guint i = 0; i < G_N_ELEMENTS (queries); i++)
+    {
+      gdouble context_time;
+      gdouble literal_time;
+      guint context_count;
+      guint literal_count;
+
+      g_test_timer_start ();
+      context_count = bench_context (buffer, queries[i].needle, queries[i].case_sensitive);
+      context_time = g_test_timer_elapsed ();
+
+      g_test_timer_start ();
+      literal_count = bench_literal (buffer, queries[i].needle, queries[i].case_sensitive);
+      literal_time = g_test_timer_elapsed ();
+
+      g_assert_cmpint (context_count, ==, literal_count);
+
+      g_test_message ("\"%s\" (%s): GtkSourceSearchContext %.3lfs, EditorLiteralSearch %.3lfs, %u matches",
+                      queries[i].needle,
+                      queries[i].case_sensitive ? "case-sensitive" : "case-insensitive",
+                      context_time, literal_time, literal_count);
+      g_test_minimized_result (literal_time, "EditorLiteralSearch \"%s\": %.3lfs",
+                               queries[i].needle, literal_time);
+    }
+}
+
+int
+main (int argc,
+      char *argv[])
+{
+  setlocale (LC_ALL, "C");
+  bindtextdomain (GETTEXT_PACKAGE, LOCALEDIR);
+  bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
+  textdomain (GETTEXT_PACKAGE);
+
+  g_test_init (&argc, &argv, NULL);
+
+  if (g_test_perf ())
+    gtk_source_init ();
+
+  g_test_add_func ("/Search/Literal/case_sensitive", test_case_sensitive);
+  g_test_add_func ("/Search/Literal/case_insensitive", test_case_insensitive);
+  g_test_add_func ("/Search/Literal/utf8", test_utf8);
+  g_test_add_func ("/Search/Literal/long_haystack", test_long_haystack);
+  g_test_add_func ("/Search/Literal/bench", test_bench);
+  return g_test_run ();
+}
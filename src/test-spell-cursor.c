@@ -27,8 +27,17 @@
 
 #undef WANT_DISPLAY_TESTS
 
+#define BENCH_SIZE (4 * 1024 * 1024)
+
 static const char *test_text = "this is a series of words";
 static const char *test_text_2 = "it's possible we're going to have join-words.";
+static const char *test_text_4 = "\
+It's 2021-12-01 and we're testing abc123 mixed_case snake-case words.\n\
+Trailing' apostrophes, -leading dashes- and double--dashes aren't joined.\n\
+  indented\tline with\r\n\
+windows line endings and a naïve café line that isn't ASCII\n\
+\n\
+'quoted' words and a last word";
 #ifdef WANT_DISPLAY_TESTS
 static const char *test_text_3 = "\
 /* ide-buffer.c\
@@ -210,6 +219,174 @@ test_cursor_join_words (void)
   _cjh_text_region_free (region);
 }
 
+static void
+test_cursor_no_spell_check (void)
+{
+  static const char *text = "code(\"a string\"); /* a comment */ more_code;";
+  g_autoptr(GtkTextBuffer) buffer = gtk_text_buffer_new (NULL);
+  CjhTextRegion *region = _cjh_text_region_new (NULL, NULL);
+  g_autoptr(EditorSpellCursor) cursor = NULL;
+  GtkTextTag *tag;
+  GtkTextIter begin, end;
+  const char *words[] = { "a", "string", "a", "comment", "code", NULL };
+
+  gtk_text_buffer_set_text (buffer, text, -1);
+  _cjh_text_region_insert (region, 0, strlen (text), NULL);
+
+  /* Tag everything but the string and comment contents, and also
+   * the beginning of "more_code" so that "more" is skipped.
+   */
+  tag = gtk_text_buffer_create_tag (buffer, NULL, NULL);
+  gtk_text_buffer_get_iter_at_offset (buffer, &begin, 0);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, strstr (text, "a string") - text);
+  gtk_text_buffer_apply_tag (buffer, tag, &begin, &end);
+  gtk_text_buffer_get_iter_at_offset (buffer, &begin, strstr (text, "\");") - text);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, strstr (text, "a comment") - text);
+  gtk_text_buffer_apply_tag (buffer, tag, &begin, &end);
+  gtk_text_buffer_get_iter_at_offset (buffer, &begin, strstr (text, " */") - text);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, strstr (text, "ore_code") - text);
+  gtk_text_buffer_apply_tag (buffer, tag, &begin, &end);
+
+  cursor = editor_spell_cursor_new (buffer, region, tag, NULL);
+
+  for (guint i = 0; i < G_N_ELEMENTS (words); i++)
+    {
+      char *word = next_word (cursor);
+      g_assert_cmpstr (word, ==, words[i]);
+      g_free (word);
+    }
+
+  _cjh_text_region_free (region);
+}
+
+static GPtrArray *
+collect_cursor_words (GtkTextBuffer *buffer,
+                      const char    *extra_word_chars)
+{
+  GPtrArray *words = g_ptr_array_new_with_free_func (g_free);
+  CjhTextRegion *region = _cjh_text_region_new (NULL, NULL);
+  g_autoptr(EditorSpellCursor) cursor = NULL;
+  char *word;
+
+  _cjh_text_region_insert (region, 0, gtk_text_buffer_get_char_count (buffer), NULL);
+  cursor = editor_spell_cursor_new (buffer, region, NULL, extra_word_chars);
+
+  while ((word = next_word (cursor)))
+    g_ptr_array_add (words, word);
+
+  _cjh_text_region_free (region);
+
+  return words;
+}
+
+/* The same walk as EditorSpellCursor but always using Pango */
+static GPtrArray *
+collect_pango_words (GtkTextBuffer *buffer,
+                     const char    *extra_word_chars)
+{
+  GPtrArray *words = g_ptr_array_new_with_free_func (g_free);
+  GtkTextIter begin, end;
+
+  gtk_text_buffer_get_start_iter (buffer, &end);
+
+  while (editor_spell_iter_forward_word_end (&end, extra_word_chars))
+    {
+      begin = end;
+
+      if (!editor_spell_iter_backward_word_start (&begin, extra_word_chars))
+        break;
+
+      g_ptr_array_add (words, gtk_text_iter_get_slice (&begin, &end));
+
+      /* The cursor continues one character past the word */
+      gtk_text_iter_forward_char (&end);
+    }
+
+  return words;
+}
+
+static void
+assert_words_equal (GPtrArray *a,
+                    GPtrArray *b)
+{
+  for (guint i = 0; i < MIN (a->len, b->len); i++)
+    g_assert_cmpstr (g_ptr_array_index (a, i), ==, g_ptr_array_index (b, i));
+  g_assert_cmpint (a->len, ==, b->len);
+}
+
+static void
+test_cursor_ascii (void)
+{
+  static const char *extra_word_chars[] = { "", "-'" };
+  g_autoptr(GtkTextBuffer) buffer = gtk_text_buffer_new (NULL);
+  GString *str = g_string_new (NULL);
+
+  gtk_text_buffer_set_text (buffer, test_text_4, -1);
+
+  for (guint i = 0; i < G_N_ELEMENTS (extra_word_chars); i++)
+    {
+      g_autoptr(GPtrArray) cursor_words = collect_cursor_words (buffer, extra_word_chars[i]);
+      g_autoptr(GPtrArray) pango_words = collect_pango_words (buffer, extra_word_chars[i]);
+
+      assert_words_equal (cursor_words, pango_words);
+    }
+
+  /* Lines longer than a segment are looked at through a window */
+  for (guint i = 0; str->len < SEGMENT_MAX_CHARS * 3; i++)
+    g_string_append (str, i % 7 == 0 ? "long-lines' don't break " : "words ");
+  g_string_append (str, "\nsecond line");
+  gtk_text_buffer_set_text (buffer, str->str, str->len);
+  g_string_free (str, TRUE);
+
+  for (guint i = 0; i < G_N_ELEMENTS (extra_word_chars); i++)
+    {
+      g_autoptr(GPtrArray) cursor_words = collect_cursor_words (buffer, extra_word_chars[i]);
+      g_autoptr(GPtrArray) pango_words = collect_pango_words (buffer, extra_word_chars[i]);
+
+      assert_words_equal (cursor_words, pango_words);
+    }
+}
+
+static void
+test_cursor_bench (void)
+{
+  static const char *line = "It's a long established fact that a reader will be distracted by readable content, isn't it?\n";
+  g_autoptr(GtkTextBuffer) buffer = NULL;
+  g_autoptr(GPtrArray) cursor_words = NULL;
+  g_autoptr(GPtrArray) pango_words = NULL;
+  GString *str;
+  gdouble cursor_time;
+  gdouble pango_time;
+
+  if (!g_test_perf ())
+    {
+      g_test_skip ("Run with -m perf to benchmark");
+      return;
+    }
+
+  str = g_string_sized_new (BENCH_SIZE + 1024);
+  while (str->len < BENCH_SIZE)
+    g_string_append (str, line);
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, str->str, str->len);
+  g_string_free (str, TRUE);
+
+  g_test_timer_start ();
+  pango_words = collect_pango_words (buffer, "-'");
+  pango_time = g_test_timer_elapsed ();
+
+  g_test_timer_start ();
+  cursor_words = collect_cursor_words (buffer, "-'");
+  cursor_time = g_test_timer_elapsed ();
+
+  assert_words_equal (cursor_words, pango_words);
+
+  g_test_message ("%u words: Pango %.3lfs, EditorSpellCursor %.3lfs",
+                  cursor_words->len, pango_time, cursor_time);
+  g_test_minimized_result (cursor_time, "EditorSpellCursor: %.3lfs", cursor_time);
+}
+
 int
 main (int argc,
       char *argv[])
@@ -231,5 +408,8 @@ main (int argc,
 #endif
   g_test_add_func ("/Spelling/Cursor/in_word", test_cursor_in_word);
   g_test_add_func ("/Spelling/Cursor/join_words", test_cursor_join_words);
+  g_test_add_func ("/Spelling/Cursor/no_spell_check", test_cursor_no_spell_check);
+  g_test_add_func ("/Spelling/Cursor/ascii", test_cursor_ascii);
+  g_test_add_func ("/Spelling/Cursor/bench", test_cursor_bench);
   return g_test_run ();
 }